@@ -0,0 +1,448 @@
+/*
+ * Copyright © 2011 Benjamin Franzke
+ * Copyright © 2010 Intel Corporation
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that copyright
+ * notice and this permission notice appear in supporting documentation, and
+ * that the name of the copyright holders not be used in advertising or
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.  The copyright holders make no representations
+ * about the suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THIS SOFTWARE.
+ */
+
+/*
+ * Test client of ivi_surface::visibility. It renders continuously while
+ * visible, stops rendering when ivi-shell reports it invisible, and prints
+ * the frame rate every second, e.g.
+ *
+ *   weston-ivi-visibility --id=9100
+ *
+ * Hide the layer or the surface 9100 with a layout controller, or cover it
+ * with an opaque surface, and the frame rate drops to zero until it is
+ * shown again.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <signal.h>
+
+#include <wayland-client.h>
+#include "../shared/os-compatibility.h"
+#include "../ivi-shell/ivi-application-client-protocol.h"
+
+#define IVI_SURFACE_ID 9100
+#define REPORT_INTERVAL_MS 1000
+
+struct display {
+	struct wl_display *display;
+	struct wl_registry *registry;
+	struct wl_compositor *compositor;
+	struct wl_shm *shm;
+	struct ivi_application *ivi_application;
+};
+
+struct buffer {
+	struct wl_buffer *buffer;
+	void *shm_data;
+	int busy;
+};
+
+struct window {
+	struct display *display;
+	int width, height;
+	struct wl_surface *surface;
+	struct ivi_surface *ivi_surface;
+	struct buffer buffers[2];
+	struct wl_callback *callback;
+	int visible;
+	uint32_t frames;
+	uint32_t visibility_events;
+};
+
+static void
+buffer_release(void *data, struct wl_buffer *buffer)
+{
+	struct buffer *mybuf = data;
+
+	mybuf->busy = 0;
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	buffer_release
+};
+
+static int
+create_shm_buffer(struct display *display, struct buffer *buffer,
+		  int width, int height, uint32_t format)
+{
+	struct wl_shm_pool *pool;
+	int fd, size, stride;
+	void *data;
+
+	stride = width * 4;
+	size = stride * height;
+
+	fd = os_create_anonymous_file(size);
+	if (fd < 0) {
+		fprintf(stderr, "creating a buffer file for %d B failed: %m\n",
+			size);
+		return -1;
+	}
+
+	data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "mmap failed: %m\n");
+		close(fd);
+		return -1;
+	}
+
+	pool = wl_shm_create_pool(display->shm, fd, size);
+	buffer->buffer = wl_shm_pool_create_buffer(pool, 0,
+						   width, height,
+						   stride, format);
+	wl_buffer_add_listener(buffer->buffer, &buffer_listener, buffer);
+	wl_shm_pool_destroy(pool);
+	close(fd);
+
+	buffer->shm_data = data;
+
+	return 0;
+}
+
+static struct buffer *
+window_next_buffer(struct window *window)
+{
+	struct buffer *buffer;
+
+	if (!window->buffers[0].busy)
+		buffer = &window->buffers[0];
+	else if (!window->buffers[1].busy)
+		buffer = &window->buffers[1];
+	else
+		return NULL;
+
+	if (!buffer->buffer &&
+	    create_shm_buffer(window->display, buffer,
+			      window->width, window->height,
+			      WL_SHM_FORMAT_XRGB8888) < 0)
+		return NULL;
+
+	return buffer;
+}
+
+static void
+paint_pixels(void *image, int width, int height, uint32_t time)
+{
+	uint32_t *pixel = image;
+	int x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			*pixel++ = 0xff000000 |
+				   (((x + time / 16) & 0xff) << 16) |
+				   (((y + time / 32) & 0xff) << 8);
+}
+
+static const struct wl_callback_listener frame_listener;
+
+static void
+redraw(void *data, struct wl_callback *callback, uint32_t time)
+{
+	struct window *window = data;
+	struct buffer *buffer;
+
+	if (callback) {
+		wl_callback_destroy(callback);
+		window->frames++;
+	}
+	window->callback = NULL;
+
+	/* restarted by visibility event */
+	if (!window->visible)
+		return;
+
+	buffer = window_next_buffer(window);
+	if (!buffer) {
+		fprintf(stderr,
+			!callback ? "Failed to create the first buffer.\n" :
+			"Both buffers busy at redraw(). Server bug?\n");
+		abort();
+	}
+
+	paint_pixels(buffer->shm_data, window->width, window->height, time);
+
+	wl_surface_attach(window->surface, buffer->buffer, 0, 0);
+	wl_surface_damage(window->surface,
+			  0, 0, window->width, window->height);
+
+	window->callback = wl_surface_frame(window->surface);
+	wl_callback_add_listener(window->callback, &frame_listener, window);
+	wl_surface_commit(window->surface);
+	buffer->busy = 1;
+}
+
+static const struct wl_callback_listener frame_listener = {
+	redraw
+};
+
+static void
+handle_visibility(void *data, struct ivi_surface *ivi_surface,
+		  int32_t visibility)
+{
+	struct window *window = data;
+
+	window->visible = visibility != 0;
+	window->visibility_events++;
+	printf("visibility: %d\n", visibility);
+
+	if (window->visible && !window->callback)
+		redraw(window, NULL, 0);
+}
+
+static void
+handle_warning(void *data, struct ivi_surface *ivi_surface,
+	       int32_t warning_code, const char *warning_text)
+{
+	fprintf(stderr, "ivi_surface warning %d: %s\n",
+		warning_code, warning_text);
+}
+
+static const struct ivi_surface_listener ivi_surface_listener = {
+	handle_visibility,
+	handle_warning
+};
+
+static struct window *
+create_window(struct display *display, int width, int height,
+	      uint32_t id_surface)
+{
+	struct window *window;
+
+	window = calloc(1, sizeof *window);
+	if (!window)
+		return NULL;
+
+	window->display = display;
+	window->width = width;
+	window->height = height;
+	window->visible = 1;
+	window->surface = wl_compositor_create_surface(display->compositor);
+
+	window->ivi_surface =
+		ivi_application_surface_create(display->ivi_application,
+					       id_surface, window->surface);
+	if (window->ivi_surface == NULL) {
+		fprintf(stderr, "Failed to create ivi_client_surface\n");
+		abort();
+	}
+	ivi_surface_add_listener(window->ivi_surface,
+				 &ivi_surface_listener, window);
+
+	return window;
+}
+
+static void
+destroy_window(struct window *window)
+{
+	if (window->callback)
+		wl_callback_destroy(window->callback);
+
+	if (window->buffers[0].buffer)
+		wl_buffer_destroy(window->buffers[0].buffer);
+	if (window->buffers[1].buffer)
+		wl_buffer_destroy(window->buffers[1].buffer);
+
+	ivi_surface_destroy(window->ivi_surface);
+	wl_surface_destroy(window->surface);
+	free(window);
+}
+
+static void
+registry_handle_global(void *data, struct wl_registry *registry,
+		       uint32_t id, const char *interface, uint32_t version)
+{
+	struct display *d = data;
+
+	if (strcmp(interface, "wl_compositor") == 0) {
+		d->compositor =
+			wl_registry_bind(registry,
+					 id, &wl_compositor_interface, 1);
+	} else if (strcmp(interface, "wl_shm") == 0) {
+		d->shm = wl_registry_bind(registry,
+					  id, &wl_shm_interface, 1);
+	} else if (strcmp(interface, "ivi_application") == 0) {
+		d->ivi_application =
+			wl_registry_bind(registry, id,
+					 &ivi_application_interface, 1);
+	}
+}
+
+static void
+registry_handle_global_remove(void *data, struct wl_registry *registry,
+			      uint32_t name)
+{
+}
+
+static const struct wl_registry_listener registry_listener = {
+	registry_handle_global,
+	registry_handle_global_remove
+};
+
+static struct display *
+create_display(void)
+{
+	struct display *display;
+
+	display = calloc(1, sizeof *display);
+	if (display == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	display->display = wl_display_connect(NULL);
+	assert(display->display);
+
+	display->registry = wl_display_get_registry(display->display);
+	wl_registry_add_listener(display->registry,
+				 &registry_listener, display);
+	wl_display_roundtrip(display->display);
+	if (display->shm == NULL || display->ivi_application == NULL) {
+		fprintf(stderr, "No wl_shm or ivi_application global\n");
+		exit(1);
+	}
+
+	return display;
+}
+
+static void
+destroy_display(struct display *display)
+{
+	wl_shm_destroy(display->shm);
+	ivi_application_destroy(display->ivi_application);
+	if (display->compositor)
+		wl_compositor_destroy(display->compositor);
+
+	wl_registry_destroy(display->registry);
+	wl_display_flush(display->display);
+	wl_display_disconnect(display->display);
+	free(display);
+}
+
+static uint32_t
+get_time_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+report(struct window *window, uint32_t elapsed)
+{
+	printf("%s: %u frames in %u ms: %.1f fps\n",
+	       window->visible ? "visible" : "hidden",
+	       window->frames, elapsed,
+	       window->frames * 1000.0f / elapsed);
+	fflush(stdout);
+
+	window->frames = 0;
+}
+
+static int running = 1;
+
+static void
+signal_int(int signum)
+{
+	running = 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct sigaction sigint;
+	struct display *display;
+	struct window *window;
+	struct pollfd pfd;
+	uint32_t id_surface = IVI_SURFACE_ID;
+	uint32_t last, now;
+	int timeout;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--id=", 5) == 0) {
+			id_surface = strtoul(argv[i] + 5, NULL, 0);
+		} else {
+			fprintf(stderr, "usage: %s [--id=<surface id>]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	display = create_display();
+	window = create_window(display, 250, 250, id_surface);
+	if (!window)
+		return 1;
+
+	sigint.sa_handler = signal_int;
+	sigemptyset(&sigint.sa_mask);
+	sigint.sa_flags = SA_RESETHAND;
+	sigaction(SIGINT, &sigint, NULL);
+
+	redraw(window, NULL, 0);
+
+	pfd.fd = wl_display_get_fd(display->display);
+	pfd.events = POLLIN;
+	last = get_time_ms();
+
+	while (running) {
+		if (wl_display_dispatch_pending(display->display) < 0)
+			break;
+		wl_display_flush(display->display);
+
+		now = get_time_ms();
+		if (now - last >= REPORT_INTERVAL_MS) {
+			report(window, now - last);
+			last = now;
+		}
+		timeout = REPORT_INTERVAL_MS - (now - last);
+
+		if (poll(&pfd, 1, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if ((pfd.revents & POLLIN) &&
+		    wl_display_dispatch(display->display) < 0)
+			break;
+	}
+
+	fprintf(stderr, "ivi-visibility exiting, %u visibility events\n",
+		window->visibility_events);
+
+	destroy_window(window);
+	destroy_display(display);
+
+	return 0;
+}
@@ -786,6 +786,8 @@ animate_focus_change(struct desktop_shell *shell, struct workspace *ws,
 			ws->fsurf_back->view, 0.6,
 			focus_animation_done, ws);
 	}
+
+	weston_compositor_scene_changed(shell->compositor);
 }
 
 static void
@@ -865,6 +867,7 @@ activate_workspace(struct desktop_shell *shell, unsigned int index)
 
 	ws = get_workspace(shell, index);
 	wl_list_insert(&shell->panel_layer.link, &ws->layer.link);
+	weston_compositor_scene_changed(shell->compositor);
 
 	shell->workspaces.current = index;
 }
@@ -995,6 +998,7 @@ finish_workspace_change_animation(struct desktop_shell *shell,
 	shell->workspaces.anim_to = NULL;
 
 	wl_list_remove(&shell->workspaces.anim_from->layer.link);
+	weston_compositor_scene_changed(shell->compositor);
 }
 
 static void
@@ -1077,6 +1081,7 @@ animate_workspace_change(struct desktop_shell *shell,
 		       &shell->workspaces.animation.link);
 
 	wl_list_insert(from->layer.link.prev, &to->layer.link);
+	weston_compositor_scene_changed(shell->compositor);
 
 	workspace_translate_in(to, 0);
 
@@ -1092,6 +1097,7 @@ update_workspace(struct desktop_shell *shell, unsigned int index,
 	shell->workspaces.current = index;
 	wl_list_insert(&from->layer.link, &to->layer.link);
 	wl_list_remove(&from->layer.link);
+	weston_compositor_scene_changed(shell->compositor);
 }
 
 static void
@@ -1191,6 +1197,7 @@ move_surface_to_workspace(struct desktop_shell *shell,
 
 	wl_list_remove(&view->layer_link);
 	wl_list_insert(&to->layer.view_list, &view->layer_link);
+	weston_compositor_scene_changed(shell->compositor);
 
 	shell_surface_update_child_surface_layers(shsurf);
 
@@ -1231,6 +1238,7 @@ take_surface_to_workspace_by_seat(struct desktop_shell *shell,
 
 	wl_list_remove(&view->layer_link);
 	wl_list_insert(&to->layer.view_list, &view->layer_link);
+	weston_compositor_scene_changed(shell->compositor);
 
 	shsurf = get_shell_surface(surface);
 	if (shsurf != NULL)
@@ -1243,6 +1251,7 @@ take_surface_to_workspace_by_seat(struct desktop_shell *shell,
 	    shell->workspaces.anim_to == from) {
 		wl_list_remove(&to->layer.link);
 		wl_list_insert(from->layer.link.prev, &to->layer.link);
+		weston_compositor_scene_changed(shell->compositor);
 
 		reverse_workspace_change_animation(shell, index, from, to);
 		broadcast_current_workspace_state(shell);
@@ -2080,6 +2089,7 @@ shell_surface_update_child_surface_layers (struct shell_surface *shsurf)
 			wl_list_remove(&child->view->layer_link);
 			wl_list_insert(shsurf->view->layer_link.prev,
 			               &child->view->layer_link);
+			weston_compositor_scene_changed(child->surface->compositor);
 			weston_view_geometry_dirty(child->view);
 			weston_surface_damage(child->surface);
 
@@ -2110,6 +2120,7 @@ shell_surface_update_layer(struct shell_surface *shsurf)
 	weston_view_geometry_dirty(shsurf->view);
 	wl_list_remove(&shsurf->view->layer_link);
 	wl_list_insert(new_layer_link, &shsurf->view->layer_link);
+	weston_compositor_scene_changed(shsurf->surface->compositor);
 	weston_view_geometry_dirty(shsurf->view);
 	weston_surface_damage(shsurf->surface);
 
@@ -2531,6 +2542,7 @@ shell_ensure_fullscreen_black_view(struct shell_surface *shsurf)
 	wl_list_remove(&shsurf->fullscreen.black_view->layer_link);
 	wl_list_insert(&shsurf->view->layer_link,
 	               &shsurf->fullscreen.black_view->layer_link);
+	weston_compositor_scene_changed(shsurf->surface->compositor);
 	weston_view_geometry_dirty(shsurf->fullscreen.black_view);
 	weston_surface_damage(shsurf->surface);
 }
@@ -3579,6 +3591,7 @@ configure_static_view(struct weston_view *ev, struct weston_layer *layer)
 
 	if (wl_list_empty(&ev->layer_link)) {
 		wl_list_insert(&layer->view_list, &ev->layer_link);
+		weston_compositor_scene_changed(ev->surface->compositor);
 		weston_compositor_schedule_repaint(ev->surface->compositor);
 	}
 }
@@ -3685,6 +3698,7 @@ lock_surface_configure(struct weston_surface *surface, int32_t sx, int32_t sy)
 	if (!weston_surface_is_mapped(surface)) {
 		wl_list_insert(&shell->lock_layer.view_list,
 			       &view->layer_link);
+		weston_compositor_scene_changed(shell->compositor);
 		weston_view_update_transform(view);
 		shell_fade(shell, FADE_IN);
 	}
@@ -3745,6 +3759,7 @@ resume_desktop(struct desktop_shell *shell)
 	} else {
 		wl_list_insert(&shell->panel_layer.link, &ws->layer.link);
 	}
+	weston_compositor_scene_changed(shell->compositor);
 
 	restore_focus_state(shell, get_current_workspace(shell));
 
@@ -4217,6 +4232,7 @@ lower_fullscreen_layer(struct desktop_shell *shell)
 		weston_view_damage_below(view);
 		weston_surface_damage(view->surface);
 	}
+	weston_compositor_scene_changed(shell->compositor);
 }
 
 void
@@ -4341,6 +4357,7 @@ lock(struct desktop_shell *shell)
 	wl_list_remove(&ws->layer.link);
 	wl_list_insert(&shell->compositor->cursor_layer.link,
 		       &shell->lock_layer.link);
+	weston_compositor_scene_changed(shell->compositor);
 
 	launch_screensaver(shell);
 
@@ -4412,6 +4429,7 @@ shell_fade_create_surface(struct desktop_shell *shell)
 	weston_surface_set_color(surface, 0.0, 0.0, 0.0, 1.0);
 	wl_list_insert(&compositor->fade_layer.view_list,
 		       &view->layer_link);
+	weston_compositor_scene_changed(compositor);
 	pixman_region32_init(&surface->input);
 
 	return view;
@@ -4957,6 +4975,7 @@ screensaver_configure(struct weston_surface *surface, int32_t sx, int32_t sy)
 	if (wl_list_empty(&view->layer_link)) {
 		wl_list_insert(shell->lock_layer.view_list.prev,
 			       &view->layer_link);
+		weston_compositor_scene_changed(shell->compositor);
 		weston_view_update_transform(view);
 		wl_event_source_timer_update(shell->screensaver.timer,
 					     shell->screensaver.duration);
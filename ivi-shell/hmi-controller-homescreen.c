@@ -30,12 +30,16 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <time.h>
 #include <getopt.h>
 #include <pthread.h>
 #include <wayland-cursor.h>
 #include "hmi-controller-homescreen.h"
 #include "../shared/cairo-util.h"
 #include "../shared/config-parser.h"
+#include "../shared/os-compatibility.h"
 #include "ivi-application-client-protocol.h"
 #include "ivi-hmi-controller-client-protocol.h"
 
@@ -67,6 +71,9 @@
 /*****************************************************************************
  *  structure, globals
  ****************************************************************************/
+#define HMI_ATLAS_DECODE_THREADS 8
+#define LAUNCH_RECORDS_MAX       32
+
 enum cursor_type {
     CURSOR_BOTTOM_LEFT,
     CURSOR_BOTTOM_RIGHT,
@@ -103,6 +110,7 @@ struct wlContextCommon {
     struct wl_surface       *pointer_surface;
     enum   cursor_type      current_cursor;
     uint32_t                enter_serial;
+    struct hmi_homescreen_atlas *atlas;
 };
 
 struct wlContextStruct {
@@ -116,6 +124,25 @@ struct wlContextStruct {
     struct wl_list          link;
 };
 
+struct
+hmi_homescreen_image {
+    const char          *filePath;
+    uint32_t            color;
+    cairo_surface_t     *surface;
+    int32_t             offset;
+};
+
+struct
+hmi_homescreen_atlas {
+    struct wl_array     images;
+    struct wl_shm_pool  *pool;
+    void                *data;
+    int32_t             size;
+    int32_t             stride;
+    pthread_mutex_t     mutex;
+    uint32_t            next_image;
+};
+
 struct
 hmi_homescreen_srf {
     uint32_t    id;
@@ -156,10 +183,26 @@ hmi_homescreen_setting {
 
     char     *cursor_theme;
     int32_t  cursor_size;
+    int32_t  launcher_zygote;
+};
+
+struct
+hmi_launch_record {
+    pid_t               pid;
+    struct timespec     tap;
+    int32_t             is_zygote;
+    struct wl_list      link;
 };
 
 volatile int gRun = 0;
 
+/* socket to launcher zygote, -1 when applications are forked directly */
+static int launcher_zygote_fd = -1;
+
+/* launches waiting for first commit, shared with hmi-controller */
+static pthread_mutex_t launch_records_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct wl_list launch_records = { &launch_records, &launch_records };
+
 static void *
 fail_on_null(void *p, size_t size, char* file, int32_t line)
 {
@@ -303,11 +346,97 @@ PointerHandleMotion(void* data, struct wl_pointer* wlPointer, uint32_t time,
 /**
  * if a surface assigned as launcher receives touch-off event, invoking
  * ivi-application which configured in weston.ini with path to binary.
+ *
+ * If launcher-zygote is enabled in weston.ini, weston-ivi-launcher is
+ * started once and launches applications on request of homescreen. It saves
+ * forking whole multi-threaded weston on every tap. Only execve is called
+ * between fork and exec, because other threads of weston may hold locks.
  */
 extern char **environ; /*defied by libc */
 
+static int
+launcher_zygote_start(void)
+{
+    char path[] = LIBEXECDIR "/weston-ivi-launcher";
+    char *argv[] = {path, NULL};
+    int sv[2];
+    pid_t pid = 0;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+        fprintf(stderr, "Failed to create socket of launcher zygote: %m\n");
+        return -1;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Failed to fork launcher zygote\n");
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    /* dup2 clears close-on-exec, unless the fd is already the one */
+    if (0 == pid) {
+        if (sv[1] == LAUNCHER_ZYGOTE_FD) {
+            fcntl(sv[1], F_SETFD, 0);
+        } else {
+            dup2(sv[1], LAUNCHER_ZYGOTE_FD);
+        }
+        execve(path, argv, environ);
+        _exit(1);
+    }
+
+    close(sv[1]);
+    return sv[0];
+}
+
+static pid_t
+launcher_zygote_launch(char* path, char *argv[])
+{
+    char msg[LAUNCHER_ZYGOTE_MSG_SIZE];
+    size_t len = 0;
+    size_t size = 0;
+    pid_t pid = -1;
+    int32_t i = -1;
+    const char *arg = path;
+
+    do {
+        /* i + 1 strings are already in msg */
+        if (LAUNCHER_ZYGOTE_MAX_ARGS <= i + 1) {
+            fprintf(stderr, "Too many arguments to launch %s\n", path);
+            return -1;
+        }
+        size = strlen(arg) + 1;
+        if (sizeof(msg) - 1 < len + size) {
+            fprintf(stderr, "Too long arguments to launch %s\n", path);
+            return -1;
+        }
+        memcpy(msg + len, arg, size);
+        len += size;
+        arg = argv[++i];
+    } while (arg);
+
+    /* EPIPE instead of SIGPIPE, which kills weston, if zygote exited */
+    if (send(launcher_zygote_fd, msg, len, MSG_NOSIGNAL) < 0 ||
+        recv(launcher_zygote_fd, &pid, sizeof(pid), 0) != sizeof(pid)) {
+        fprintf(stderr, "Launcher zygote is gone, fork directly: %m\n");
+        close(launcher_zygote_fd);
+        launcher_zygote_fd = -1;
+        return -1;
+    }
+
+    return pid;
+}
+
 static pid_t execute_process(char* path, char *argv[])
 {
+    if (0 <= launcher_zygote_fd) {
+        pid_t pid = launcher_zygote_launch(path, argv);
+        if (0 < pid) {
+            return pid;
+        }
+    }
+
     pid_t pid = fork();
     if (pid < 0) {
         fprintf(stderr, "Failed to fork\n");
@@ -325,6 +454,34 @@ static pid_t execute_process(char* path, char *argv[])
     return pid;
 }
 
+/**
+ * Remember when an application was tapped to measure latency till its first
+ * surface is committed, see hmi_client_launch_latency.
+ */
+static void
+add_launch_record(pid_t pid, const struct timespec *tap, int32_t is_zygote)
+{
+    struct hmi_launch_record *record = MEM_ALLOC(sizeof(*record));
+    struct hmi_launch_record *oldest = NULL;
+
+    record->pid = pid;
+    record->tap = *tap;
+    record->is_zygote = is_zygote;
+
+    pthread_mutex_lock(&launch_records_mutex);
+
+    /* applications which never show a surface */
+    if (LAUNCH_RECORDS_MAX <= wl_list_length(&launch_records)) {
+        oldest = wl_container_of(launch_records.prev, oldest, link);
+        wl_list_remove(&oldest->link);
+        free(oldest);
+    }
+
+    wl_list_insert(&launch_records, &record->link);
+
+    pthread_mutex_unlock(&launch_records_mutex);
+}
+
 static void
 execute_ivi_surface_creator(char* path, pid_t pid,
                             char* window_title, uint32_t id_surface)
@@ -357,8 +514,15 @@ launcher_button(uint32_t surfaceId, struct wl_list *launcher_list,
         }
 
         char *argv[] = {NULL};
+        struct timespec tap;
+        clock_gettime(CLOCK_MONOTONIC, &tap);
+
         pid = execute_process(launcher->path, argv);
 
+        if (0 < pid) {
+            add_launch_record(pid, &tap, 0 <= launcher_zygote_fd);
+        }
+
         if (0 < pid &&
             surface_creator &&
             launcher->setid_window_titles.size) {
@@ -847,60 +1011,286 @@ destroy_cursors(struct wlContextCommon *cmm)
 
 /**
  * Internal method to prepare parts of UI
+ *
+ * All images of homescreen are decoded in parallel at startup and packed into
+ * one atlas, which is shared with the compositor through a single wl_shm_pool.
+ * Images are stacked vertically in the atlas and each ivi surface gets a
+ * wl_buffer which is a slice of the pool at the offset of its image. This
+ * avoids a file, mmap and pool per launcher icon.
  */
-static void
-createShmBuffer(struct wlContextStruct *p_wlCtx)
+static struct hmi_homescreen_image *
+atlas_find_image(struct hmi_homescreen_atlas *atlas,
+                 const char *filePath, uint32_t color)
 {
-    struct wl_shm_pool *pool;
+    struct hmi_homescreen_image *image = NULL;
 
-    char filename[] = "/tmp/wayland-shm-XXXXXX";
-    int fd = -1;
-    int size = 0;
-    int width = 0;
-    int height = 0;
-    int stride = 0;
+    wl_array_for_each(image, &atlas->images) {
+        if (NULL == filePath) {
+            if (NULL == image->filePath && color == image->color) {
+                return image;
+            }
+        } else if (image->filePath && 0 == strcmp(image->filePath, filePath)) {
+            return image;
+        }
+    }
 
-    fd = mkstemp(filename);
-    if (fd < 0) {
-        fprintf(stderr, "open %s failed: %m\n", filename);
+    return NULL;
+}
+
+/**
+ * Register an image to be packed in atlas. filePath is NULL for a 1x1 image
+ * filled by color. The same file is decoded and stored only once.
+ */
+static void
+atlas_add_image(struct hmi_homescreen_atlas *atlas,
+                const char *filePath, uint32_t color)
+{
+    struct hmi_homescreen_image *image = NULL;
+
+    if (atlas_find_image(atlas, filePath, color)) {
         return;
     }
 
-    width  = cairo_image_surface_get_width(p_wlCtx->ctx_image);
-    height = cairo_image_surface_get_height(p_wlCtx->ctx_image);
-    stride = cairo_image_surface_get_stride(p_wlCtx->ctx_image);
+    image = wl_array_add(&atlas->images, sizeof(*image));
+    fail_on_null(image, sizeof(*image), __FILE__, __LINE__);
+    memset(image, 0x00, sizeof(*image));
 
-    size = stride * height;
-    if (ftruncate(fd, size) < 0) {
-        fprintf(stderr, "ftruncate failed: %m\n");
-        close(fd);
-        return;
+    image->filePath = filePath;
+    image->color = color;
+}
+
+static void
+set_hex_color(cairo_t *cr, uint32_t color)
+{
+    cairo_set_source_rgba(cr,
+        ((color >> 16) & 0xff) / 255.0,
+        ((color >>  8) & 0xff) / 255.0,
+        ((color >>  0) & 0xff) / 255.0,
+        ((color >> 24) & 0xff) / 255.0);
+}
+
+static cairo_surface_t *
+create_color_surface(uint32_t width, uint32_t height, uint32_t color)
+{
+    cairo_surface_t *surface = NULL;
+    cairo_t *cr = NULL;
+
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+
+    cr = cairo_create(surface);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_rectangle(cr, 0, 0, width, height);
+    set_hex_color(cr, color);
+    cairo_fill(cr);
+    cairo_destroy(cr);
+
+    return surface;
+}
+
+/**
+ * Worker of atlas_decode. Each thread takes next image which is not decoded
+ * yet till all images are taken.
+ */
+static void *
+atlas_decode_thread(void *data)
+{
+    struct hmi_homescreen_atlas *atlas = data;
+    struct hmi_homescreen_image *images = atlas->images.data;
+    uint32_t count = atlas->images.size / sizeof(*images);
+    uint32_t index = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&atlas->mutex);
+        index = atlas->next_image++;
+        pthread_mutex_unlock(&atlas->mutex);
+
+        if (count <= index) {
+            break;
+        }
+
+        if (NULL == images[index].filePath) {
+            images[index].surface =
+                create_color_surface(1, 1, images[index].color);
+            continue;
+        }
+
+        images[index].surface = load_cairo_surface(images[index].filePath);
+        if (NULL == images[index].surface) {
+            fprintf(stderr, "Failed to load_cairo_surface %s\n",
+                    images[index].filePath);
+        }
     }
 
-    p_wlCtx->data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return NULL;
+}
+
+static void
+atlas_decode(struct hmi_homescreen_atlas *atlas)
+{
+    uint32_t count = atlas->images.size / sizeof(struct hmi_homescreen_image);
+    pthread_t threads[HMI_ATLAS_DECODE_THREADS];
+    uint32_t thread_count = 0;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t i = 0;
 
-    if (MAP_FAILED == p_wlCtx->data) {
+    /* calling thread decodes as well */
+    if (1 < cpus) {
+        thread_count = cpus - 1;
+    }
+
+    if (HMI_ATLAS_DECODE_THREADS < thread_count) {
+        thread_count = HMI_ATLAS_DECODE_THREADS;
+    }
+
+    if (count <= thread_count) {
+        thread_count = count ? count - 1 : 0;
+    }
+
+    pthread_mutex_init(&atlas->mutex, NULL);
+    atlas->next_image = 0;
+
+    for (i = 0; i < thread_count; i++) {
+        if (0 != pthread_create(&threads[i], NULL,
+                                atlas_decode_thread, atlas)) {
+            fprintf(stderr, "Failed to create decode thread\n");
+            break;
+        }
+    }
+    thread_count = i;
+
+    atlas_decode_thread(atlas);
+
+    for (i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&atlas->mutex);
+}
+
+/**
+ * Copy decoded images into one shared memory and create wl_shm_pool of it.
+ * Decoded images are replaced with cairo surfaces referring to the atlas.
+ */
+static int
+atlas_create_pool(struct hmi_homescreen_atlas *atlas, struct wl_shm *wlShm)
+{
+    struct hmi_homescreen_image *image = NULL;
+    int32_t max_width = 0;
+    int32_t total_height = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t stride = 0;
+    int32_t y = 0;
+    int32_t row = 0;
+    int fd = -1;
+    uint8_t *src = NULL;
+    cairo_surface_t *surface = NULL;
+
+    wl_array_for_each(image, &atlas->images) {
+        if (NULL == image->surface) {
+            continue;
+        }
+
+        width = cairo_image_surface_get_width(image->surface);
+        if (max_width < width) {
+            max_width = width;
+        }
+        total_height += cairo_image_surface_get_height(image->surface);
+    }
+
+    if (0 == max_width || 0 == total_height) {
+        return -1;
+    }
+
+    atlas->stride = max_width * 4;
+    atlas->size = atlas->stride * total_height;
+
+    fd = os_create_anonymous_file(atlas->size);
+    if (fd < 0) {
+        fprintf(stderr, "creating a buffer file for %d B failed: %m\n",
+                atlas->size);
+        return -1;
+    }
+
+    atlas->data = mmap(NULL, atlas->size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+    if (MAP_FAILED == atlas->data) {
         fprintf(stderr, "mmap failed: %m\n");
+        atlas->data = NULL;
         close(fd);
-        return;
+        return -1;
+    }
+
+    atlas->pool = wl_shm_create_pool(wlShm, fd, atlas->size);
+    close(fd);
+
+    wl_array_for_each(image, &atlas->images) {
+        if (NULL == image->surface) {
+            continue;
+        }
+
+        cairo_surface_flush(image->surface);
+        width  = cairo_image_surface_get_width(image->surface);
+        height = cairo_image_surface_get_height(image->surface);
+        stride = cairo_image_surface_get_stride(image->surface);
+        src    = cairo_image_surface_get_data(image->surface);
+
+        image->offset = y * atlas->stride;
+        for (row = 0; row < height; row++) {
+            memcpy((uint8_t *)atlas->data + image->offset + row * atlas->stride,
+                   src + row * stride, width * 4);
+        }
+
+        surface = cairo_image_surface_create_for_data(
+                      (uint8_t *)atlas->data + image->offset,
+                      CAIRO_FORMAT_ARGB32, width, height, atlas->stride);
+        cairo_surface_destroy(image->surface);
+        image->surface = surface;
+
+        y += height;
     }
 
-    pool = wl_shm_create_pool(p_wlCtx->cmm.wlShm, fd, size);
-    p_wlCtx->wlBuffer = wl_shm_pool_create_buffer(pool, 0,
-                                                  width,
-                                                  height,
-                                                  stride,
-                                                  WL_SHM_FORMAT_ARGB8888);
+    return 0;
+}
+
+static void
+atlas_release(struct hmi_homescreen_atlas *atlas)
+{
+    struct hmi_homescreen_image *image = NULL;
+
+    wl_array_for_each(image, &atlas->images) {
+        if (image->surface) {
+            cairo_surface_destroy(image->surface);
+        }
+    }
+    wl_array_release(&atlas->images);
+
+    if (atlas->pool) {
+        wl_shm_pool_destroy(atlas->pool);
+    }
+
+    if (atlas->data) {
+        munmap(atlas->data, atlas->size);
+    }
+}
+
+static void
+createAtlasBuffer(struct wlContextStruct *p_wlCtx)
+{
+    struct hmi_homescreen_atlas *atlas = p_wlCtx->cmm.atlas;
+
+    p_wlCtx->data = cairo_image_surface_get_data(p_wlCtx->ctx_image);
+    p_wlCtx->wlBuffer = wl_shm_pool_create_buffer(
+                            atlas->pool,
+                            (uint8_t *)p_wlCtx->data - (uint8_t *)atlas->data,
+                            cairo_image_surface_get_width(p_wlCtx->ctx_image),
+                            cairo_image_surface_get_height(p_wlCtx->ctx_image),
+                            atlas->stride,
+                            WL_SHM_FORMAT_ARGB8888);
 
     if (NULL == p_wlCtx->wlBuffer) {
         fprintf(stderr, "wl_shm_create_buffer failed: %m\n");
-        close(fd);
-        return;
     }
-    wl_shm_pool_destroy(pool);
-    close(fd);
-
-    return;
 }
 
 static void
@@ -942,8 +1332,7 @@ createWLContext(struct wlContextStruct *p_wlCtx)
         abort();
     }
 
-
-    createShmBuffer(p_wlCtx);
+    createAtlasBuffer(p_wlCtx);
 
     wl_display_flush(p_wlCtx->cmm.wlDisplay);
     wl_display_roundtrip(p_wlCtx->cmm.wlDisplay);
@@ -958,15 +1347,10 @@ drawImage(struct wlContextStruct *p_wlCtx)
 
     int width = 0;
     int height = 0;
-    int stride = 0;
-    void *data = NULL;
 
+    /* pixels are already in atlas */
     width = cairo_image_surface_get_width(p_wlCtx->ctx_image);
     height = cairo_image_surface_get_height(p_wlCtx->ctx_image);
-    stride = cairo_image_surface_get_stride(p_wlCtx->ctx_image);
-    data = cairo_image_surface_get_data(p_wlCtx->ctx_image);
-
-    memcpy(p_wlCtx->data, data, stride * height);
 
     wl_surface_attach(p_wlCtx->wlSurface, p_wlCtx->wlBuffer, 0, 0);
     wl_surface_damage(p_wlCtx->wlSurface, 0, 0, width, height);
@@ -987,7 +1371,7 @@ create_ivisurface(struct wlContextStruct *p_wlCtx,
 {
     struct ivi_surface *ivisurf = NULL;
 
-    p_wlCtx->ctx_image = surface;
+    p_wlCtx->ctx_image = cairo_surface_reference(surface);
 
     p_wlCtx->id_surface = id_surface;
     wl_list_init(&p_wlCtx->link);
@@ -1012,45 +1396,36 @@ create_ivisurfaceFromFile(struct wlContextStruct *p_wlCtx,
                           uint32_t id_surface,
                           const char* imageFile)
 {
-    cairo_surface_t* surface = load_cairo_surface(imageFile);
+    struct hmi_homescreen_image *image = NULL;
+
+    if (imageFile) {
+        image = atlas_find_image(p_wlCtx->cmm.atlas, imageFile, 0);
+    }
 
-    if (NULL == surface) {
-        fprintf(stderr, "Failed to load_cairo_surface %s\n", imageFile);
+    if (NULL == image || NULL == image->surface ||
+        NULL == p_wlCtx->cmm.atlas->pool) {
+        fprintf(stderr, "No image of %s in atlas\n", imageFile);
         return;
     }
 
-    create_ivisurface(p_wlCtx, id_surface, surface);
-}
-
-static void
-set_hex_color(cairo_t *cr, uint32_t color)
-{
-    cairo_set_source_rgba(cr,
-        ((color >> 16) & 0xff) / 255.0,
-        ((color >>  8) & 0xff) / 255.0,
-        ((color >>  0) & 0xff) / 255.0,
-        ((color >> 24) & 0xff) / 255.0);
+    create_ivisurface(p_wlCtx, id_surface, image->surface);
 }
 
 static void
 create_ivisurfaceFromColor(struct wlContextStruct *p_wlCtx,
                            uint32_t id_surface,
-                           uint32_t width, uint32_t height,
                            uint32_t color)
 {
-    cairo_surface_t *surface = NULL;
-    cairo_t *cr = NULL;
+    struct hmi_homescreen_image *image =
+        atlas_find_image(p_wlCtx->cmm.atlas, NULL, color);
 
-    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
-
-    cr = cairo_create(surface);
-    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-    cairo_rectangle(cr, 0, 0, width, height);
-    set_hex_color(cr, color);
-    cairo_fill(cr);
-    cairo_destroy(cr);
+    if (NULL == image || NULL == image->surface ||
+        NULL == p_wlCtx->cmm.atlas->pool) {
+        fprintf(stderr, "No image of color 0x%08x in atlas\n", color);
+        return;
+    }
 
-    create_ivisurface(p_wlCtx, id_surface, surface);
+    create_ivisurface(p_wlCtx, id_surface, image->surface);
 }
 
 /**
@@ -1092,7 +1467,7 @@ static void
 create_workspace_background(
     struct wlContextStruct *p_wlCtx, struct hmi_homescreen_srf *srf)
 {
-    create_ivisurfaceFromColor(p_wlCtx, srf->id, 1, 1, srf->color);
+    create_ivisurfaceFromColor(p_wlCtx, srf->id, srf->color);
     ivi_hmi_controller_set_workspacebackground(p_wlCtx->cmm.hmiCtrl, srf->id);
 }
 
@@ -1236,6 +1611,9 @@ hmi_homescreen_setting_create(void)
 
     weston_config_section_get_int(shellSection, "cursor-size", &setting->cursor_size, 32);
 
+    weston_config_section_get_bool(
+            shellSection, "launcher-zygote", &setting->launcher_zygote, 0);
+
     uint32_t workspace_layer_id;
     weston_config_section_get_uint(
         shellSection, "workspace-layer-id", &workspace_layer_id, 3000);
@@ -1339,8 +1717,10 @@ hmi_homescreen_setting_create(void)
  *
  * The basic flow are as followed,
  * 1/ read configuration from weston.ini by hmi_homescreen_setting_create
- * 2/ draw png file to surface according to configuration of weston.ini and
- *    set up UI by using ivi-hmi-controller protocol by each create_* method
+ * 2/ decode png files configured in weston.ini in parallel and pack them
+ *    into one atlas shared by a wl_shm_pool
+ * 3/ create surfaces showing a part of the atlas and set up UI by using
+ *    ivi-hmi-controller protocol by each create_* method
  */
 static void*
 client_thread(void *p_ret)
@@ -1355,8 +1735,11 @@ client_thread(void *p_ret)
     struct wlContextStruct wlCtx_HomeButton;
     struct wlContextStruct wlCtx_WorkSpaceBackGround;
     struct wl_list         launcher_wlCtxList;
+    struct hmi_homescreen_atlas atlas;
 
     memset(&wlCtxCommon, 0x00, sizeof(wlCtxCommon));
+    memset(&atlas, 0x00, sizeof(atlas));
+    wl_array_init(&atlas.images);
     memset(&wlCtx_BackGround, 0x00, sizeof(wlCtx_BackGround));
     memset(&wlCtx_Panel,      0x00, sizeof(wlCtx_Panel));
     memset(&wlCtx_Button_1,   0x00, sizeof(wlCtx_Button_1));
@@ -1372,12 +1755,38 @@ client_thread(void *p_ret)
 
     struct hmi_homescreen_setting *hmi_setting = hmi_homescreen_setting_create();
     wlCtxCommon.hmi_setting = hmi_setting;
+    wlCtxCommon.atlas = &atlas;
+
+    /* fork zygote before allocating images */
+    if (hmi_setting->launcher_zygote) {
+        launcher_zygote_fd = launcher_zygote_start();
+    }
+
+    /* decode all images before connecting to compositor */
+    atlas_add_image(&atlas, hmi_setting->background.filePath, 0);
+    atlas_add_image(&atlas, hmi_setting->panel.filePath, 0);
+    atlas_add_image(&atlas, hmi_setting->tiling.filePath, 0);
+    atlas_add_image(&atlas, hmi_setting->sidebyside.filePath, 0);
+    atlas_add_image(&atlas, hmi_setting->fullscreen.filePath, 0);
+    atlas_add_image(&atlas, hmi_setting->random.filePath, 0);
+    atlas_add_image(&atlas, hmi_setting->home.filePath, 0);
+    atlas_add_image(&atlas, NULL, hmi_setting->workspace_background.color);
+
+    struct hmi_homescreen_launcher *launcher = NULL;
+    wl_list_for_each(launcher, &hmi_setting->launcher_list, link) {
+        if (launcher->icon) {
+            atlas_add_image(&atlas, launcher->icon, 0);
+        }
+    }
+
+    atlas_decode(&atlas);
 
     gRun = 1;
 
     wlCtxCommon.wlDisplay = wl_display_connect(NULL);
     if (NULL == wlCtxCommon.wlDisplay) {
         printf("Error: wl_display_connect failed.\n");
+        atlas_release(&atlas);
         return NULL;
     }
 
@@ -1397,6 +1806,8 @@ client_thread(void *p_ret)
         wlCtxCommon.current_cursor = CURSOR_LEFT_PTR;
     }
 
+    atlas_create_pool(&atlas, wlCtxCommon.wlShm);
+
     wlCtx_BackGround.cmm = wlCtxCommon;
     wlCtx_Panel.cmm      = wlCtxCommon;
     wlCtx_Button_1.cmm   = wlCtxCommon;
@@ -1447,6 +1858,12 @@ client_thread(void *p_ret)
 
     destroyWLContextCommon(&wlCtxCommon);
     free(wlCtxCommon.list_wlContextStruct);
+    atlas_release(&atlas);
+
+    if (0 <= launcher_zygote_fd) {
+        close(launcher_zygote_fd);
+        launcher_zygote_fd = -1;
+    }
 
     return NULL;
 }
@@ -1471,3 +1888,34 @@ hmi_client_start(void)
 
     return 0;
 }
+
+int
+hmi_client_launch_latency(pid_t pid, uint32_t *usec, int32_t *is_zygote)
+{
+    struct hmi_launch_record *record = NULL;
+    struct timespec now;
+    int ret = -1;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&launch_records_mutex);
+
+    wl_list_for_each(record, &launch_records, link) {
+        if (record->pid != pid) {
+            continue;
+        }
+
+        *usec = (now.tv_sec - record->tap.tv_sec) * 1000000 +
+                (now.tv_nsec - record->tap.tv_nsec) / 1000;
+        *is_zygote = record->is_zygote;
+
+        wl_list_remove(&record->link);
+        free(record);
+        ret = 0;
+        break;
+    }
+
+    pthread_mutex_unlock(&launch_records_mutex);
+
+    return ret;
+}
@@ -27,8 +27,26 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stdint.h>
+#include <sys/types.h>
+
+/* protocol between homescreen and weston-ivi-launcher, which gets the
+ * socket at LAUNCHER_ZYGOTE_FD */
+#define LAUNCHER_ZYGOTE_FD       3
+#define LAUNCHER_ZYGOTE_MSG_SIZE 4096
+#define LAUNCHER_ZYGOTE_MAX_ARGS 32
+
 int hmi_client_start(void);
 
+/**
+ * \brief get time from tap on a launcher to now, which is expected to be
+ * when the first surface of the launched process is committed.
+ *
+ * Each launch is reported only once. Returns -1 if pid is not launched by
+ * homescreen or it was already reported.
+ */
+int hmi_client_launch_latency(pid_t pid, uint32_t *usec, int32_t *is_zygote);
+
 #ifdef __cplusplus
 } /**/
 #endif /* __cplusplus */
@@ -123,9 +123,55 @@ struct hmi_controller_fade {
     struct wl_list layer_list;
 };
 
+/**
+ * Animations are stepped by frame of output, with its presentation time,
+ * while any of them is running.
+ */
 struct animation_set {
-    struct wl_event_source  *event_source;
-    struct wl_list          animation_list;
+    struct weston_compositor *compositor;
+    struct weston_animation  animation;
+    struct wl_listener       output_destroy_listener;
+    struct wl_list           animation_list;
+};
+
+/**
+ * A layout mode is a template of slots on a grid of application layer,
+ * read from [ivi-layout-mode] sections of weston.ini. Application surfaces
+ * are assigned to slots in order of priority, lower first. Surfaces beyond
+ * the last slot are hidden, or stacked in the last slot.
+ */
+#define HMI_LAYOUT_MODE_COUNT (IVI_HMI_CONTROLLER_LAYOUT_MODE_RANDOM + 1)
+#define HMI_LAYOUT_ANIMATION_MS 300.0
+
+struct hmi_layout_slot {
+    uint32_t column;
+    uint32_t row;
+    uint32_t columns;
+    uint32_t rows;
+    int32_t  priority;
+
+    /* rectangle in application layer, precomputed */
+    int32_t  x;
+    int32_t  y;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct hmi_layout_template {
+    uint32_t grid_columns;
+    uint32_t grid_rows;
+    uint32_t is_stacked;
+    uint32_t slot_count;
+    struct hmi_layout_slot *slots;
+};
+
+struct slot_animation_user_data {
+    struct hmi_controller *hmi_ctrl;
+    struct hmi_controller_animation_move *animation;
+    struct weston_layout_surface *ivisurf;
+    int32_t from[4];
+    int32_t to[4];
+    struct wl_list link;
 };
 
 struct
@@ -135,6 +181,7 @@ hmi_server_setting {
     uint32_t    workspace_background_layer_id;
     uint32_t    workspace_layer_id;
     uint32_t    panel_height;
+    struct hmi_layout_template layout_templates[HMI_LAYOUT_MODE_COUNT];
 };
 
 struct hmi_controller
@@ -149,8 +196,10 @@ struct hmi_controller
     struct animation_set                    *anima_set;
     struct hmi_controller_fade              workspace_fade;
     struct hmi_controller_animation_move    *workspace_swipe_animation;
+    struct wl_list                          slot_animation_list;
     int32_t                                 workspace_count;
     struct wl_array                     ui_widgets;
+    struct wl_array                     surfaces;
     int32_t                             is_initialized;
 };
 
@@ -192,71 +241,68 @@ is_surf_in_uiWidget(struct hmi_controller *hmi_ctrl,
     return 0;
 }
 
+static void
+hmi_controller_slot_animation_run(struct hmi_controller *hmi_ctrl,
+                                  struct weston_layout_surface *ivisurf,
+                                  const int32_t *from, const int32_t *to);
+static void
+hmi_controller_slot_animation_cancel(struct hmi_controller *hmi_ctrl,
+                                     struct weston_layout_surface *ivisurf);
+
 /**
  * Internal methods called by mainly ivi_hmi_controller_switch_mode
- * This reference shows 4 examples how to use weston_layout APIs.
+ * This reference shows 2 examples how to use weston_layout APIs; slots of
+ * layout template, and random.
+ *
+ * Move a surface to the rectangle of a slot. A surface shown in another
+ * rectangle is animated to it, others are put there at once.
  */
 static void
-mode_divided_into_tiling(struct hmi_controller *hmi_ctrl,
-                        weston_layout_surface_ptr *ppSurface,
-                        uint32_t surface_length,
-                        struct hmi_controller_layer *layer)
-{
-    const float surface_width  = (float)layer->width * 0.25;
-    const float surface_height = (float)layer->height * 0.5;
-    int32_t surface_x = 0;
-    int32_t surface_y = 0;
-    struct weston_layout_surface *ivisurf  = NULL;
+move_surface_to_slot(struct hmi_controller *hmi_ctrl,
+                     struct weston_layout_surface *ivisurf,
+                     const struct hmi_layout_slot *slot)
+{
+    struct weston_layout_SurfaceProperties prop;
+    int32_t from[4] = {0};
+    int32_t to[4] = {slot->x, slot->y, slot->width, slot->height};
     int32_t ret = 0;
 
-    uint32_t i = 0;
-    uint32_t num = 1;
-    for (i = 0; i < surface_length; i++) {
-        ivisurf = ppSurface[i];
-
-        /* skip ui widgets */
-        if (is_surf_in_uiWidget(hmi_ctrl, ivisurf)) {
-            continue;
-        }
-
-        if (num <= 8) {
-            if (num < 5) {
-                surface_x = (int32_t)((num - 1) * (surface_width));
-                surface_y = 0;
-            }
-            else {
-                surface_x = (int32_t)((num - 5) * (surface_width));
-                surface_y = (int32_t)surface_height;
-            }
-            ret = weston_layout_surfaceSetDestinationRectangle(ivisurf, surface_x, surface_y,
-                                                            surface_width, surface_height);
-            assert(!ret);
-
-            ret = weston_layout_surfaceSetVisibility(ivisurf, 1);
-            assert(!ret);
+    ret = weston_layout_getPropertiesOfSurface(ivisurf, &prop);
+    assert(!ret);
 
-            num++;
-            continue;
-        }
+    from[0] = prop.destX;
+    from[1] = prop.destY;
+    from[2] = prop.destWidth;
+    from[3] = prop.destHeight;
 
-        ret = weston_layout_surfaceSetVisibility(ivisurf, 0);
+    if (prop.visibility && from[2] != 0 && from[3] != 0 &&
+        memcmp(from, to, sizeof from) != 0) {
+        hmi_controller_slot_animation_run(hmi_ctrl, ivisurf, from, to);
+    } else {
+        ret = weston_layout_surfaceSetDestinationRectangle(ivisurf,
+                                    to[0], to[1], to[2], to[3]);
         assert(!ret);
     }
+
+    ret = weston_layout_surfaceSetVisibility(ivisurf, 1);
+    assert(!ret);
 }
 
-static void
-mode_divided_into_sidebyside(struct hmi_controller *hmi_ctrl,
-                      weston_layout_surface_ptr *ppSurface,
-                      uint32_t surface_length,
-                      struct hmi_controller_layer *layer)
+/**
+ * Assign application surfaces to slots of a layout template in one pass.
+ * Return the number of application surfaces.
+ */
+static uint32_t
+mode_assign_slots(struct hmi_controller *hmi_ctrl,
+                  weston_layout_surface_ptr *ppSurface,
+                  uint32_t surface_length,
+                  const struct hmi_layout_template *template)
 {
-    uint32_t surface_width  = layer->width / 2;
-    uint32_t surface_height = layer->height;
     struct weston_layout_surface *ivisurf  = NULL;
+    uint32_t num = 0;
+    uint32_t i = 0;
     int32_t ret = 0;
 
-    uint32_t i = 0;
-    uint32_t num = 1;
     for (i = 0; i < surface_length; i++) {
         ivisurf = ppSurface[i];
 
@@ -265,63 +311,23 @@ mode_divided_into_sidebyside(struct hmi_controller *hmi_ctrl,
             continue;
         }
 
-        if (num == 1) {
-            ret = weston_layout_surfaceSetDestinationRectangle(ivisurf, 0, 0,
-                                                surface_width, surface_height);
-            assert(!ret);
-
-            ret = weston_layout_surfaceSetVisibility(ivisurf, 1);
+        if (num < template->slot_count) {
+            move_surface_to_slot(hmi_ctrl, ivisurf, &template->slots[num]);
+        } else if (template->is_stacked && template->slot_count > 0) {
+            move_surface_to_slot(hmi_ctrl, ivisurf,
+                                 &template->slots[template->slot_count - 1]);
+        } else {
+            ret = weston_layout_surfaceSetVisibility(ivisurf, 0);
             assert(!ret);
-
-            num++;
-            continue;
         }
-        else if (num == 2) {
-            ret = weston_layout_surfaceSetDestinationRectangle(ivisurf, surface_width, 0,
-                                                surface_width, surface_height);
-            assert(!ret);
-
-            ret = weston_layout_surfaceSetVisibility(ivisurf, 1);
-            assert(!ret);
 
-            num++;
-            continue;
-        }
-
-        weston_layout_surfaceSetVisibility(ivisurf, 0);
-        assert(!ret);
+        num++;
     }
-}
-
-static void
-mode_fullscreen_someone(struct hmi_controller *hmi_ctrl,
-                      weston_layout_surface_ptr *ppSurface, uint32_t surface_length,
-                      struct hmi_controller_layer *layer)
-{
-    const uint32_t  surface_width  = layer->width;
-    const uint32_t  surface_height = layer->height;
-    struct weston_layout_surface *ivisurf  = NULL;
-    int32_t ret = 0;
 
-    uint32_t i = 0;
-    for (i = 0; i < surface_length; i++) {
-        ivisurf = ppSurface[i];
-
-        /* skip ui widgets */
-        if (is_surf_in_uiWidget(hmi_ctrl, ivisurf)) {
-            continue;
-        }
-
-        ret = weston_layout_surfaceSetDestinationRectangle(ivisurf, 0, 0,
-                                            surface_width, surface_height);
-        assert(!ret);
-
-        ret = weston_layout_surfaceSetVisibility(ivisurf, 1);
-        assert(!ret);
-    }
+    return num;
 }
 
-static void
+static uint32_t
 mode_random_replace(struct hmi_controller *hmi_ctrl,
                     weston_layout_surface_ptr *ppSurface, uint32_t surface_length,
                     struct hmi_controller_layer *layer)
@@ -331,6 +337,7 @@ mode_random_replace(struct hmi_controller *hmi_ctrl,
     uint32_t surface_x = 0;
     uint32_t surface_y = 0;
     struct weston_layout_surface *ivisurf  = NULL;
+    uint32_t num = 0;
     int32_t ret = 0;
 
     uint32_t i = 0;
@@ -342,6 +349,8 @@ mode_random_replace(struct hmi_controller *hmi_ctrl,
             continue;
         }
 
+        num++;
+
         surface_x = rand() % (layer->width - surface_width);
         surface_y = rand() % (layer->height - surface_height);
 
@@ -352,32 +361,14 @@ mode_random_replace(struct hmi_controller *hmi_ctrl,
         ret = weston_layout_surfaceSetVisibility(ivisurf, 1);
         assert(!ret);
     }
-}
-
-static int32_t
-has_applicatipn_surface(struct hmi_controller *hmi_ctrl, weston_layout_surface_ptr *ppSurface,
-                        uint32_t surface_length)
-{
-    struct weston_layout_surface *ivisurf  = NULL;
-    uint32_t i = 0;
-
-    for (i = 0; i < surface_length; i++) {
-        ivisurf = ppSurface[i];
 
-        /* skip ui widgets */
-        if (is_surf_in_uiWidget(hmi_ctrl, ivisurf)) {
-            continue;
-        }
-
-        return 1;
-    }
-
-    return 0;
+    return num;
 }
 
 /**
  * Supports 4 example to layout of application surfaces;
- * tiling, side by side, fullscreen, and random.
+ * tiling, side by side, fullscreen, and random. Slots of each mode are
+ * precomputed from its template, random has no template by default.
  */
 static void
 switch_mode(struct hmi_controller *hmi_ctrl,
@@ -388,40 +379,58 @@ switch_mode(struct hmi_controller *hmi_ctrl,
     }
 
     struct hmi_controller_layer *layer = &hmi_ctrl->application_layer;
+    struct hmi_layout_template *template = NULL;
     weston_layout_surface_ptr  *ppSurface = NULL;
+    uint32_t surface_capacity = 0;
     uint32_t surface_length = 0;
+    uint32_t app_surface_count = 0;
     int32_t ret = 0;
 
-    hmi_ctrl->layout_mode = layout_mode;
+    if (layout_mode >= HMI_LAYOUT_MODE_COUNT) {
+        return;
+    }
 
-    ret = weston_layout_getSurfaces(&surface_length, &ppSurface);
+    hmi_ctrl->layout_mode = layout_mode;
+    template = &hmi_ctrl->hmi_setting->layout_templates[layout_mode];
+
+    /* hmi_ctrl->surfaces is kept across mode switches, and is only grown
+     * when more surfaces exist than last time */
+    surface_capacity = hmi_ctrl->surfaces.size / sizeof(*ppSurface);
+    ret = weston_layout_getSurfacesInto(surface_capacity,
+                                        hmi_ctrl->surfaces.data,
+                                        &surface_length);
     assert(!ret);
 
-    if (!has_applicatipn_surface(hmi_ctrl, ppSurface, surface_length)) {
-        free(ppSurface);
-        ppSurface = NULL;
-        return;
+    if (surface_length > surface_capacity) {
+        if (wl_array_add(&hmi_ctrl->surfaces,
+                (surface_length - surface_capacity) * sizeof(*ppSurface)) == NULL) {
+            return;
+        }
+        ret = weston_layout_getSurfacesInto(surface_length,
+                                            hmi_ctrl->surfaces.data,
+                                            &surface_length);
+        assert(!ret);
     }
 
-    switch (layout_mode) {
-    case IVI_HMI_CONTROLLER_LAYOUT_MODE_TILING:
-        mode_divided_into_tiling(hmi_ctrl, ppSurface, surface_length, layer);
-        break;
-    case IVI_HMI_CONTROLLER_LAYOUT_MODE_SIDE_BY_SIDE:
-        mode_divided_into_sidebyside(hmi_ctrl, ppSurface, surface_length, layer);
-        break;
-    case IVI_HMI_CONTROLLER_LAYOUT_MODE_FULL_SCREEN:
-        mode_fullscreen_someone(hmi_ctrl, ppSurface, surface_length, layer);
-        break;
-    case IVI_HMI_CONTROLLER_LAYOUT_MODE_RANDOM:
-        mode_random_replace(hmi_ctrl, ppSurface, surface_length, layer);
-        break;
+    ppSurface = hmi_ctrl->surfaces.data;
+
+    /* surfaces are moved from where they are now, even in the middle of
+     * previous animation */
+    hmi_controller_slot_animation_cancel(hmi_ctrl, NULL);
+
+    if (template->slot_count > 0) {
+        app_surface_count = mode_assign_slots(hmi_ctrl, ppSurface,
+                                              surface_length, template);
+    } else {
+        app_surface_count = mode_random_replace(hmi_ctrl, ppSurface,
+                                                surface_length, layer);
     }
 
-    weston_layout_commitChanges();
+    if (app_surface_count == 0) {
+        return;
+    }
 
-    free(ppSurface);
-    ppSurface = NULL;
+    weston_layout_commitChanges();
 
     return;
 }
@@ -441,32 +450,80 @@ hmi_controller_animation_frame(
     animation->frame_user_func(animation);
 }
 
-static int
-animation_set_do_anima(void* data)
+static void
+animation_set_stop(struct animation_set *anima_set)
 {
-    struct animation_set *anima_set = data;
-    uint32_t fps = 30;
+    if (wl_list_empty(&anima_set->animation.link)) {
+        return;
+    }
 
-    if (wl_list_empty(&anima_set->animation_list)) {
-        wl_event_source_timer_update(anima_set->event_source, 0);
-        return 1;
+    wl_list_remove(&anima_set->animation.link);
+    wl_list_init(&anima_set->animation.link);
+    wl_list_remove(&anima_set->output_destroy_listener.link);
+}
+
+/**
+ * Start to follow frames of the first output, on which screen of the scene
+ * graph is. The first frame comes after next repaint.
+ */
+static void
+animation_set_start(struct animation_set *anima_set)
+{
+    struct weston_output *output = NULL;
+
+    if (!wl_list_empty(&anima_set->animation.link) ||
+        wl_list_empty(&anima_set->compositor->output_list)) {
+        return;
     }
 
-    wl_event_source_timer_update(anima_set->event_source, 1000 / fps);
+    output = container_of(anima_set->compositor->output_list.next,
+                          struct weston_output, link);
 
-    struct timespec timestamp = {0};
-    clock_gettime(CLOCK_MONOTONIC, &timestamp);
-    uint32_t msec = (1e+3 * timestamp.tv_sec + 1e-6 * timestamp.tv_nsec);
+    anima_set->animation.frame_counter = 0;
+    wl_list_insert(&output->animation_list, &anima_set->animation.link);
+    wl_signal_add(&output->destroy_signal,
+                  &anima_set->output_destroy_listener);
+
+    weston_output_schedule_repaint(output);
+}
 
+static void
+animation_set_output_destroyed(struct wl_listener *listener, void *data)
+{
+    struct animation_set *anima_set =
+        container_of(listener, struct animation_set, output_destroy_listener);
+
+    animation_set_stop(anima_set);
+
+    /* move to another output if any animation is running */
+    if (!wl_list_empty(&anima_set->animation_list)) {
+        animation_set_start(anima_set);
+    }
+}
+
+/**
+ * Step all animations to presentation time of the frame, and commit. Only
+ * layers changed by them are updated by the commit, but fading and moving
+ * still cull views of all screens again, because they can uncover views.
+ */
+static void
+animation_set_frame(struct weston_animation *animation,
+                    struct weston_output *output, uint32_t msecs)
+{
+    struct animation_set *anima_set =
+        container_of(animation, struct animation_set, animation);
     struct link_animation *link_animation = NULL;
     struct link_animation *next = NULL;
 
     wl_list_for_each_safe(link_animation, next, &anima_set->animation_list, link) {
-        hmi_controller_animation_frame(link_animation->animation, msec);
+        hmi_controller_animation_frame(link_animation->animation, msecs);
     }
 
     weston_layout_commitChanges();
-    return 1;
+
+    if (wl_list_empty(&anima_set->animation_list)) {
+        animation_set_stop(anima_set);
+    }
 }
 
 static struct animation_set *
@@ -474,12 +531,12 @@ animation_set_create(struct weston_compositor* ec)
 {
     struct animation_set *anima_set = MEM_ALLOC(sizeof(*anima_set));
 
+    anima_set->compositor = ec;
+    anima_set->animation.frame = animation_set_frame;
+    wl_list_init(&anima_set->animation.link);
+    anima_set->output_destroy_listener.notify = animation_set_output_destroyed;
     wl_list_init(&anima_set->animation_list);
 
-    struct wl_event_loop *loop = wl_display_get_event_loop(ec->wl_display);
-    anima_set->event_source = wl_event_loop_add_timer(loop, animation_set_do_anima, anima_set);
-    wl_event_source_timer_update(anima_set->event_source, 0);
-
     return anima_set;
 }
 
@@ -496,7 +553,7 @@ animation_set_add_animation(struct animation_set *anima_set,
 
     link_anima->animation = anima;
     wl_list_insert(&anima_set->animation_list, &link_anima->link);
-    wl_event_source_timer_update(anima_set->event_source, 1);
+    animation_set_start(anima_set);
 }
 
 static void
@@ -657,10 +714,20 @@ hmi_controller_anima_fade_user_frame(struct hmi_controller_animation_fade *anima
     struct link_layer *linklayer = NULL;
     int32_t is_done = hmi_controller_animation_is_done(&animation->base);
     int32_t is_visible = !is_done || fade->isFadeIn;
+    uint32_t visibility = 0;
+    float opacity = 0.0f;
 
+    /* unchanged layers are not committed again */
     wl_list_for_each(linklayer, &fade->layer_list, link) {
-        weston_layout_layerSetOpacity(linklayer->layout_layer, alpha);
-        weston_layout_layerSetVisibility(linklayer->layout_layer, is_visible);
+        weston_layout_layerGetOpacity(linklayer->layout_layer, &opacity);
+        if (opacity != (float)alpha) {
+            weston_layout_layerSetOpacity(linklayer->layout_layer, alpha);
+        }
+
+        weston_layout_layerGetVisibility(linklayer->layout_layer, &visibility);
+        if (visibility != (uint32_t)is_visible) {
+            weston_layout_layerSetVisibility(linklayer->layout_layer, is_visible);
+        }
     }
 
     if (is_done) {
@@ -678,8 +745,10 @@ hmi_controller_anima_move_user_frame(struct hmi_controller_animation_move *anima
     int32_t pos[2] = {0};
     weston_layout_layerGetPosition(layer, pos);
 
-    pos[0] = (int32_t)animation->pos;
-    weston_layout_layerSetPosition(layer, pos);
+    if (pos[0] != (int32_t)animation->pos) {
+        pos[0] = (int32_t)animation->pos;
+        weston_layout_layerSetPosition(layer, pos);
+    }
 
     if (is_done) {
         hmi_controller_animation_destroy(&animation->base);
@@ -704,6 +773,85 @@ hmi_controller_fade_run(uint32_t isFadeIn, struct hmi_controller_fade *fade)
     }
 }
 
+/**
+ * Animation of a surface from a rectangle to a slot of layout mode. The move
+ * animation runs from 0 to 1 with decreasing speed, and the destination
+ * rectangle is interpolated by it.
+ */
+static void
+hmi_controller_slot_animation_destroy(struct hmi_controller_animation *animation)
+{
+    struct slot_animation_user_data *user_data = animation->user_data;
+
+    animation_set_remove_animation(user_data->hmi_ctrl->anima_set, animation);
+    wl_list_remove(&user_data->link);
+    free(user_data);
+    animation->user_data = NULL;
+}
+
+static void
+hmi_controller_anima_slot_user_frame(struct hmi_controller_animation_move *animation)
+{
+    struct slot_animation_user_data *user_data = animation->base.user_data;
+    int32_t is_done = hmi_controller_animation_is_done(&animation->base);
+    int32_t rect[4] = {0};
+    int32_t i = 0;
+
+    for (i = 0; i < 4; i++) {
+        rect[i] = user_data->from[i] +
+                  (int32_t)((user_data->to[i] - user_data->from[i]) * animation->pos);
+    }
+
+    weston_layout_surfaceSetDestinationRectangle(user_data->ivisurf,
+                                                 rect[0], rect[1],
+                                                 rect[2], rect[3]);
+
+    if (is_done) {
+        hmi_controller_animation_destroy(&animation->base);
+    }
+}
+
+static void
+hmi_controller_slot_animation_run(struct hmi_controller *hmi_ctrl,
+                                  struct weston_layout_surface *ivisurf,
+                                  const int32_t *from, const int32_t *to)
+{
+    struct slot_animation_user_data *user_data = MEM_ALLOC(sizeof(*user_data));
+    struct hmi_controller_animation_move *animation = NULL;
+
+    user_data->hmi_ctrl = hmi_ctrl;
+    user_data->ivisurf = ivisurf;
+    memcpy(user_data->from, from, sizeof user_data->from);
+    memcpy(user_data->to, to, sizeof user_data->to);
+
+    animation = hmi_controller_animation_move_create(
+        0.0, 1.0, 2.0 / HMI_LAYOUT_ANIMATION_MS, 0.0,
+        (hmi_controller_animation_frame_user_func)hmi_controller_anima_slot_user_frame,
+        user_data, hmi_controller_slot_animation_destroy);
+
+    user_data->animation = animation;
+    wl_list_insert(&hmi_ctrl->slot_animation_list, &user_data->link);
+    animation_set_add_animation(hmi_ctrl->anima_set, &animation->base);
+}
+
+/**
+ * Cancel slot animation of a surface, or all of them if ivisurf is NULL.
+ * Surfaces stay where the animation left them.
+ */
+static void
+hmi_controller_slot_animation_cancel(struct hmi_controller *hmi_ctrl,
+                                     struct weston_layout_surface *ivisurf)
+{
+    struct slot_animation_user_data *user_data = NULL;
+    struct slot_animation_user_data *next = NULL;
+
+    wl_list_for_each_safe(user_data, next, &hmi_ctrl->slot_animation_list, link) {
+        if (ivisurf == NULL || user_data->ivisurf == ivisurf) {
+            hmi_controller_animation_destroy(&user_data->animation->base);
+        }
+    }
+}
+
 /**
  * Internal method to create layer with hmi_controller_layer and add to a screen
  */
@@ -752,20 +900,254 @@ static void
 set_notification_remove_surface(struct weston_layout_surface *ivisurf,
                                 void *userdata)
 {
-    (void)ivisurf;
     struct hmi_controller* hmi_ctrl = userdata;
     switch_mode(hmi_ctrl, hmi_ctrl->layout_mode);
+
+    /* the surface is freed after this notification */
+    hmi_controller_slot_animation_cancel(hmi_ctrl, ivisurf);
+}
+
+/**
+ * Log latency from tap on a launcher to the first commit of a surface of
+ * the launched application, to compare forking and launcher-zygote.
+ */
+static void
+log_launch_latency(struct weston_layout_surface *ivisurf)
+{
+    struct weston_view *view = weston_layout_get_weston_view(ivisurf);
+    struct wl_client *client = NULL;
+    pid_t pid = 0;
+    uid_t uid = 0;
+    gid_t gid = 0;
+    uint32_t usec = 0;
+    int32_t is_zygote = 0;
+
+    if (view == NULL || view->surface->resource == NULL) {
+        return;
+    }
+
+    client = wl_resource_get_client(view->surface->resource);
+    wl_client_get_credentials(client, &pid, &uid, &gid);
+
+    if (hmi_client_launch_latency(pid, &usec, &is_zygote) == 0) {
+        weston_log("hmi-controller: surface %u of pid %d committed "
+                   "%u.%03u ms after tap (%s)\n",
+                   weston_layout_getIdOfSurface(ivisurf), pid,
+                   usec / 1000, usec % 1000,
+                   is_zygote ? "launcher-zygote" : "fork");
+    }
 }
 
 static void
 set_notification_configure_surface(struct weston_layout_surface *ivisurf,
                                    void *userdata)
 {
-    (void)ivisurf;
     struct hmi_controller* hmi_ctrl = userdata;
+
+    log_launch_latency(ivisurf);
     switch_mode(hmi_ctrl, hmi_ctrl->layout_mode);
 }
 
+/**
+ * Internal methods to read out layout templates from weston.ini, e.g.
+ *
+ *   [ivi-layout-mode]
+ *   mode=side-by-side
+ *   grid=3x1
+ *   slots=0,0,2x1 2,0,1x1:-1
+ *   overflow=hide
+ *
+ * mode is one of tiling, side-by-side, full-screen, and random. grid is
+ * columns x rows of application layer. Each slot of slots is
+ * column,row,columns x rows in cells, optionally followed by :priority,
+ * which is the index of slot by default. Without slots, all cells of grid
+ * are slots in row-major order. overflow is hide or stack.
+ */
+static const char * const hmi_layout_mode_names[HMI_LAYOUT_MODE_COUNT] = {
+    [IVI_HMI_CONTROLLER_LAYOUT_MODE_TILING]       = "tiling",
+    [IVI_HMI_CONTROLLER_LAYOUT_MODE_SIDE_BY_SIDE] = "side-by-side",
+    [IVI_HMI_CONTROLLER_LAYOUT_MODE_FULL_SCREEN]  = "full-screen",
+    [IVI_HMI_CONTROLLER_LAYOUT_MODE_RANDOM]       = "random",
+};
+
+static int32_t
+layout_template_set_grid(struct hmi_layout_template *template,
+                         uint32_t columns, uint32_t rows, uint32_t is_stacked)
+{
+    struct hmi_layout_slot *slots = NULL;
+    uint32_t i = 0;
+
+    if (columns == 0 || rows == 0) {
+        return -1;
+    }
+
+    slots = MEM_ALLOC(columns * rows * sizeof(*slots));
+
+    for (i = 0; i < columns * rows; i++) {
+        slots[i].column = i % columns;
+        slots[i].row = i / columns;
+        slots[i].columns = 1;
+        slots[i].rows = 1;
+        slots[i].priority = i;
+    }
+
+    free(template->slots);
+    template->grid_columns = columns;
+    template->grid_rows = rows;
+    template->is_stacked = is_stacked;
+    template->slot_count = columns * rows;
+    template->slots = slots;
+
+    return 0;
+}
+
+static int32_t
+layout_template_parse_slots(struct hmi_layout_template *template,
+                            const char *spec)
+{
+    struct hmi_layout_slot *slots = NULL;
+    struct hmi_layout_slot *slot = NULL;
+    char *copy = strdup(spec);
+    char *saveptr = NULL;
+    char *token = NULL;
+    uint32_t count = 0;
+    int32_t n = 0;
+
+    if (copy == NULL) {
+        return -1;
+    }
+
+    for (token = strtok_r(copy, " ", &saveptr); token != NULL;
+         token = strtok_r(NULL, " ", &saveptr)) {
+        slots = realloc(slots, (count + 1) * sizeof(*slots));
+        fail_on_null(slots, (count + 1) * sizeof(*slots), __FILE__, __LINE__);
+        slot = &slots[count];
+        slot->priority = count;
+
+        n = sscanf(token, "%u,%u,%ux%u:%d", &slot->column, &slot->row,
+                   &slot->columns, &slot->rows, &slot->priority);
+        if (n < 4 || slot->columns == 0 || slot->rows == 0 ||
+            slot->column + slot->columns > template->grid_columns ||
+            slot->row + slot->rows > template->grid_rows) {
+            fprintf(stderr, "invalid slot of layout mode: %s\n", token);
+            free(slots);
+            free(copy);
+            return -1;
+        }
+
+        count++;
+    }
+
+    free(copy);
+
+    if (count == 0) {
+        free(slots);
+        return -1;
+    }
+
+    free(template->slots);
+    template->slot_count = count;
+    template->slots = slots;
+
+    return 0;
+}
+
+static void
+hmi_server_setting_read_layout_mode(struct hmi_server_setting *setting,
+                                    struct weston_config_section *section)
+{
+    struct hmi_layout_template *template = NULL;
+    char *mode = NULL;
+    char *grid = NULL;
+    char *slots = NULL;
+    char *overflow = NULL;
+    uint32_t columns = 0;
+    uint32_t rows = 0;
+    uint32_t i = 0;
+
+    weston_config_section_get_string(section, "mode", &mode, NULL);
+    weston_config_section_get_string(section, "grid", &grid, "1x1");
+    weston_config_section_get_string(section, "slots", &slots, NULL);
+    weston_config_section_get_string(section, "overflow", &overflow, "hide");
+
+    for (i = 0; i < HMI_LAYOUT_MODE_COUNT; i++) {
+        if (mode != NULL && 0 == strcmp(mode, hmi_layout_mode_names[i])) {
+            template = &setting->layout_templates[i];
+            break;
+        }
+    }
+
+    if (template == NULL ||
+        sscanf(grid, "%ux%u", &columns, &rows) != 2 ||
+        layout_template_set_grid(template, columns, rows,
+                                 0 == strcmp(overflow, "stack")) != 0) {
+        fprintf(stderr, "invalid layout mode: %s grid=%s\n",
+                mode ? mode : "(null)", grid);
+    } else if (slots != NULL) {
+        /* all cells of grid are kept if slots are invalid */
+        layout_template_parse_slots(template, slots);
+    }
+
+    free(mode);
+    free(grid);
+    free(slots);
+    free(overflow);
+}
+
+static int
+compare_slot_priority(const void *a, const void *b)
+{
+    const struct hmi_layout_slot *slot_a = a;
+    const struct hmi_layout_slot *slot_b = b;
+
+    if (slot_a->priority != slot_b->priority) {
+        return slot_a->priority < slot_b->priority ? -1 : 1;
+    }
+
+    /* slots of the same priority are in row-major order */
+    if (slot_a->row != slot_b->row) {
+        return slot_a->row < slot_b->row ? -1 : 1;
+    }
+
+    return slot_a->column < slot_b->column ? -1 :
+           slot_a->column > slot_b->column;
+}
+
+/**
+ * Slots are sorted by priority and their rectangles are computed once, so
+ * that a mode switch only assigns surfaces to them.
+ */
+static void
+precompute_layout_templates(struct hmi_controller *hmi_ctrl)
+{
+    struct hmi_controller_layer *layer = &hmi_ctrl->application_layer;
+    struct hmi_layout_template *template = NULL;
+    struct hmi_layout_slot *slot = NULL;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    for (i = 0; i < HMI_LAYOUT_MODE_COUNT; i++) {
+        template = &hmi_ctrl->hmi_setting->layout_templates[i];
+
+        if (template->slot_count == 0) {
+            continue;
+        }
+
+        qsort(template->slots, template->slot_count,
+              sizeof(*template->slots), compare_slot_priority);
+
+        for (j = 0; j < template->slot_count; j++) {
+            slot = &template->slots[j];
+            slot->x = slot->column * layer->width / template->grid_columns;
+            slot->y = slot->row * layer->height / template->grid_rows;
+            slot->width = (slot->column + slot->columns) * layer->width /
+                          template->grid_columns - slot->x;
+            slot->height = (slot->row + slot->rows) * layer->height /
+                           template->grid_rows - slot->y;
+        }
+    }
+}
+
 /**
  * A hmi_controller used 4 layers to manage surfaces. The IDs of corresponding layer
  * are defined in weston.ini. Default scene graph of layers are initialized in
@@ -796,6 +1178,23 @@ hmi_server_setting_create(void)
 
     setting->panel_height = 70;
 
+    /* default layout modes, random has no template */
+    layout_template_set_grid(
+        &setting->layout_templates[IVI_HMI_CONTROLLER_LAYOUT_MODE_TILING], 4, 2, 0);
+    layout_template_set_grid(
+        &setting->layout_templates[IVI_HMI_CONTROLLER_LAYOUT_MODE_SIDE_BY_SIDE], 2, 1, 0);
+    layout_template_set_grid(
+        &setting->layout_templates[IVI_HMI_CONTROLLER_LAYOUT_MODE_FULL_SCREEN], 1, 1, 1);
+
+    struct weston_config_section *section = NULL;
+    const char *name = NULL;
+
+    while (weston_config_next_section(config, &section, &name)) {
+        if (0 == strcmp(name, "ivi-layout-mode")) {
+            hmi_server_setting_read_layout_mode(setting, section);
+        }
+    }
+
     weston_config_destroy(config);
 
     return setting;
@@ -828,6 +1227,7 @@ hmi_controller_create(struct weston_compositor *ec)
 
     struct hmi_controller *hmi_ctrl = MEM_ALLOC(sizeof(*hmi_ctrl));
     wl_array_init(&hmi_ctrl->ui_widgets);
+    wl_array_init(&hmi_ctrl->surfaces);
     hmi_ctrl->layout_mode = IVI_HMI_CONTROLLER_LAYOUT_MODE_TILING;
     hmi_ctrl->hmi_setting = hmi_server_setting_create();
 
@@ -858,6 +1258,7 @@ hmi_controller_create(struct weston_compositor *ec)
     hmi_ctrl->application_layer.id_layer = hmi_ctrl->hmi_setting->application_layer_id;
 
     create_layer(iviscrn, &hmi_ctrl->application_layer);
+    precompute_layout_templates(hmi_ctrl);
 
     /* init workspace background layer */
     hmi_ctrl->workspace_background_layer.x = 0;
@@ -885,6 +1286,7 @@ hmi_controller_create(struct weston_compositor *ec)
 
     /* set up animation to workspace background and workspace */
     hmi_ctrl->anima_set = animation_set_create(ec);
+    wl_list_init(&hmi_ctrl->slot_animation_list);
 
     wl_list_init(&hmi_ctrl->workspace_fade.layer_list);
     tmp_link_layer = MEM_ALLOC(sizeof(*tmp_link_layer));
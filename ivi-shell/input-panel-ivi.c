@@ -79,6 +79,8 @@ show_input_panels(struct wl_listener *listener, void *data)
 		weston_slide_run(ipsurf->view, ipsurf->surface->height * 0.9,
 				 0, NULL, NULL);
 	}
+
+	weston_compositor_scene_changed(shell->compositor);
 }
 
 static void
@@ -94,8 +96,10 @@ hide_input_panels(struct wl_listener *listener, void *data)
 
 	shell->showing_input_panels = false;
 
-	if (!shell->locked)
+	if (!shell->locked) {
 		wl_list_remove(&shell->input_panel_layer.link);
+		weston_compositor_scene_changed(shell->compositor);
+	}
 
 	wl_list_for_each_safe(view, next,
 			      &shell->input_panel_layer.view_list, layer_link)
@@ -139,6 +143,7 @@ input_panel_configure(struct weston_surface *surface, int32_t sx, int32_t sy)
 	if (!weston_surface_is_mapped(surface) && shell->showing_input_panels) {
 		wl_list_insert(&shell->input_panel_layer.view_list,
 			       &ip_surface->view->layer_link);
+		weston_compositor_scene_changed(shell->compositor);
 		weston_view_update_transform(ip_surface->view);
 		weston_surface_damage(surface);
 		weston_slide_run(ip_surface->view, ip_surface->view->surface->height * 0.9, 0, NULL, NULL);
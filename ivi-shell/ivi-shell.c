@@ -50,11 +50,15 @@ struct ivi_shell_surface
     struct weston_layout_surface *layout_surface;
 
     struct weston_surface *surface;
+    struct wl_resource *resource;
     uint32_t id_surface;
 
     int32_t width;
     int32_t height;
 
+    /* last visibility sent to the client, which assumes it is visible */
+    int32_t visibility;
+
     struct wl_list link;
 };
 
@@ -147,6 +151,16 @@ static const struct ivi_surface_interface surface_implementation = {
     surface_destroy,
 };
 
+static void
+surface_resource_destroy(struct wl_resource *resource)
+{
+    struct ivi_shell_surface *ivisurf = wl_resource_get_user_data(resource);
+
+    if (ivisurf != NULL && ivisurf->resource == resource) {
+        ivisurf->resource = NULL;
+    }
+}
+
 static struct ivi_shell_surface *
 is_surf_in_surfaces(struct wl_list *list_surf, uint32_t id_surface)
 {
@@ -187,6 +201,7 @@ application_surface_create(struct wl_client *client,
     struct weston_surface *es = wl_resource_get_user_data(surface_resource);
     struct wl_resource *res;
     int32_t warn_idx = -1;
+    int32_t visible = 0;
 
     if (es != NULL) {
         layout_surface = weston_layout_surfaceCreate(es, id_surface);
@@ -228,15 +243,50 @@ application_surface_create(struct wl_client *client,
 
     ivisurf->width = 0;
     ivisurf->height = 0;
+    ivisurf->visibility = 1;
     ivisurf->layout_surface = layout_surface;
     ivisurf->surface = es;
+    ivisurf->resource = res;
 
     es->configure = ivi_shell_surface_configure;
     es->configure_private = ivisurf;
 
     wl_resource_set_implementation(res, &surface_implementation,
-                                   ivisurf, NULL);
+                                   ivisurf, surface_resource_destroy);
     ivi_shell_surface_configure(es, 0, 0);
+
+    /* later changes are notified by surface_visibility_changed */
+    weston_layout_surfaceGetVisibleOnScreen(layout_surface, &visible);
+    if (visible != ivisurf->visibility) {
+        ivisurf->visibility = visible;
+        ivi_surface_send_visibility(res, visible);
+    }
+}
+
+/**
+ * Clients on hidden layers or below other surfaces are told to stop
+ * rendering by ivi_surface::visibility.
+ */
+static void
+surface_visibility_changed(struct weston_layout_surface *layout_surface,
+                           int32_t visible, void *userdata)
+{
+    struct ivi_shell *shell = userdata;
+    struct ivi_shell_surface *ivisurf = NULL;
+
+    wl_list_for_each(ivisurf, &shell->ivi_surface_list, link) {
+        if (ivisurf->layout_surface != layout_surface) {
+            continue;
+        }
+
+        if (ivisurf->resource == NULL || ivisurf->visibility == visible) {
+            return;
+        }
+
+        ivisurf->visibility = visible;
+        ivi_surface_send_visibility(ivisurf->resource, visible);
+        return;
+    }
 }
 
 static const struct ivi_application_interface application_implementation = {
@@ -345,6 +395,8 @@ module_init(struct weston_compositor *ec,
     init_ivi_shell(ec, shell);
 
     weston_layout_initWithCompositor(ec);
+    weston_layout_setNotificationSurfaceVisibility(surface_visibility_changed,
+                                                   shell);
 
     shell->destroy_listener.notify = shell_destroy;
     wl_signal_add(&ec->destroy_signal, &shell->destroy_listener);
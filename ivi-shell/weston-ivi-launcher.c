@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Launcher zygote of homescreen of hmi-controller, enabled by
+ * launcher-zygote in weston.ini. homescreen forks and execs it once at
+ * startup with a socket at LAUNCHER_ZYGOTE_FD, and it launches applications
+ * on request. It is a small single-threaded process, so it can vfork on
+ * every tap, and the cost of a launch doesn't depend on the address space
+ * of weston.
+ *
+ * A request is a message of path and arguments separated by '\0'. pid of
+ * the launched process is sent back. It exits when homescreen closes the
+ * socket.
+ */
+
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <errno.h>
+#include "hmi-controller-homescreen.h"
+
+extern char **environ; /*defied by libc */
+
+static void
+close_fds(int keep_fd)
+{
+    DIR *dir = opendir("/proc/self/fd");
+    struct dirent *entry = NULL;
+    int fd = -1;
+
+    if (NULL == dir) {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        fd = atoi(entry->d_name);
+        if (fd <= STDERR_FILENO || fd == keep_fd || fd == dirfd(dir)) {
+            continue;
+        }
+        close(fd);
+    }
+
+    closedir(dir);
+}
+
+/* applications are reaped as soon as they exit */
+static void
+sigchld_handler(int signum)
+{
+    int saved_errno = errno;
+
+    (void)signum;
+
+    while (waitpid(-1, NULL, WNOHANG) > 0) {
+        continue;
+    }
+
+    errno = saved_errno;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char msg[LAUNCHER_ZYGOTE_MSG_SIZE];
+    char *args[LAUNCHER_ZYGOTE_MAX_ARGS + 1];
+    struct sigaction sa;
+    sigset_t mask;
+    ssize_t len = 0;
+    char *p = NULL;
+    int32_t count = 0;
+    pid_t pid = 0;
+    int fd = LAUNCHER_ZYGOTE_FD;
+
+    (void)argc;
+    (void)argv;
+
+    close_fds(fd);
+
+    /* weston blocks signals handled by its event loop */
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, NULL);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sigchld_handler;
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGCHLD, &sa, NULL);
+
+    for (;;) {
+        len = recv(fd, msg, sizeof(msg) - 1, 0);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            return 0;
+        }
+        msg[len] = '\0';
+
+        count = 0;
+        for (p = msg; p < msg + len && count < LAUNCHER_ZYGOTE_MAX_ARGS;
+             p += strlen(p) + 1) {
+            args[count++] = p;
+        }
+        args[count] = NULL;
+
+        pid = vfork();
+        if (0 == pid) {
+            execve(args[0], &args[1], environ);
+            _exit(1);
+        }
+
+        while (send(fd, &pid, sizeof(pid), 0) < 0 && errno == EINTR) {
+            continue;
+        }
+    }
+}
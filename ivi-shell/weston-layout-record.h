@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * File format of weston-layout API call recording, see
+ * weston_layout_startRecording.
+ *
+ * A file starts with struct weston_layout_RecordHeader, followed by one
+ * struct weston_layout_Record per call. Each record is followed by
+ * argCount arguments of 32 bits in host byte order. Surfaces, layers and
+ * screens are referred to by their id, and float is stored as its bit
+ * pattern. Arguments of each opcode are:
+ *
+ * - SURFACE_CREATE:        id_surface
+ * - SURFACE_NATIVE_CONTENT: id_surface, has content, width, height
+ * - SURFACE_CONFIGURE:     id_surface, width, height
+ * - SURFACE_REMOVE:        id_surface
+ * - SURFACE_VISIBILITY:    id_surface, visibility
+ * - SURFACE_OPACITY:       id_surface, opacity
+ * - SURFACE_SOURCE_RECT:   id_surface, x, y, width, height
+ * - SURFACE_DEST_RECT:     id_surface, x, y, width, height
+ * - SURFACE_DIMENSION:     id_surface, width, height
+ * - SURFACE_POSITION:      id_surface, x, y
+ * - SURFACE_ORIENTATION:   id_surface, orientation
+ * - SURFACE_CHROMA_KEY:    id_surface, enabled, red, green, blue
+ * - LAYER_CREATE:          id_layer, width, height
+ * - LAYER_REMOVE:          id_layer
+ * - LAYER_VISIBILITY ... LAYER_CHROMA_KEY: same as SURFACE_* with id_layer
+ * - LAYER_RENDER_ORDER:    id_layer, id_surface...
+ * - LAYER_RENDER_CACHE:    id_layer, enabled
+ * - LAYER_ADD_SURFACE:     id_layer, id_surface
+ * - LAYER_REMOVE_SURFACE:  id_layer, id_surface
+ * - SCREEN_ADD_LAYER:      id_screen, id_layer
+ * - SCREEN_RENDER_ORDER:   id_screen, id_layer...
+ * - SCREEN_OPTIMIZATION:   id_screen, id, mode
+ * - OPTIMIZATION:          id, mode
+ * - COMMIT:                no argument
+ */
+
+#ifndef _WESTON_LAYOUT_RECORD_H_
+#define _WESTON_LAYOUT_RECORD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#define WESTON_LAYOUT_RECORD_MAGIC   0x524c5649 /* "IVLR" */
+#define WESTON_LAYOUT_RECORD_VERSION 1
+
+enum weston_layout_record_opcode {
+    WESTON_LAYOUT_RECORD_SURFACE_CREATE           = 1,
+    WESTON_LAYOUT_RECORD_SURFACE_NATIVE_CONTENT   = 2,
+    WESTON_LAYOUT_RECORD_SURFACE_CONFIGURE        = 3,
+    WESTON_LAYOUT_RECORD_SURFACE_REMOVE           = 4,
+    WESTON_LAYOUT_RECORD_SURFACE_VISIBILITY       = 5,
+    WESTON_LAYOUT_RECORD_SURFACE_OPACITY          = 6,
+    WESTON_LAYOUT_RECORD_SURFACE_SOURCE_RECT      = 7,
+    WESTON_LAYOUT_RECORD_SURFACE_DEST_RECT        = 8,
+    WESTON_LAYOUT_RECORD_SURFACE_DIMENSION        = 9,
+    WESTON_LAYOUT_RECORD_SURFACE_POSITION         = 10,
+    WESTON_LAYOUT_RECORD_SURFACE_ORIENTATION      = 11,
+    WESTON_LAYOUT_RECORD_SURFACE_CHROMA_KEY       = 12,
+    WESTON_LAYOUT_RECORD_LAYER_CREATE             = 32,
+    WESTON_LAYOUT_RECORD_LAYER_REMOVE             = 33,
+    WESTON_LAYOUT_RECORD_LAYER_VISIBILITY         = 34,
+    WESTON_LAYOUT_RECORD_LAYER_OPACITY            = 35,
+    WESTON_LAYOUT_RECORD_LAYER_SOURCE_RECT        = 36,
+    WESTON_LAYOUT_RECORD_LAYER_DEST_RECT          = 37,
+    WESTON_LAYOUT_RECORD_LAYER_DIMENSION          = 38,
+    WESTON_LAYOUT_RECORD_LAYER_POSITION           = 39,
+    WESTON_LAYOUT_RECORD_LAYER_ORIENTATION        = 40,
+    WESTON_LAYOUT_RECORD_LAYER_CHROMA_KEY         = 41,
+    WESTON_LAYOUT_RECORD_LAYER_RENDER_ORDER       = 42,
+    WESTON_LAYOUT_RECORD_LAYER_RENDER_CACHE       = 43,
+    WESTON_LAYOUT_RECORD_LAYER_ADD_SURFACE        = 44,
+    WESTON_LAYOUT_RECORD_LAYER_REMOVE_SURFACE     = 45,
+    WESTON_LAYOUT_RECORD_SCREEN_ADD_LAYER         = 64,
+    WESTON_LAYOUT_RECORD_SCREEN_RENDER_ORDER      = 65,
+    WESTON_LAYOUT_RECORD_SCREEN_OPTIMIZATION      = 66,
+    WESTON_LAYOUT_RECORD_OPTIMIZATION             = 67,
+    WESTON_LAYOUT_RECORD_COMMIT                   = 96
+};
+
+struct weston_layout_RecordHeader
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+/**
+ * timeDelta is microseconds since the previous record, or since start of
+ * the recording for the first one.
+ */
+struct weston_layout_Record
+{
+    uint16_t opcode;
+    uint16_t argCount;
+    uint32_t timeDelta;
+};
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* _WESTON_LAYOUT_RECORD_H_ */
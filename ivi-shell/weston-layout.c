@@ -29,14 +29,16 @@
  *    with (struct weston_compositor *ec) from ivi-shell.
  * 1/ When a API for updating properties of surface/layer, it updates
  *    pending prop of weston_layout_surface/layer/screen which are structure to
- *    store properties.
+ *    store properties, and registers the object to dirty list of layout.
  * 2/ Before calling commitChanges, in case of calling a API to get a property,
  *    return current property, not pending property.
  * 3/ At the timing of calling weston_layout_commitChanges, pending properties
- *    are applied
- *    to properties.
- * 4/ According properties, set transformation by using weston_matrix and
- *    weston_view per surfaces and layers in while loop.
+ *    of objects in dirty list are applied to properties. Objects without
+ *    changes are not visited. Views of visible surfaces are linked to
+ *    weston_layer of the screen, which is bound to output of the screen.
+ * 4/ According properties, calculate one weston_matrix per surface which
+ *    combines properties of the surface and its layer, and set it to
+ *    weston_view. It is calculated only when geometry is changed.
  * 5/ Set damage and trigger transform by using weston_view_geometry_dirty and
  *    weston_view_geometry_dirty.
  * 6/ Notify update of properties.
@@ -44,16 +46,24 @@
  *
  */
 
+#include "config.h"
+
 #include <sys/wait.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+#include <math.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <linux/input.h>
 #include <cairo.h>
 
 #include "compositor.h"
 #include "weston-layout.h"
+#include "weston-layout-record.h"
 
 enum weston_layout_surface_orientation {
     WESTON_LAYOUT_SURFACE_ORIENTATION_0_DEGREES   = 0,
@@ -125,10 +135,44 @@ struct link_surfaceConfigureNotification {
     struct wl_list link;
 };
 
+struct link_surfaceVisibilityNotification {
+    surfaceVisibilityNotificationFunc callback;
+    void *userdata;
+    struct wl_list link;
+};
+
+struct link_commitNotification {
+    commitNotificationFunc callback;
+    void *userdata;
+    uint32_t mask;
+    /* removed during delivery, freed when delivery is done */
+    int32_t removed;
+    struct wl_list link;
+};
+
+/**
+ * Index to look up surface/layer/screen from its id. Each object embeds an
+ * entry which is registered together with insertion to the list of
+ * weston_layout, so that both are always kept in sync.
+ */
+struct id_hash_entry {
+    uint32_t id;
+    struct wl_list link;
+};
+
+struct id_hash {
+    struct wl_list *buckets;
+    uint32_t size;
+    uint32_t count;
+};
+
+#define ID_HASH_INITIAL_SIZE 64
+
 struct weston_layout;
 
 struct weston_layout_surface {
     struct wl_list link;
+    struct id_hash_entry hash;
     struct wl_list list_notification;
     struct wl_list list_layer;
     uint32_t update_count;
@@ -137,19 +181,29 @@ struct weston_layout_surface {
     struct weston_layout *layout;
     struct weston_surface *surface;
     struct weston_view *view;
+    /* output of the screen which the view is shown on */
+    struct weston_output *output;
 
     uint32_t buffer_width;
     uint32_t buffer_height;
+    /* whether the view is in the view list of a screen */
+    int32_t visible;
 
     struct wl_listener surface_destroy_listener;
-    struct weston_transform surface_rotation;
-    struct weston_transform layer_rotation;
-    struct weston_transform surface_pos;
-    struct weston_transform layer_pos;
-    struct weston_transform scaling;
+    struct wl_listener surface_commit_listener;
+    /* combined transformation of surface and layer properties */
+    struct weston_transform layout_transform;
     struct weston_layout_SurfaceProperties prop;
     int32_t pixelformat;
     uint32_t event_mask;
+    struct wl_list dirty_link;
+
+    /* geometry of the surface which the view list was culled with */
+    struct {
+        int32_t width;
+        int32_t height;
+        pixman_region32_t opaque;
+    } occlusion;
 
     struct {
         struct weston_layout_SurfaceProperties prop;
@@ -164,6 +218,7 @@ struct weston_layout_surface {
 
 struct weston_layout_layer {
     struct wl_list link;
+    struct id_hash_entry hash;
     struct wl_list list_notification;
     struct wl_list list_screen;
     uint32_t id_layer;
@@ -172,11 +227,25 @@ struct weston_layout_layer {
 
     struct weston_layout_LayerProperties prop;
     uint32_t event_mask;
+    struct wl_list dirty_link;
+
+    /* surfaces composited into one image, see build_layer_cache */
+    struct {
+        int32_t enabled;
+        int32_t valid;
+        uint32_t static_frames;
+        struct weston_surface *surface;
+        struct weston_view *view;
+        /* screen where the view is linked while valid */
+        struct weston_layout_screen *iviscrn;
+        struct weston_layout_RenderCacheStatistics stats;
+    } cache;
 
     struct {
         struct weston_layout_LayerProperties prop;
         struct wl_list list_surface;
         struct wl_list link;
+        int32_t cache_enabled;
     } pending;
 
     struct {
@@ -187,16 +256,31 @@ struct weston_layout_layer {
 
 struct weston_layout_screen {
     struct wl_list link;
+    struct id_hash_entry hash;
     uint32_t id_screen;
 
     struct weston_layout *layout;
     struct weston_output *output;
+    /* views of this screen in render order, bound to output */
+    struct weston_layer layout_layer;
+    /* views left in layout_layer by the last arrange_view_list */
+    struct wl_array arranged_views;
+    /* counts and builds render cache of layers after each repaint */
+    struct wl_listener frame_listener;
+    /* the screen is destroyed with its output */
+    struct wl_listener output_destroy_listener;
+
+    uint32_t optimization_mode[IVI_OPTIMIZATION_COUNT];
+    /* IVI_BIT of optimizations in effect */
+    uint32_t optimization_state;
 
     uint32_t event_mask;
+    struct wl_list dirty_link;
 
     struct {
         struct wl_list list_layer;
         struct wl_list link;
+        uint32_t optimization_mode[IVI_OPTIMIZATION_COUNT];
     } pending;
 
     struct {
@@ -205,6 +289,35 @@ struct weston_layout_screen {
     } order;
 };
 
+struct screenshot_buffer {
+    struct wl_list link;
+    size_t size;
+    uint8_t *data;
+};
+
+struct screenshot_job {
+    struct wl_list link;
+    struct weston_layout_screen *iviscrn;
+    char *filename;
+    screenshotDoneFunc callback;
+    void *userdata;
+    struct wl_listener frame_listener;
+    /* waiting for frame_listener */
+    int reading;
+    /* in screenshot.list_job until finished, on compositor thread */
+    struct wl_list job_link;
+
+    struct screenshot_buffer *buffer;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    int yflip;
+    int swap_rb;
+    int32_t result;
+};
+
+#define SCREENSHOT_BUFFER_POOL_SIZE 2
+
 struct weston_layout {
     struct weston_compositor *compositor;
 
@@ -212,6 +325,46 @@ struct weston_layout {
     struct wl_list list_layer;
     struct wl_list list_screen;
 
+    struct id_hash hash_surface;
+    struct id_hash hash_layer;
+    struct id_hash hash_screen;
+    /* a screen is created for each output plugged */
+    struct wl_listener output_created_listener;
+
+    /* objects which have pending changes to be applied by next commit */
+    struct {
+        struct wl_list list_surface;
+        struct wl_list list_layer;
+        struct wl_list list_screen;
+        int view_list;
+        int cull;
+    } dirty;
+    /* views were culled or bypassed by the last arrange_view_list */
+    int view_list_culled;
+
+    struct weston_layout_CommitStatistics commit_stats;
+
+    /* set by weston_layout_SetOptimizationMode */
+    uint32_t optimization_mode[IVI_OPTIMIZATION_COUNT];
+
+    /* png encoding of screenshot is done by worker thread */
+    struct {
+        int started;
+        int stop;                       /* protected by mutex */
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t input_cond;
+        struct wl_list list_input;      /* protected by mutex */
+        struct wl_list list_done;       /* protected by mutex */
+        struct wl_list list_job;        /* all jobs not finished */
+        struct wl_list list_buffer;     /* free buffers */
+        uint32_t buffer_count;
+        int readfd;
+        int writefd;
+        struct wl_event_source *done_source;
+        struct wl_listener destroy_listener;
+    } screenshot;
+
     struct {
         struct wl_list list_create;
         struct wl_list list_remove;
@@ -221,9 +374,31 @@ struct weston_layout {
         struct wl_list list_create;
         struct wl_list list_remove;
         struct wl_list list_configure;
+        struct wl_list list_visibility;
     } surface_notification;
 
-    struct weston_layer layout_layer;
+    /*
+     * Changes of a commit. The second half of entries is work area to
+     * filter them by mask of each notification.
+     */
+    struct {
+        struct wl_list list;
+        struct weston_layout_ChangeEntry *entries;
+        uint32_t length;
+        uint32_t capacity;
+        /* entries being delivered, to forget removed objects */
+        struct weston_layout_ChangeEntry *sending;
+        uint32_t sending_length;
+        /* depth of nested delivery, notifications are not freed if > 0 */
+        uint32_t delivering;
+    } commit_notification;
+
+    /* set by weston_layout_startRecording */
+    struct {
+        FILE *file;
+        uint64_t time;
+        struct wl_listener destroy_listener;
+    } record;
 };
 
 struct weston_layout ivilayout = {0};
@@ -269,6 +444,48 @@ remove_ordersurface_from_layer(struct weston_layout_surface *ivisurf)
     wl_list_init(&ivisurf->list_layer);
 }
 
+static void
+remove_link_layer(struct weston_layout_surface *ivisurf,
+                  struct weston_layout_layer *ivilayer)
+{
+    struct link_layer *link_layer = NULL;
+    struct link_layer *next = NULL;
+
+    wl_list_for_each_safe(link_layer, next, &ivisurf->list_layer, link) {
+        if (link_layer->ivilayer == ivilayer) {
+            wl_list_remove(&link_layer->link);
+            free(link_layer);
+        }
+    }
+}
+
+/**
+ * Called when a layer is removed, so that no surface refers to it nor is
+ * linked in its lists of surfaces any longer.
+ */
+static void
+remove_layer_from_surfaces(struct weston_layout_layer *ivilayer)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+    struct weston_layout_surface *next = NULL;
+
+    wl_list_for_each_safe(ivisurf, next, &ivilayer->order.list_surface,
+                          order.link) {
+        remove_link_layer(ivisurf, ivilayer);
+        wl_list_remove(&ivisurf->order.link);
+        wl_list_init(&ivisurf->order.link);
+    }
+    wl_list_init(&ivilayer->order.list_surface);
+
+    wl_list_for_each_safe(ivisurf, next, &ivilayer->pending.list_surface,
+                          pending.link) {
+        remove_link_layer(ivisurf, ivilayer);
+        wl_list_remove(&ivisurf->pending.link);
+        wl_list_init(&ivisurf->pending.link);
+    }
+    wl_list_init(&ivilayer->pending.list_surface);
+}
+
 /**
  * Internal API to add/remove a layer from screen.
  */
@@ -305,30 +522,100 @@ remove_orderlayer_from_screen(struct weston_layout_layer *ivilayer)
 }
 
 /**
- * Internal API to add/remove a layer from screen.
+ * Internal APIs to maintain the id index of surface/layer/screen.
+ * The number of buckets is always a power of two, and doubled when the
+ * average length of chain exceeds two.
  */
-static struct weston_layout_surface *
-get_surface(struct wl_list *list_surf, uint32_t id_surface)
+static uint32_t
+id_hash_bucket(struct id_hash *hash, uint32_t id)
 {
-    struct weston_layout_surface *ivisurf;
+    /* ids are often allocated as base + n, so mix upper bits into lower */
+    id ^= id >> 16;
+    id *= 0x45d9f3b;
+    id ^= id >> 16;
 
-    wl_list_for_each(ivisurf, list_surf, link) {
-        if (ivisurf->id_surface == id_surface) {
-            return ivisurf;
+    return id & (hash->size - 1);
+}
+
+static int
+id_hash_resize(struct id_hash *hash, uint32_t size)
+{
+    struct wl_list *buckets = NULL;
+    struct wl_list *old_buckets = hash->buckets;
+    uint32_t old_size = hash->size;
+    struct id_hash_entry *entry = NULL;
+    struct id_hash_entry *next = NULL;
+    uint32_t i = 0;
+
+    buckets = malloc(size * sizeof *buckets);
+    if (buckets == NULL) {
+        weston_log("fails to allocate memory\n");
+        return -1;
+    }
+
+    for (i = 0; i < size; i++) {
+        wl_list_init(&buckets[i]);
+    }
+
+    hash->buckets = buckets;
+    hash->size = size;
+
+    for (i = 0; i < old_size; i++) {
+        wl_list_for_each_safe(entry, next, &old_buckets[i], link) {
+            wl_list_remove(&entry->link);
+            wl_list_insert(&buckets[id_hash_bucket(hash, entry->id)],
+                           &entry->link);
         }
     }
 
-    return NULL;
+    free(old_buckets);
+
+    return 0;
 }
 
-static struct weston_layout_layer *
-get_layer(struct wl_list *list_layer, uint32_t id_layer)
+static int
+id_hash_insert(struct id_hash *hash, struct id_hash_entry *entry, uint32_t id)
 {
-    struct weston_layout_layer *ivilayer;
+    if (hash->buckets == NULL) {
+        if (id_hash_resize(hash, ID_HASH_INITIAL_SIZE) != 0) {
+            return -1;
+        }
+    } else if (hash->count >= hash->size * 2) {
+        /* keep current buckets if it fails, lookup is just slower */
+        id_hash_resize(hash, hash->size * 2);
+    }
+
+    entry->id = id;
+    wl_list_insert(&hash->buckets[id_hash_bucket(hash, id)], &entry->link);
+    hash->count++;
+
+    return 0;
+}
+
+static void
+id_hash_remove(struct id_hash *hash, struct id_hash_entry *entry)
+{
+    if (wl_list_empty(&entry->link)) {
+        return;
+    }
+
+    wl_list_remove(&entry->link);
+    wl_list_init(&entry->link);
+    hash->count--;
+}
+
+static struct id_hash_entry *
+id_hash_lookup(struct id_hash *hash, uint32_t id)
+{
+    struct id_hash_entry *entry = NULL;
 
-    wl_list_for_each(ivilayer, list_layer, link) {
-        if (ivilayer->id_layer == id_layer) {
-            return ivilayer;
+    if (hash->buckets == NULL) {
+        return NULL;
+    }
+
+    wl_list_for_each(entry, &hash->buckets[id_hash_bucket(hash, id)], link) {
+        if (entry->id == id) {
+            return entry;
         }
     }
 
@@ -336,557 +623,2586 @@ get_layer(struct wl_list *list_layer, uint32_t id_layer)
 }
 
 /**
- * Called at destruction of ivi_surface
+ * Internal API to find surface/layer/screen from its id.
  */
-static void
-westonsurface_destroy_from_ivisurface(struct wl_listener *listener, void *data)
+static struct weston_layout_surface *
+get_surface(struct weston_layout *layout, uint32_t id_surface)
 {
-    struct weston_layout_surface *ivisurf = NULL;
+    struct id_hash_entry *entry = NULL;
 
-    ivisurf = container_of(listener, struct weston_layout_surface,
-                           surface_destroy_listener);
-    ivisurf->surface = NULL;
-    ivisurf->view = NULL;
+    entry = id_hash_lookup(&layout->hash_surface, id_surface);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    return container_of(entry, struct weston_layout_surface, hash);
 }
 
-/**
- * Internal API to check layer/surface already added in layer/screen.
- * Called by weston_layout_layerAddSurface/weston_layout_screenAddLayer
- */
-static int
-is_surface_in_layer(struct weston_layout_surface *ivisurf,
-                    struct weston_layout_layer *ivilayer)
+static struct weston_layout_layer *
+get_layer(struct weston_layout *layout, uint32_t id_layer)
 {
-    struct weston_layout_surface *surf = NULL;
+    struct id_hash_entry *entry = NULL;
 
-    wl_list_for_each(surf, &ivilayer->pending.list_surface, pending.link) {
-        if (surf->id_surface == ivisurf->id_surface) {
-            return 1;
-        }
+    entry = id_hash_lookup(&layout->hash_layer, id_layer);
+    if (entry == NULL) {
+        return NULL;
     }
 
-    return 0;
+    return container_of(entry, struct weston_layout_layer, hash);
 }
 
-static int
-is_layer_in_screen(struct weston_layout_layer *ivilayer,
-                    struct weston_layout_screen *iviscrn)
+static struct weston_layout_screen *
+get_screen(struct weston_layout *layout, uint32_t id_screen)
 {
-    struct weston_layout_layer *layer = NULL;
+    struct id_hash_entry *entry = NULL;
 
-    wl_list_for_each(layer, &iviscrn->pending.list_layer, pending.link) {
-        if (layer->id_layer == ivilayer->id_layer) {
-            return 1;
-        }
+    entry = id_hash_lookup(&layout->hash_screen, id_screen);
+    if (entry == NULL) {
+        return NULL;
     }
 
-    return 0;
+    return container_of(entry, struct weston_layout_screen, hash);
 }
 
 /**
- * Internal API to initialize screens found from output_list of weston_compositor.
- * Called by weston_layout_initWithCompositor.
+ * Internal APIs to register surface/layer/screen which has pending changes.
+ * Only registered objects are visited by weston_layout_commitChanges.
+ * Changes of visibility and render order require to build the view list
+ * again. Changes of geometry and opacity only require to cull it again.
  */
+#define VIEW_LIST_NOTIFICATION_MASK \
+    (IVI_NOTIFICATION_VISIBILITY | IVI_NOTIFICATION_ADD | \
+     IVI_NOTIFICATION_REMOVE)
+
+#define CULL_NOTIFICATION_MASK \
+    (IVI_NOTIFICATION_OPACITY | IVI_NOTIFICATION_SOURCE_RECT | \
+     IVI_NOTIFICATION_DEST_RECT | IVI_NOTIFICATION_DIMENSION | \
+     IVI_NOTIFICATION_POSITION | IVI_NOTIFICATION_ORIENTATION | \
+     IVI_NOTIFICATION_CHROMA_KEY)
+
 static void
-create_screen(struct weston_compositor *ec)
+mark_surface_dirty(struct weston_layout_surface *ivisurf, uint32_t mask)
 {
-    struct weston_layout *layout = get_instance();
-    struct weston_layout_screen *iviscrn = NULL;
-    struct weston_output *output = NULL;
-    int32_t count = 0;
+    struct weston_layout *layout = ivisurf->layout;
 
-    wl_list_for_each(output, &ec->output_list, link) {
-        iviscrn = calloc(1, sizeof *iviscrn);
-        if (iviscrn == NULL) {
-            weston_log("fails to allocate memory\n");
-            continue;
-        }
+    ivisurf->event_mask |= mask;
+    if (mask & VIEW_LIST_NOTIFICATION_MASK) {
+        layout->dirty.view_list = 1;
+    }
+    if (mask & CULL_NOTIFICATION_MASK) {
+        layout->dirty.cull = 1;
+    }
 
-        wl_list_init(&iviscrn->link);
-        iviscrn->layout = layout;
+    if (wl_list_empty(&ivisurf->dirty_link)) {
+        wl_list_insert(layout->dirty.list_surface.prev, &ivisurf->dirty_link);
+    }
+}
 
-        iviscrn->id_screen = count;
-        count++;
+static void
+mark_layer_dirty(struct weston_layout_layer *ivilayer, uint32_t mask)
+{
+    struct weston_layout *layout = ivilayer->layout;
 
-        iviscrn->output = output;
-        iviscrn->event_mask = 0;
+    ivilayer->event_mask |= mask;
+    if (mask & VIEW_LIST_NOTIFICATION_MASK) {
+        layout->dirty.view_list = 1;
+    }
+    if (mask & CULL_NOTIFICATION_MASK) {
+        layout->dirty.cull = 1;
+    }
 
-        wl_list_init(&iviscrn->pending.list_layer);
-        wl_list_init(&iviscrn->pending.link);
+    if (wl_list_empty(&ivilayer->dirty_link)) {
+        wl_list_insert(layout->dirty.list_layer.prev, &ivilayer->dirty_link);
+    }
+}
+
+static void
+mark_screen_dirty(struct weston_layout_screen *iviscrn, uint32_t mask)
+{
+    struct weston_layout *layout = iviscrn->layout;
 
-        wl_list_init(&iviscrn->order.list_layer);
-        wl_list_init(&iviscrn->order.link);
+    iviscrn->event_mask |= mask;
+    if (mask & VIEW_LIST_NOTIFICATION_MASK) {
+        layout->dirty.view_list = 1;
+    }
+    /* optimization modes are applied by culling */
+    layout->dirty.cull = 1;
 
-        wl_list_insert(&layout->list_screen, &iviscrn->link);
+    if (wl_list_empty(&iviscrn->dirty_link)) {
+        wl_list_insert(layout->dirty.list_screen.prev, &iviscrn->dirty_link);
     }
 }
 
 /**
- * Internal APIs to initialize properties of surface/layer when they are created.
+ * Internal APIs for render cache of layer. When surfaces of a layer shown
+ * on a screen are unchanged during LAYER_CACHE_STATIC_FRAMES repaints, they
+ * are composited into one image which is shown by a view just above them.
+ * Their views stay in the view list for input and frame callbacks, but
+ * renderers skip them until the cache is invalidated.
  */
+#define LAYER_CACHE_STATIC_FRAMES 10
+
+static pixman_image_t *
+read_surface_image(struct weston_layout_surface *ivisurf);
+
 static void
-init_layerProperties(struct weston_layout_LayerProperties *prop,
-                     int32_t width, int32_t height)
+build_view_list(struct weston_layout *layout);
+
+static void
+clear_view_list(struct weston_layer *layer);
+
+static uint32_t
+arrange_view_list(struct weston_layout *layout);
+
+static void
+layer_cache_configure(struct weston_surface *surface, int32_t sx, int32_t sy)
 {
-    memset(prop, 0, sizeof *prop);
-    prop->opacity = wl_fixed_from_double(1.0);
-    prop->sourceWidth = width;
-    prop->sourceHeight = height;
-    prop->destWidth = width;
-    prop->destHeight = height;
+    /* content is given by build_layer_cache, never by client */
 }
 
-static void
-init_surfaceProperties(struct weston_layout_SurfaceProperties *prop)
+static int
+is_layer_cache_view(struct weston_view *view)
 {
-    memset(prop, 0, sizeof *prop);
-    prop->opacity = wl_fixed_from_double(1.0);
+    return view->surface->configure == layer_cache_configure;
+}
+
+static int
+is_layer_cache_member(struct weston_layout_surface *ivisurf,
+                      struct weston_layout_screen *iviscrn)
+{
+    return ivisurf->prop.visibility != 0 &&
+           ivisurf->surface != NULL && ivisurf->view != NULL &&
+           ivisurf->output == iviscrn->output &&
+           !wl_list_empty(&ivisurf->view->layer_link);
+}
+
+static int
+is_view_cacheable(struct weston_view *view)
+{
+    struct weston_surface *surface = view->surface;
+
+    return view->plane == &surface->compositor->primary_plane &&
+           !view->chroma_key.enabled &&
+           !surface->buffer_viewport.viewport_set &&
+           surface->buffer_viewport.transform == WL_OUTPUT_TRANSFORM_NORMAL;
 }
 
 /**
- * Internal APIs to be called from weston_layout_commitChanges.
+ * Return the number of surfaces of the layer shown on the screen, or -1
+ * if any of them can not be drawn into the cached image.
  */
-static void
-update_opacity(struct weston_layout_layer *ivilayer,
-               struct weston_layout_surface *ivisurf)
+static int32_t
+count_layer_cache_members(struct weston_layout_layer *ivilayer,
+                          struct weston_layout_screen *iviscrn)
 {
-    double layer_alpha = wl_fixed_to_double(ivilayer->prop.opacity);
-    double surf_alpha  = wl_fixed_to_double(ivisurf->prop.opacity);
+    struct weston_layout_surface *ivisurf = NULL;
+    int32_t count = 0;
 
-    if ((ivilayer->event_mask & IVI_NOTIFICATION_OPACITY) ||
-        (ivisurf->event_mask  & IVI_NOTIFICATION_OPACITY)) {
-        if (ivisurf->view == NULL) {
-            return;
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (!is_layer_cache_member(ivisurf, iviscrn)) {
+            continue;
         }
-        ivisurf->view->alpha = layer_alpha * surf_alpha;
+
+        /* a surface shared with other layers is drawn by one of them */
+        if (!is_view_cacheable(ivisurf->view) ||
+            ivisurf->list_layer.next != ivisurf->list_layer.prev) {
+            return -1;
+        }
+
+        count++;
     }
+
+    return count;
 }
 
 static void
-update_surface_orientation(struct weston_layout_layer *ivilayer,
-                           struct weston_layout_surface *ivisurf)
+invalidate_layer_cache(struct weston_layout_layer *ivilayer)
 {
-    struct weston_view *view = ivisurf->view;
-    struct weston_matrix  *matrix = &ivisurf->surface_rotation.matrix;
-    float width  = 0.0f;
-    float height = 0.0f;
-    float v_sin  = 0.0f;
-    float v_cos  = 0.0f;
-    float cx = 0.0f;
-    float cy = 0.0f;
-    float sx = 1.0f;
-    float sy = 1.0f;
+    struct weston_layout_surface *ivisurf = NULL;
+    struct weston_view *view = ivilayer->cache.view;
 
-    if (view == NULL) {
+    ivilayer->cache.static_frames = 0;
+
+    if (!ivilayer->cache.valid) {
         return;
     }
 
-    if ((ivilayer->prop.destWidth == 0) ||
-        (ivilayer->prop.destHeight == 0)) {
-        return;
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (ivisurf->view != NULL) {
+            ivisurf->view->cached = 0;
+        }
     }
-    width  = (float)ivilayer->prop.destWidth;
-    height = (float)ivilayer->prop.destHeight;
 
-    switch (ivisurf->prop.orientation) {
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_0_DEGREES:
-        v_sin = 0.0f;
-        v_cos = 1.0f;
-        break;
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_90_DEGREES:
-        v_sin = 1.0f;
-        v_cos = 0.0f;
-        sx = width / height;
-        sy = height / width;
-        break;
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_180_DEGREES:
-        v_sin = 0.0f;
-        v_cos = -1.0f;
-        break;
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_270_DEGREES:
-    default:
-        v_sin = -1.0f;
-        v_cos = 0.0f;
-        sx = width / height;
-        sy = height / width;
-        break;
+    if (!wl_list_empty(&view->layer_link)) {
+        weston_view_damage_below(view);
+        wl_list_remove(&view->layer_link);
+        wl_list_init(&view->layer_link);
+        weston_compositor_scene_changed(view->surface->compositor);
     }
-    wl_list_remove(&ivisurf->surface_rotation.link);
-    weston_view_geometry_dirty(view);
-
-    weston_matrix_init(matrix);
-    cx = 0.5f * width;
-    cy = 0.5f * height;
-    weston_matrix_translate(matrix, -cx, -cy, 0.0f);
-    weston_matrix_rotate_xy(matrix, v_cos, v_sin);
-    weston_matrix_scale(matrix, sx, sy, 1.0);
-    weston_matrix_translate(matrix, cx, cy, 0.0f);
-    wl_list_insert(&view->geometry.transformation_list,
-                   &ivisurf->surface_rotation.link);
 
-    weston_view_set_transform_parent(view, NULL);
-    weston_view_update_transform(view);
+    ivilayer->cache.valid = 0;
+    ivilayer->cache.iviscrn = NULL;
 }
 
 static void
-update_layer_orientation(struct weston_layout_layer *ivilayer,
-                         struct weston_layout_surface *ivisurf)
+invalidate_surface_layer_caches(struct weston_layout_surface *ivisurf)
 {
-    struct weston_surface *es = ivisurf->surface;
-    struct weston_view    *view = ivisurf->view;
-    struct weston_matrix  *matrix = &ivisurf->layer_rotation.matrix;
-    struct weston_output  *output = NULL;
-    float width  = 0.0f;
-    float height = 0.0f;
-    float v_sin  = 0.0f;
-    float v_cos  = 0.0f;
-    float cx = 0.0f;
-    float cy = 0.0f;
-    float sx = 1.0f;
-    float sy = 1.0f;
+    struct link_layer *link_layer = NULL;
 
-    if (es == NULL || view == NULL) {
-        return;
+    wl_list_for_each(link_layer, &ivisurf->list_layer, link) {
+        invalidate_layer_cache(link_layer->ivilayer);
     }
+}
 
-    output = es->output;
-    if (output == NULL) {
-        return;
+/**
+ * Called by weston_layout_commitChanges before pending changes are applied,
+ * so that layers are found by current render order.
+ */
+static void
+invalidate_dirty_layer_caches(struct weston_layout *layout)
+{
+    struct weston_layout_surface *ivisurf  = NULL;
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_screen  *iviscrn  = NULL;
+
+    wl_list_for_each(ivisurf, &layout->dirty.list_surface, dirty_link) {
+        invalidate_surface_layer_caches(ivisurf);
     }
-    if ((output->width == 0) || (output->height == 0)) {
-        return;
+
+    wl_list_for_each(ivilayer, &layout->dirty.list_layer, dirty_link) {
+        invalidate_layer_cache(ivilayer);
     }
-    width = (float)output->width;
-    height = (float)output->height;
 
-    switch (ivilayer->prop.orientation) {
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_0_DEGREES:
-        v_sin = 0.0f;
-        v_cos = 1.0f;
-        break;
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_90_DEGREES:
-        v_sin = 1.0f;
-        v_cos = 0.0f;
-        sx = width / height;
-        sy = height / width;
-        break;
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_180_DEGREES:
-        v_sin = 0.0f;
-        v_cos = -1.0f;
-        break;
-    case WESTON_LAYOUT_SURFACE_ORIENTATION_270_DEGREES:
-    default:
-        v_sin = -1.0f;
-        v_cos = 0.0f;
-        sx = width / height;
-        sy = height / width;
-        break;
+    wl_list_for_each(iviscrn, &layout->dirty.list_screen, dirty_link) {
+        wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+            invalidate_layer_cache(ivilayer);
+        }
+        wl_list_for_each(ivilayer, &iviscrn->pending.list_layer, pending.link) {
+            invalidate_layer_cache(ivilayer);
+        }
     }
-    wl_list_remove(&ivisurf->layer_rotation.link);
-    weston_view_geometry_dirty(view);
+}
 
-    weston_matrix_init(matrix);
-    cx = 0.5f * width;
-    cy = 0.5f * height;
-    weston_matrix_translate(matrix, -cx, -cy, 0.0f);
-    weston_matrix_rotate_xy(matrix, v_cos, v_sin);
-    weston_matrix_scale(matrix, sx, sy, 1.0);
-    weston_matrix_translate(matrix, cx, cy, 0.0f);
-    wl_list_insert(&view->geometry.transformation_list,
-                   &ivisurf->layer_rotation.link);
+/**
+ * The view list of the compositor is rebuilt only when the scene changed,
+ * and this may run from the frame signal, after the view list of this
+ * repaint was built. Without the damage, the cached members would not be
+ * drawn until something else repaints the output.
+ */
+static void
+insert_layer_cache_view(struct weston_layout_layer *ivilayer,
+                        struct wl_list *pos)
+{
+    struct weston_view *view = ivilayer->cache.view;
 
-    weston_view_set_transform_parent(view, NULL);
-    weston_view_update_transform(view);
+    wl_list_insert(pos, &view->layer_link);
+    weston_surface_damage(view->surface);
+    weston_compositor_scene_changed(view->surface->compositor);
 }
 
 static void
-update_surface_position(struct weston_layout_surface *ivisurf)
+destroy_layer_cache(struct weston_layout_layer *ivilayer)
 {
-    struct weston_view *view = ivisurf->view;
-    float tx  = (float)ivisurf->prop.destX;
-    float ty  = (float)ivisurf->prop.destY;
-    struct weston_matrix *matrix = &ivisurf->surface_pos.matrix;
+    invalidate_layer_cache(ivilayer);
 
-    if (view == NULL) {
-        return;
+    if (ivilayer->cache.surface != NULL) {
+        weston_surface_destroy(ivilayer->cache.surface);
+        ivilayer->cache.surface = NULL;
+        ivilayer->cache.view = NULL;
+    }
+}
+
+static int32_t
+create_layer_cache_surface(struct weston_layout_layer *ivilayer)
+{
+    struct weston_surface *surface = NULL;
+    struct weston_view *view = NULL;
+
+    surface = weston_surface_create(ivilayer->layout->compositor);
+    if (surface == NULL) {
+        weston_log("fails to allocate memory\n");
+        return -1;
     }
 
-    wl_list_remove(&ivisurf->surface_pos.link);
+    view = weston_view_create(surface);
+    if (view == NULL) {
+        weston_log("fails to allocate memory\n");
+        weston_surface_destroy(surface);
+        return -1;
+    }
 
-    weston_matrix_init(matrix);
-    weston_matrix_translate(matrix, tx, ty, 0.0f);
-    wl_list_insert(&view->geometry.transformation_list,
-                   &ivisurf->surface_pos.link);
+    surface->configure = layer_cache_configure;
+    surface->configure_private = ivilayer;
 
-    weston_view_set_transform_parent(view, NULL);
-    weston_view_update_transform(view);
+    /* input goes to the views of surfaces below */
+    pixman_region32_fini(&surface->input);
+    pixman_region32_init(&surface->input);
 
-#if 0
-    /* disable zoom animation */
-    weston_zoom_run(es, 0.0, 1.0, NULL, NULL);
-#endif
+    ivilayer->cache.surface = surface;
+    ivilayer->cache.view = view;
 
+    return 0;
 }
 
+/**
+ * Draw a view as renderer does, where (x, y) in global coordinates is the
+ * origin of image.
+ */
 static void
-update_layer_position(struct weston_layout_layer *ivilayer,
-               struct weston_layout_surface *ivisurf)
+draw_view_image(pixman_image_t *image, pixman_image_t *surf_image,
+                struct weston_view *view, int32_t x, int32_t y)
 {
-    struct weston_view *view = ivisurf->view;
-    struct weston_matrix *matrix = &ivisurf->layer_pos.matrix;
-    float tx  = (float)ivilayer->prop.destX;
-    float ty  = (float)ivilayer->prop.destY;
-
-    if (view == NULL) {
-        return;
+    struct weston_matrix *matrix = &view->transform.matrix;
+    double scale = view->surface->buffer_viewport.scale;
+    pixman_box32_t *bbox = pixman_region32_extents(&view->transform.boundingbox);
+    pixman_transform_t transform;
+    pixman_image_t *mask = NULL;
+    pixman_color_t color = {0};
+
+    pixman_transform_init_translate(&transform, pixman_int_to_fixed(x),
+                                    pixman_int_to_fixed(y));
+
+    if (view->transform.enabled) {
+        /* Pixman supports only 2D transform, Z coordinate is omitted */
+        pixman_transform_t surface_transform = {{
+            { pixman_double_to_fixed(matrix->d[0]),
+              pixman_double_to_fixed(matrix->d[4]),
+              pixman_double_to_fixed(matrix->d[12]) },
+            { pixman_double_to_fixed(matrix->d[1]),
+              pixman_double_to_fixed(matrix->d[5]),
+              pixman_double_to_fixed(matrix->d[13]) },
+            { pixman_double_to_fixed(matrix->d[3]),
+              pixman_double_to_fixed(matrix->d[7]),
+              pixman_double_to_fixed(matrix->d[15]) }
+        }};
+
+        pixman_transform_invert(&surface_transform, &surface_transform);
+        pixman_transform_multiply(&transform, &surface_transform, &transform);
+        pixman_image_set_filter(surf_image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    } else {
+        pixman_transform_translate(&transform, NULL,
+                                   pixman_double_to_fixed(-view->geometry.x),
+                                   pixman_double_to_fixed(-view->geometry.y));
+    }
+
+    pixman_transform_scale(&transform, NULL,
+                           pixman_double_to_fixed(scale),
+                           pixman_double_to_fixed(scale));
+    pixman_image_set_transform(surf_image, &transform);
+
+    if (view->alpha < 1.0) {
+        color.alpha = (uint16_t)(view->alpha * 0xffff);
+        mask = pixman_image_create_solid_fill(&color);
+    }
+
+    /* nothing is drawn out of bounding box, which is the crop if any */
+    pixman_image_composite32(PIXMAN_OP_OVER, surf_image, mask, image,
+                             bbox->x1 - x, bbox->y1 - y, 0, 0,
+                             bbox->x1 - x, bbox->y1 - y,
+                             bbox->x2 - bbox->x1, bbox->y2 - bbox->y1);
+
+    if (mask != NULL) {
+        pixman_image_unref(mask);
     }
-
-    wl_list_remove(&ivisurf->layer_pos.link);
-
-    weston_matrix_init(matrix);
-    weston_matrix_translate(matrix, tx, ty, 0.0f);
-    wl_list_insert(
-        &view->geometry.transformation_list,
-        &ivisurf->layer_pos.link);
-
-    weston_view_set_transform_parent(view, NULL);
-    weston_view_update_transform(view);
 }
 
+/**
+ * Composite surfaces of the layer on the screen into one image, and link
+ * its view just above the top most of them.
+ */
 static void
-update_scale(struct weston_layout_layer *ivilayer,
-               struct weston_layout_surface *ivisurf)
+build_layer_cache(struct weston_layout_layer *ivilayer,
+                  struct weston_layout_screen *iviscrn)
 {
-    struct weston_view *view = ivisurf->view;
-    struct weston_matrix *matrix = &ivisurf->scaling.matrix;
-    float sx = 0.0f;
-    float sy = 0.0f;
-    float lw = 0.0f;
-    float sw = 0.0f;
-    float lh = 0.0f;
-    float sh = 0.0f;
+    struct weston_renderer *renderer = ivilayer->layout->compositor->renderer;
+    struct weston_layout_surface *ivisurf = NULL;
+    struct weston_view *top = NULL;
+    pixman_image_t *image = NULL;
+    pixman_image_t *surf_image = NULL;
+    pixman_region32_t region;
+    pixman_box32_t box;
+    int32_t width  = 0;
+    int32_t height = 0;
 
-    if (view == NULL) {
+    ivilayer->cache.static_frames = 0;
+
+    if (renderer->surface_set_image == NULL ||
+        renderer->read_surface_pixels == NULL) {
         return;
     }
 
-    if (ivisurf->prop.sourceWidth == 0 && ivisurf->prop.sourceHeight == 0) {
-        ivisurf->prop.sourceWidth  = ivisurf->buffer_width;
-        ivisurf->prop.sourceHeight = ivisurf->buffer_height;
-
-        if (ivisurf->prop.destWidth == 0 && ivisurf->prop.destHeight == 0) {
-            ivisurf->prop.destWidth  = ivisurf->buffer_width;
-            ivisurf->prop.destHeight = ivisurf->buffer_height;
+    pixman_region32_init(&region);
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (is_layer_cache_member(ivisurf, iviscrn)) {
+            pixman_region32_union(&region, &region,
+                                  &ivisurf->view->transform.boundingbox);
         }
     }
+    pixman_region32_intersect(&region, &region, &iviscrn->output->region);
+    box = *pixman_region32_extents(&region);
+    pixman_region32_fini(&region);
 
-    lw = ((float)ivilayer->prop.destWidth  / ivilayer->prop.sourceWidth );
-    sw = ((float)ivisurf->prop.destWidth   / ivisurf->prop.sourceWidth  );
-    lh = ((float)ivilayer->prop.destHeight / ivilayer->prop.sourceHeight);
-    sh = ((float)ivisurf->prop.destHeight  / ivisurf->prop.sourceHeight );
-    sx = sw * lw;
-    sy = sh * lh;
+    width  = box.x2 - box.x1;
+    height = box.y2 - box.y1;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
 
-    wl_list_remove(&ivisurf->scaling.link);
-    weston_matrix_init(matrix);
-    weston_matrix_scale(matrix, sx, sy, 1.0f);
+    image = pixman_image_create_bits(PIXMAN_a8r8g8b8, width, height, NULL, 0);
+    if (image == NULL) {
+        weston_log("fails to allocate memory\n");
+        return;
+    }
 
-    wl_list_insert(&view->geometry.transformation_list,
-                   &ivisurf->scaling.link);
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (!is_layer_cache_member(ivisurf, iviscrn)) {
+            continue;
+        }
 
-    weston_view_set_transform_parent(view, NULL);
-    weston_view_update_transform(view);
-}
+        surf_image = read_surface_image(ivisurf);
+        if (surf_image == NULL) {
+            pixman_image_unref(image);
+            return;
+        }
 
-static void
-update_prop(struct weston_layout_layer *ivilayer,
-            struct weston_layout_surface *ivisurf)
-{
-    if (ivilayer->event_mask | ivisurf->event_mask) {
-        update_opacity(ivilayer, ivisurf);
-        update_layer_orientation(ivilayer, ivisurf);
-        update_layer_position(ivilayer, ivisurf);
-        update_surface_position(ivisurf);
-        update_surface_orientation(ivilayer, ivisurf);
-        update_scale(ivilayer, ivisurf);
+        draw_view_image(image, surf_image, ivisurf->view, box.x1, box.y1);
+        pixman_image_unref(surf_image);
+        top = ivisurf->view;
+    }
 
-        ivisurf->update_count++;
+    if (ivilayer->cache.surface == NULL &&
+        create_layer_cache_surface(ivilayer) != 0) {
+        pixman_image_unref(image);
+        return;
+    }
 
-        if (ivisurf->view != NULL) {
-            weston_view_geometry_dirty(ivisurf->view);
-        }
+    renderer->surface_set_image(ivilayer->cache.surface, image);
+    pixman_image_unref(image);
 
-        if (ivisurf->surface != NULL) {
-            weston_surface_damage(ivisurf->surface);
+    weston_surface_set_size(ivilayer->cache.surface, width, height);
+    weston_view_set_position(ivilayer->cache.view, box.x1, box.y1);
+    weston_view_update_transform(ivilayer->cache.view);
+
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (is_layer_cache_member(ivisurf, iviscrn)) {
+            ivisurf->view->cached = 1;
         }
     }
+
+    insert_layer_cache_view(ivilayer, top->layer_link.prev);
+
+    ivilayer->cache.valid = 1;
+    ivilayer->cache.iviscrn = iviscrn;
+    ivilayer->cache.stats.buildCount++;
 }
 
+/**
+ * A surface which was hidden when the cache was built is not in the cached
+ * image. When it is shown again, the cache is rebuilt so that the order of
+ * surfaces is kept.
+ */
 static void
-commit_changes(struct weston_layout *layout)
+validate_layer_caches(struct weston_layout_screen *iviscrn)
 {
-    struct weston_layout_screen  *iviscrn  = NULL;
     struct weston_layout_layer   *ivilayer = NULL;
     struct weston_layout_surface *ivisurf  = NULL;
 
-    wl_list_for_each(iviscrn, &layout->list_screen, link) {
-        wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
-            wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
-                update_prop(ivilayer, ivisurf);
+    wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+        if (!ivilayer->cache.valid || ivilayer->cache.iviscrn != iviscrn) {
+            continue;
+        }
+
+        wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+            if (is_layer_cache_member(ivisurf, iviscrn) &&
+                !ivisurf->view->cached) {
+                invalidate_layer_cache(ivilayer);
+                break;
             }
         }
     }
 }
 
+/**
+ * Called after each repaint of the screen. Planes of views are already
+ * assigned for the frame, so the layer is checked here whether it can be
+ * drawn from the cached image.
+ */
 static void
-commit_list_surface(struct weston_layout *layout)
+layer_cache_frame_notify(struct wl_listener *listener, void *data)
 {
-    struct weston_layout_surface *ivisurf = NULL;
-
-    wl_list_for_each(ivisurf, &layout->list_surface, link) {
-        ivisurf->prop = ivisurf->pending.prop;
-    }
-}
+    struct weston_layout_screen *iviscrn =
+        container_of(listener, struct weston_layout_screen, frame_listener);
+    struct weston_layout_layer *ivilayer = NULL;
+    int32_t count = 0;
 
-static void
-commit_list_layer(struct weston_layout *layout)
-{
-    struct weston_layout_layer   *ivilayer = NULL;
-    struct weston_layout_surface *ivisurf  = NULL;
-    struct weston_layout_surface *next     = NULL;
+    wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+        if (!ivilayer->cache.enabled || ivilayer->prop.visibility == 0) {
+            continue;
+        }
 
-    wl_list_for_each(ivilayer, &layout->list_layer, link) {
-        ivilayer->prop = ivilayer->pending.prop;
+        if (ivilayer->cache.valid && ivilayer->cache.iviscrn != iviscrn) {
+            continue;
+        }
 
-        if (!(ivilayer->event_mask &
-              (IVI_NOTIFICATION_ADD | IVI_NOTIFICATION_REMOVE)) ) {
+        count = count_layer_cache_members(ivilayer, iviscrn);
+        if (count == 0) {
             continue;
         }
 
-        wl_list_for_each_safe(ivisurf, next,
-            &ivilayer->order.list_surface, order.link) {
-            remove_ordersurface_from_layer(ivisurf);
+        if (count > 0 && ivilayer->cache.valid) {
+            ivilayer->cache.stats.hitCount++;
+            continue;
+        }
 
-            if (!wl_list_empty(&ivisurf->order.link)) {
-                wl_list_remove(&ivisurf->order.link);
-            }
+        ivilayer->cache.stats.missCount++;
 
-            wl_list_init(&ivisurf->order.link);
+        if (count < 0) {
+            invalidate_layer_cache(ivilayer);
+            continue;
         }
 
-        wl_list_init(&ivilayer->order.list_surface);
-        wl_list_for_each(ivisurf, &ivilayer->pending.list_surface,
-                              pending.link) {
-            if(!wl_list_empty(&ivisurf->order.link)){
-                wl_list_remove(&ivisurf->order.link);
-                wl_list_init(&ivisurf->order.link);
-            }
-
-            wl_list_insert(&ivilayer->order.list_surface,
-                           &ivisurf->order.link);
-            add_ordersurface_to_layer(ivisurf, ivilayer);
+        if (++ivilayer->cache.static_frames >= LAYER_CACHE_STATIC_FRAMES) {
+            build_layer_cache(ivilayer, iviscrn);
         }
     }
 }
 
+/**
+ * Called at destruction of ivi_surface
+ */
 static void
-commit_list_screen(struct weston_layout *layout)
+westonsurface_destroy_from_ivisurface(struct wl_listener *listener, void *data)
 {
-    struct weston_layout_screen  *iviscrn  = NULL;
-    struct weston_layout_layer   *ivilayer = NULL;
-    struct weston_layout_layer   *next     = NULL;
-    struct weston_layout_surface *ivisurf  = NULL;
+    struct weston_layout_surface *ivisurf = NULL;
 
-    wl_list_for_each(iviscrn, &layout->list_screen, link) {
-        if (iviscrn->event_mask & IVI_NOTIFICATION_ADD) {
-            wl_list_for_each_safe(ivilayer, next,
-                     &iviscrn->order.list_layer, order.link) {
-                remove_orderlayer_from_screen(ivilayer);
+    ivisurf = container_of(listener, struct weston_layout_surface,
+                           surface_destroy_listener);
+    invalidate_surface_layer_caches(ivisurf);
+    wl_list_remove(&ivisurf->surface_commit_listener.link);
+    ivisurf->surface = NULL;
+    ivisurf->view = NULL;
 
-                if (!wl_list_empty(&ivilayer->order.link)) {
-                    wl_list_remove(&ivilayer->order.link);
-                }
+    /* transformation list of the view is gone together with the view */
+    wl_list_init(&ivisurf->layout_transform.link);
+}
 
-                wl_list_init(&ivilayer->order.link);
-            }
+/**
+ * Called at wl_surface.commit of ivi_surface
+ */
+static void
+westonsurface_commit_from_ivisurface(struct wl_listener *listener, void *data)
+{
+    struct weston_layout_surface *ivisurf = NULL;
 
-            wl_list_init(&iviscrn->order.list_layer);
-            wl_list_for_each(ivilayer, &iviscrn->pending.list_layer,
-                                  pending.link) {
-                wl_list_insert(&iviscrn->order.list_layer,
-                               &ivilayer->order.link);
-                add_orderlayer_to_screen(ivilayer, iviscrn);
-            }
-            iviscrn->event_mask = 0;
-        }
+    struct weston_surface *surface = NULL;
+    struct weston_layout *layout = NULL;
 
-        /* Clear view list of layout layer */
-        wl_list_init(&layout->layout_layer.view_list);
+    ivisurf = container_of(listener, struct weston_layout_surface,
+                           surface_commit_listener);
+    invalidate_surface_layer_caches(ivisurf);
 
-        wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+    surface = ivisurf->surface;
+    if (surface->width == ivisurf->occlusion.width &&
+        surface->height == ivisurf->occlusion.height &&
+        pixman_region32_equal(&surface->opaque, &ivisurf->occlusion.opaque)) {
+        return;
+    }
 
-            if (ivilayer->prop.visibility == 0)
-                continue;
+    ivisurf->occlusion.width = surface->width;
+    ivisurf->occlusion.height = surface->height;
+    pixman_region32_copy(&ivisurf->occlusion.opaque, &surface->opaque);
 
-            wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+    /* views culled by the old opaque region may be uncovered now */
+    if (ivisurf->prop.visibility == 0 || wl_list_empty(&ivisurf->list_layer)) {
+        return;
+    }
 
-                if (ivisurf->prop.visibility == 0)
-                    continue;
-                if (ivisurf->surface == NULL || ivisurf->view == NULL)
-                    continue;
+    layout = ivisurf->layout;
+    build_view_list(layout);
+    layout->commit_stats.culledCount = arrange_view_list(layout);
+}
 
-                wl_list_insert(&layout->layout_layer.view_list,
-                               &ivisurf->view->layer_link);
+/**
+ * Internal API to check layer/surface already added in layer/screen.
+ * Called by weston_layout_layerAddSurface/weston_layout_screenAddLayer
+ */
+static int
+is_surface_in_layer(struct weston_layout_surface *ivisurf,
+                    struct weston_layout_layer *ivilayer)
+{
+    struct weston_layout_surface *surf = NULL;
 
-                ivisurf->surface->output = iviscrn->output;
-            }
+    wl_list_for_each(surf, &ivilayer->pending.list_surface, pending.link) {
+        if (surf->id_surface == ivisurf->id_surface) {
+            return 1;
         }
+    }
+
+    return 0;
+}
+
+static int
+is_layer_in_screen(struct weston_layout_layer *ivilayer,
+                    struct weston_layout_screen *iviscrn)
+{
+    struct weston_layout_layer *layer = NULL;
+
+    wl_list_for_each(layer, &iviscrn->pending.list_layer, pending.link) {
+        if (layer->id_layer == ivilayer->id_layer) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+output_destroyed(struct wl_listener *listener, void *data);
+
+static void
+screenshot_cancel_screen(struct weston_layout *layout,
+                         struct weston_layout_screen *iviscrn);
+
+/**
+ * Internal API to create a screen for an output, with the smallest id not
+ * used. Called for outputs found by weston_layout_initWithCompositor and
+ * ones created later.
+ */
+static void
+create_screen(struct weston_layout *layout, struct weston_output *output)
+{
+    struct weston_layout_screen *iviscrn = NULL;
+    uint32_t id_screen = 0;
+
+    iviscrn = calloc(1, sizeof *iviscrn);
+    if (iviscrn == NULL) {
+        weston_log("fails to allocate memory\n");
+        return;
+    }
+
+    wl_list_init(&iviscrn->link);
+    wl_list_init(&iviscrn->hash.link);
+    wl_list_init(&iviscrn->dirty_link);
+    iviscrn->layout = layout;
+
+    while (get_screen(layout, id_screen) != NULL) {
+        id_screen++;
+    }
+
+    iviscrn->id_screen = id_screen;
+    if (id_hash_insert(&layout->hash_screen, &iviscrn->hash,
+                       iviscrn->id_screen) != 0) {
+        free(iviscrn);
+        return;
+    }
+
+    iviscrn->output = output;
+    iviscrn->event_mask = 0;
+
+    wl_list_init(&iviscrn->pending.list_layer);
+    wl_list_init(&iviscrn->pending.link);
+
+    wl_list_init(&iviscrn->order.list_layer);
+    wl_list_init(&iviscrn->order.link);
+
+    /* Add layout_layer at the last of weston_compositor.layer_list */
+    weston_layer_init(&iviscrn->layout_layer,
+                      layout->compositor->layer_list.prev);
+    wl_array_init(&iviscrn->arranged_views);
+
+    iviscrn->frame_listener.notify = layer_cache_frame_notify;
+    wl_signal_add(&output->frame_signal, &iviscrn->frame_listener);
+    iviscrn->output_destroy_listener.notify = output_destroyed;
+    wl_signal_add(&output->destroy_signal, &iviscrn->output_destroy_listener);
+
+    wl_list_insert(&layout->list_screen, &iviscrn->link);
+}
+
+/**
+ * Internal API to destroy a screen with its output. Layers on it are left
+ * without screen, and surfaces shown only on it are hidden.
+ */
+static void
+destroy_screen(struct weston_layout_screen *iviscrn)
+{
+    struct weston_layout *layout = iviscrn->layout;
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_layer   *next     = NULL;
+    struct weston_layout_surface *ivisurf  = NULL;
+    struct link_screen *link_scrn = NULL;
+    struct link_screen *next_link = NULL;
+
+    wl_list_for_each(ivilayer, &layout->list_layer, link) {
+        if (ivilayer->cache.iviscrn == iviscrn) {
+            invalidate_layer_cache(ivilayer);
+        }
+
+        wl_list_for_each_safe(link_scrn, next_link,
+                              &ivilayer->list_screen, link) {
+            if (link_scrn->iviscrn == iviscrn) {
+                wl_list_remove(&link_scrn->link);
+                free(link_scrn);
+            }
+        }
+    }
+
+    wl_list_for_each_safe(ivilayer, next, &iviscrn->order.list_layer,
+                          order.link) {
+        wl_list_remove(&ivilayer->order.link);
+        wl_list_init(&ivilayer->order.link);
+    }
+
+    wl_list_for_each_safe(ivilayer, next, &iviscrn->pending.list_layer,
+                          pending.link) {
+        wl_list_remove(&ivilayer->pending.link);
+        wl_list_init(&ivilayer->pending.link);
+    }
+
+    wl_list_for_each(ivisurf, &layout->list_surface, link) {
+        if (ivisurf->output == iviscrn->output) {
+            ivisurf->output = NULL;
+        }
+    }
+
+    screenshot_cancel_screen(layout, iviscrn);
+
+    wl_list_remove(&iviscrn->frame_listener.link);
+    wl_list_remove(&iviscrn->output_destroy_listener.link);
+
+    clear_view_list(&iviscrn->layout_layer);
+    wl_list_remove(&iviscrn->layout_layer.link);
+    wl_array_release(&iviscrn->arranged_views);
+
+    if (!wl_list_empty(&iviscrn->dirty_link)) {
+        wl_list_remove(&iviscrn->dirty_link);
+    }
+    id_hash_remove(&layout->hash_screen, &iviscrn->hash);
+    wl_list_remove(&iviscrn->link);
+    free(iviscrn);
+
+    /* surfaces on the screen may be shown on other screens now */
+    build_view_list(layout);
+    layout->commit_stats.culledCount = arrange_view_list(layout);
+    weston_compositor_scene_changed(layout->compositor);
+}
+
+static void
+output_created(struct wl_listener *listener, void *data)
+{
+    struct weston_layout *layout =
+        container_of(listener, struct weston_layout, output_created_listener);
+
+    create_screen(layout, data);
+}
+
+static void
+output_destroyed(struct wl_listener *listener, void *data)
+{
+    struct weston_layout_screen *iviscrn =
+        container_of(listener, struct weston_layout_screen,
+                     output_destroy_listener);
+
+    destroy_screen(iviscrn);
+}
+
+/**
+ * Internal APIs to initialize properties of surface/layer when they are created.
+ */
+static void
+init_layerProperties(struct weston_layout_LayerProperties *prop,
+                     int32_t width, int32_t height)
+{
+    memset(prop, 0, sizeof *prop);
+    prop->opacity = wl_fixed_from_double(1.0);
+    prop->sourceWidth = width;
+    prop->sourceHeight = height;
+    prop->destWidth = width;
+    prop->destHeight = height;
+}
+
+static void
+init_surfaceProperties(struct weston_layout_SurfaceProperties *prop)
+{
+    memset(prop, 0, sizeof *prop);
+    prop->opacity = wl_fixed_from_double(1.0);
+}
+
+/**
+ * Internal APIs to be called from weston_layout_commitChanges.
+ */
+/**
+ * Return 1 if the view becomes opaque or translucent, which changes its
+ * opaque region.
+ */
+static int
+update_opacity(struct weston_layout_layer *ivilayer,
+               struct weston_layout_surface *ivisurf)
+{
+    double layer_alpha = wl_fixed_to_double(ivilayer->prop.opacity);
+    double surf_alpha  = wl_fixed_to_double(ivisurf->prop.opacity);
+    int was_opaque = 0;
+
+    if ((ivilayer->event_mask & IVI_NOTIFICATION_OPACITY) ||
+        (ivisurf->event_mask  & IVI_NOTIFICATION_OPACITY)) {
+        if (ivisurf->view == NULL) {
+            return 0;
+        }
+        was_opaque = ivisurf->view->alpha == 1.0;
+        ivisurf->view->alpha = layer_alpha * surf_alpha;
+        return was_opaque != (ivisurf->view->alpha == 1.0);
+    }
+
+    return 0;
+}
+
+/**
+ * Chroma key of surface takes precedence over the one of layer. Return 1
+ * if chroma key is enabled or disabled, which changes the opaque region.
+ */
+static int
+update_chroma_key(struct weston_layout_layer *ivilayer,
+                  struct weston_layout_surface *ivisurf)
+{
+    struct weston_view *view = ivisurf->view;
+    int was_enabled = 0;
+
+    if (view == NULL) {
+        return 0;
+    }
+    was_enabled = view->chroma_key.enabled;
+
+    if (ivisurf->prop.chromaKeyEnabled) {
+        view->chroma_key.enabled = 1;
+        view->chroma_key.color = (ivisurf->prop.chromaKeyRed   << 16) |
+                                 (ivisurf->prop.chromaKeyGreen <<  8) |
+                                  ivisurf->prop.chromaKeyBlue;
+    } else if (ivilayer->prop.chromaKeyEnabled) {
+        view->chroma_key.enabled = 1;
+        view->chroma_key.color = (ivilayer->prop.chromaKeyRed   << 16) |
+                                 (ivilayer->prop.chromaKeyGreen <<  8) |
+                                  ivilayer->prop.chromaKeyBlue;
+    } else {
+        view->chroma_key.enabled = 0;
+    }
+
+    return was_enabled != view->chroma_key.enabled;
+}
+
+/**
+ * Rotation by orientation around the center of width x height area.
+ * Nothing is multiplied for 0 degrees, so that the type of matrix is kept
+ * as simple as possible for renderers.
+ */
+static void
+rotate_by_orientation(struct weston_matrix *matrix, uint32_t orientation,
+                      float width, float height)
+{
+    float v_sin = 0.0f;
+    float v_cos = 0.0f;
+    float cx = 0.5f * width;
+    float cy = 0.5f * height;
+    float sx = 1.0f;
+    float sy = 1.0f;
+
+    switch (orientation) {
+    case WESTON_LAYOUT_SURFACE_ORIENTATION_0_DEGREES:
+        return;
+    case WESTON_LAYOUT_SURFACE_ORIENTATION_90_DEGREES:
+        v_sin = 1.0f;
+        v_cos = 0.0f;
+        sx = width / height;
+        sy = height / width;
+        break;
+    case WESTON_LAYOUT_SURFACE_ORIENTATION_180_DEGREES:
+        v_sin = 0.0f;
+        v_cos = -1.0f;
+        break;
+    case WESTON_LAYOUT_SURFACE_ORIENTATION_270_DEGREES:
+    default:
+        v_sin = -1.0f;
+        v_cos = 0.0f;
+        sx = width / height;
+        sy = height / width;
+        break;
+    }
+
+    weston_matrix_translate(matrix, -cx, -cy, 0.0f);
+    weston_matrix_rotate_xy(matrix, v_cos, v_sin);
+    if (sx != 1.0f || sy != 1.0f) {
+        weston_matrix_scale(matrix, sx, sy, 1.0f);
+    }
+    weston_matrix_translate(matrix, cx, cy, 0.0f);
+}
+
+static float
+scale_factor(uint32_t dest, uint32_t source)
+{
+    if (source == 0) {
+        return 1.0f;
+    }
+
+    return (float)dest / source;
+}
+
+/**
+ * Calculate the matrix from surface coordinates to screen coordinates.
+ * It is applied in order of
+ *  - offset of source rectangle of surface, see update_crop
+ *  - scaling by source/destination rectangle of surface and layer
+ *  - orientation of surface
+ *  - position of surface and layer
+ *  - orientation of layer
+ *  - position of output which the surface is shown on
+ */
+static void
+calc_transform(struct weston_layout_layer *ivilayer,
+               struct weston_layout_surface *ivisurf,
+               struct weston_matrix *matrix)
+{
+    struct weston_output *output = NULL;
+    float sx = 0.0f;
+    float sy = 0.0f;
+    float tx = 0.0f;
+    float ty = 0.0f;
+
+    if (ivisurf->prop.sourceWidth == 0 && ivisurf->prop.sourceHeight == 0) {
+        ivisurf->prop.sourceWidth  = ivisurf->buffer_width;
+        ivisurf->prop.sourceHeight = ivisurf->buffer_height;
+
+        if (ivisurf->prop.destWidth == 0 && ivisurf->prop.destHeight == 0) {
+            ivisurf->prop.destWidth  = ivisurf->buffer_width;
+            ivisurf->prop.destHeight = ivisurf->buffer_height;
+        }
+    }
+
+    sx = scale_factor(ivisurf->prop.destWidth,  ivisurf->prop.sourceWidth) *
+         scale_factor(ivilayer->prop.destWidth, ivilayer->prop.sourceWidth);
+    sy = scale_factor(ivisurf->prop.destHeight,  ivisurf->prop.sourceHeight) *
+         scale_factor(ivilayer->prop.destHeight, ivilayer->prop.sourceHeight);
+
+    weston_matrix_init(matrix);
+
+    if (ivisurf->prop.sourceX != 0 || ivisurf->prop.sourceY != 0) {
+        weston_matrix_translate(matrix, -(float)ivisurf->prop.sourceX,
+                                -(float)ivisurf->prop.sourceY, 0.0f);
+    }
+
+    if (sx != 1.0f || sy != 1.0f) {
+        weston_matrix_scale(matrix, sx, sy, 1.0f);
+    }
+
+    if (ivilayer->prop.destWidth != 0 && ivilayer->prop.destHeight != 0) {
+        rotate_by_orientation(matrix, ivisurf->prop.orientation,
+                              (float)ivilayer->prop.destWidth,
+                              (float)ivilayer->prop.destHeight);
+    }
+
+    tx = (float)(ivisurf->prop.destX + ivilayer->prop.destX);
+    ty = (float)(ivisurf->prop.destY + ivilayer->prop.destY);
+    if (tx != 0.0f || ty != 0.0f) {
+        weston_matrix_translate(matrix, tx, ty, 0.0f);
+    }
+
+    output = ivisurf->output;
+    if (output == NULL) {
+        return;
+    }
+
+    if (output->width != 0 && output->height != 0) {
+        rotate_by_orientation(matrix, ivilayer->prop.orientation,
+                              (float)output->width, (float)output->height);
+    }
+
+    /* Layout is in output local coordinates */
+    if (output->x != 0 || output->y != 0) {
+        weston_matrix_translate(matrix, (float)output->x,
+                                (float)output->y, 0.0f);
+    }
+}
+
+/**
+ * Source rectangle of surface is the crop of its view, so that renderer
+ * samples and clips only the part shown instead of whole buffer. Return
+ * 1 if the crop is changed.
+ */
+static int
+update_crop(struct weston_layout_surface *ivisurf, struct weston_view *view)
+{
+    struct weston_layout_SurfaceProperties *prop = &ivisurf->prop;
+    int32_t width  = prop->sourceWidth  ? prop->sourceWidth  : ivisurf->buffer_width;
+    int32_t height = prop->sourceHeight ? prop->sourceHeight : ivisurf->buffer_height;
+    int enabled = prop->sourceX != 0 || prop->sourceY != 0 ||
+                  width  != (int32_t)ivisurf->buffer_width ||
+                  height != (int32_t)ivisurf->buffer_height;
+
+    if (view->crop.enabled == enabled &&
+        (!enabled ||
+         (view->crop.x == (int32_t)prop->sourceX &&
+          view->crop.y == (int32_t)prop->sourceY &&
+          view->crop.width == width && view->crop.height == height))) {
+        return 0;
+    }
+
+    view->crop.enabled = enabled;
+    view->crop.x = prop->sourceX;
+    view->crop.y = prop->sourceY;
+    view->crop.width  = width;
+    view->crop.height = height;
+
+    return 1;
+}
+
+static void
+update_transform(struct weston_layout_layer *ivilayer,
+                 struct weston_layout_surface *ivisurf)
+{
+    struct weston_view *view = ivisurf->view;
+    struct weston_transform *transform = &ivisurf->layout_transform;
+    struct weston_matrix matrix;
+    int is_linked = !wl_list_empty(&transform->link);
+    int crop_changed = 0;
+
+    if (view == NULL) {
+        return;
+    }
+
+    calc_transform(ivilayer, ivisurf, &matrix);
+    crop_changed = update_crop(ivisurf, view);
+
+    if (is_linked && !crop_changed &&
+        memcmp(&matrix, &transform->matrix, sizeof matrix) == 0) {
+        return;
+    }
+
+    if (is_linked) {
+        wl_list_remove(&transform->link);
+        wl_list_init(&transform->link);
+    }
+
+    transform->matrix = matrix;
+
+    /* Identity needs no transformation, core can take the fastest path */
+    if (matrix.type != 0) {
+        wl_list_insert(&view->geometry.transformation_list, &transform->link);
+    }
+
+    weston_view_set_transform_parent(view, NULL);
+    weston_view_geometry_dirty(view);
+}
+
+#define TRANSFORM_NOTIFICATION_MASK \
+    (IVI_NOTIFICATION_SOURCE_RECT | IVI_NOTIFICATION_DEST_RECT | \
+     IVI_NOTIFICATION_DIMENSION | IVI_NOTIFICATION_POSITION | \
+     IVI_NOTIFICATION_ORIENTATION | IVI_NOTIFICATION_ADD | \
+     IVI_NOTIFICATION_REMOVE)
+
+static void
+update_prop(struct weston_layout_layer *ivilayer,
+            struct weston_layout_surface *ivisurf)
+{
+    uint32_t mask = ivilayer->event_mask | ivisurf->event_mask;
+    int opaque_changed = 0;
+
+    if (mask) {
+        opaque_changed = update_opacity(ivilayer, ivisurf);
+
+        if (mask & (IVI_NOTIFICATION_CHROMA_KEY | IVI_NOTIFICATION_ADD)) {
+            opaque_changed |= update_chroma_key(ivilayer, ivisurf);
+        }
+
+        /* geometry is dirty only if the matrix or the crop is changed */
+        if (mask & TRANSFORM_NOTIFICATION_MASK) {
+            update_transform(ivilayer, ivisurf);
+        }
+
+        ivisurf->update_count++;
+
+        if (ivisurf->view != NULL) {
+            if (opaque_changed) {
+                weston_view_geometry_dirty(ivisurf->view);
+            }
+            weston_view_update_transform(ivisurf->view);
+        }
+
+        if (ivisurf->surface != NULL) {
+            weston_surface_damage(ivisurf->surface);
+        }
+    }
+}
+
+static void
+commit_changes(struct weston_layout *layout)
+{
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_surface *ivisurf  = NULL;
+    struct link_layer *link_layer = NULL;
+
+    /* All surfaces of a changed layer are affected by the change. */
+    wl_list_for_each(ivilayer, &layout->dirty.list_layer, dirty_link) {
+        if (wl_list_empty(&ivilayer->list_screen)) {
+            continue;
+        }
+
+        wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+            update_prop(ivilayer, ivisurf);
+            layout->commit_stats.updateCount++;
+        }
+    }
+
+    /* Changed surfaces in the rest of layers. */
+    wl_list_for_each(ivisurf, &layout->dirty.list_surface, dirty_link) {
+        wl_list_for_each(link_layer, &ivisurf->list_layer, link) {
+            ivilayer = link_layer->ivilayer;
+
+            if (!wl_list_empty(&ivilayer->dirty_link) ||
+                wl_list_empty(&ivilayer->list_screen)) {
+                continue;
+            }
+
+            update_prop(ivilayer, ivisurf);
+            layout->commit_stats.updateCount++;
+        }
+    }
+}
+
+static void
+commit_list_surface(struct weston_layout *layout)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+
+    wl_list_for_each(ivisurf, &layout->dirty.list_surface, dirty_link) {
+        ivisurf->prop = ivisurf->pending.prop;
+        layout->commit_stats.surfaceCount++;
+    }
+}
+
+static void
+commit_list_layer(struct weston_layout *layout)
+{
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_surface *ivisurf  = NULL;
+    struct weston_layout_surface *next     = NULL;
+
+    wl_list_for_each(ivilayer, &layout->dirty.list_layer, dirty_link) {
+        ivilayer->prop = ivilayer->pending.prop;
+        layout->commit_stats.layerCount++;
+
+        if (ivilayer->cache.enabled && !ivilayer->pending.cache_enabled) {
+            destroy_layer_cache(ivilayer);
+        }
+        ivilayer->cache.enabled = ivilayer->pending.cache_enabled;
+
+        if (!(ivilayer->event_mask &
+              (IVI_NOTIFICATION_ADD | IVI_NOTIFICATION_REMOVE)) ) {
+            continue;
+        }
+
+        wl_list_for_each_safe(ivisurf, next,
+            &ivilayer->order.list_surface, order.link) {
+            remove_ordersurface_from_layer(ivisurf);
+
+            if (!wl_list_empty(&ivisurf->order.link)) {
+                wl_list_remove(&ivisurf->order.link);
+            }
+
+            wl_list_init(&ivisurf->order.link);
+        }
+
+        wl_list_init(&ivilayer->order.list_surface);
+        wl_list_for_each(ivisurf, &ivilayer->pending.list_surface,
+                              pending.link) {
+            if(!wl_list_empty(&ivisurf->order.link)){
+                wl_list_remove(&ivisurf->order.link);
+                wl_list_init(&ivisurf->order.link);
+            }
+
+            wl_list_insert(&ivilayer->order.list_surface,
+                           &ivisurf->order.link);
+            add_ordersurface_to_layer(ivisurf, ivilayer);
+        }
+    }
+}
+
+/**
+ * Internal APIs for composition strategies of screen.
+ */
+static int
+is_valid_optimization(uint32_t id, uint32_t mode)
+{
+    switch (id) {
+    case IVI_OPTIMIZATION_BYPASS_COMPOSITION:
+        return mode == IVI_OPTIMIZATION_MODE_FORCE_OFF ||
+               mode == IVI_OPTIMIZATION_MODE_FORCE_ON ||
+               mode == IVI_OPTIMIZATION_MODE_HEURISTIC;
+    case IVI_OPTIMIZATION_FORCE_PRIMARY_PLANE:
+        return mode == IVI_OPTIMIZATION_MODE_FORCE_OFF ||
+               mode == IVI_OPTIMIZATION_MODE_FORCE_ON;
+    default:
+        return 0;
+    }
+}
+
+static void
+commit_optimization_mode(struct weston_layout_screen *iviscrn)
+{
+    uint32_t bit = IVI_BIT(IVI_OPTIMIZATION_FORCE_PRIMARY_PLANE);
+    int force_primary = 0;
+
+    memcpy(iviscrn->optimization_mode, iviscrn->pending.optimization_mode,
+           sizeof iviscrn->optimization_mode);
+
+    force_primary = iviscrn->optimization_mode[IVI_OPTIMIZATION_FORCE_PRIMARY_PLANE] ==
+                    IVI_OPTIMIZATION_MODE_FORCE_ON;
+
+    /* disable_planes is a counter shared with screenshooter and zoom */
+    if (force_primary && !(iviscrn->optimization_state & bit)) {
+        iviscrn->output->disable_planes++;
+        iviscrn->optimization_state |= bit;
+    } else if (!force_primary && (iviscrn->optimization_state & bit)) {
+        iviscrn->output->disable_planes--;
+        iviscrn->optimization_state &= ~bit;
+    }
+}
+
+static int
+is_view_covering_output(struct weston_view *view,
+                        struct weston_output *output,
+                        int check_opaque)
+{
+    pixman_box32_t *extents = pixman_region32_extents(&view->transform.boundingbox);
+    pixman_box32_t surface_box = {0};
+
+    if (extents->x1 > output->x || extents->y1 > output->y ||
+        extents->x2 < output->x + output->width ||
+        extents->y2 < output->y + output->height) {
+        return 0;
+    }
+
+    if (!check_opaque) {
+        return 1;
+    }
+
+    if (view->alpha < 1.0 || view->chroma_key.enabled) {
+        return 0;
+    }
+
+    if (view->crop.enabled) {
+        surface_box.x1 = view->crop.x;
+        surface_box.y1 = view->crop.y;
+        surface_box.x2 = view->crop.x + view->crop.width;
+        surface_box.y2 = view->crop.y + view->crop.height;
+    } else {
+        surface_box.x2 = view->surface->width;
+        surface_box.y2 = view->surface->height;
+    }
+
+    return pixman_region32_contains_rectangle(&view->surface->opaque,
+                                              &surface_box) == PIXMAN_REGION_IN;
+}
+
+/**
+ * Views below the top most view which covers whole output are unlinked
+ * from view list of the screen. They are linked again by next rebuild of
+ * view list.
+ */
+static void
+bypass_composition(struct weston_layout_screen *iviscrn)
+{
+    uint32_t mode = iviscrn->optimization_mode[IVI_OPTIMIZATION_BYPASS_COMPOSITION];
+    struct weston_view *view = NULL;
+    struct weston_view *next = NULL;
+    int covered = 0;
+
+    iviscrn->optimization_state &= ~IVI_BIT(IVI_OPTIMIZATION_BYPASS_COMPOSITION);
+
+    if (mode == IVI_OPTIMIZATION_MODE_FORCE_OFF) {
+        return;
+    }
+
+    wl_list_for_each_safe(view, next, &iviscrn->layout_layer.view_list,
+                          layer_link) {
+        if (covered) {
+            wl_list_remove(&view->layer_link);
+            wl_list_init(&view->layer_link);
+            continue;
+        }
+
+        /* views of cached surfaces below need to stay for input */
+        if (is_layer_cache_view(view)) {
+            continue;
+        }
+
+        weston_view_update_transform(view);
+        covered = is_view_covering_output(view, iviscrn->output,
+                      mode == IVI_OPTIMIZATION_MODE_HEURISTIC);
+    }
+
+    if (covered) {
+        iviscrn->optimization_state |= IVI_BIT(IVI_OPTIMIZATION_BYPASS_COMPOSITION);
+    }
+}
+
+/**
+ * Internal APIs for occlusion culling of view list. The core computes opaque
+ * region of a view only when it has no transformation, so the one of a
+ * view scaled by destination rectangle or rotated by orientation, which is
+ * still axis-aligned, is computed here.
+ */
+static void
+get_view_opaque(struct weston_view *view, pixman_region32_t *opaque)
+{
+    struct weston_matrix *matrix = &view->transform.matrix;
+    pixman_region32_t surface_opaque;
+    pixman_box32_t *rects = NULL;
+    float x1, y1, x2, y2;
+    int32_t left, top, right, bottom;
+    int n = 0;
+    int i = 0;
+
+    if (!view->transform.enabled) {
+        pixman_region32_copy(opaque, &view->transform.opaque);
+        return;
+    }
+
+    if (view->alpha < 1.0 || view->chroma_key.enabled) {
+        return;
+    }
+
+    if (!((matrix->d[1] == 0.0f && matrix->d[4] == 0.0f) ||
+          (matrix->d[0] == 0.0f && matrix->d[5] == 0.0f)) ||
+        matrix->d[3] != 0.0f || matrix->d[7] != 0.0f ||
+        matrix->d[15] != 1.0f) {
+        return;
+    }
+
+    pixman_region32_init(&surface_opaque);
+    if (view->crop.enabled) {
+        pixman_region32_intersect_rect(&surface_opaque, &view->surface->opaque,
+                                       view->crop.x, view->crop.y,
+                                       view->crop.width, view->crop.height);
+    } else {
+        pixman_region32_copy(&surface_opaque, &view->surface->opaque);
+    }
+
+    rects = pixman_region32_rectangles(&surface_opaque, &n);
+    for (i = 0; i < n; i++) {
+        weston_view_to_global_float(view, rects[i].x1, rects[i].y1, &x1, &y1);
+        weston_view_to_global_float(view, rects[i].x2, rects[i].y2, &x2, &y2);
+
+        /* rounded inward, pixels partially covered are not opaque */
+        left   = (int32_t)ceilf(x1 < x2 ? x1 : x2);
+        top    = (int32_t)ceilf(y1 < y2 ? y1 : y2);
+        right  = (int32_t)floorf(x1 < x2 ? x2 : x1);
+        bottom = (int32_t)floorf(y1 < y2 ? y2 : y1);
+
+        if (left < right && top < bottom) {
+            pixman_region32_union_rect(opaque, opaque, left, top,
+                                       right - left, bottom - top);
+        }
+    }
+
+    pixman_region32_fini(&surface_opaque);
+}
+
+/**
+ * Views which are out of output of the screen or hidden by opaque views
+ * above them are unlinked from view list of the screen, so that damage and
+ * repaint never visit them. They are linked again by next rebuild of view
+ * list. Views of cached surfaces stay for the cached image above them.
+ */
+static uint32_t
+cull_occluded_views(struct weston_layout_screen *iviscrn)
+{
+    struct weston_view *view = NULL;
+    struct weston_view *next = NULL;
+    pixman_region32_t opaque;
+    pixman_region32_t region;
+    uint32_t count = 0;
+    int hidden = 0;
+
+    pixman_region32_init(&opaque);
+
+    wl_list_for_each_safe(view, next, &iviscrn->layout_layer.view_list,
+                          layer_link) {
+        weston_view_update_transform(view);
+
+        pixman_region32_init(&region);
+        pixman_region32_intersect(&region, &view->transform.boundingbox,
+                                  &iviscrn->output->region);
+        pixman_region32_subtract(&region, &region, &opaque);
+        hidden = !pixman_region32_not_empty(&region);
+
+        if (hidden && !view->cached) {
+            wl_list_remove(&view->layer_link);
+            wl_list_init(&view->layer_link);
+            pixman_region32_fini(&region);
+            count++;
+            continue;
+        }
+
+        pixman_region32_fini(&region);
+        pixman_region32_init(&region);
+        get_view_opaque(view, &region);
+        pixman_region32_union(&opaque, &opaque, &region);
+        pixman_region32_fini(&region);
+    }
+
+    pixman_region32_fini(&opaque);
+
+    return count;
+}
+
+/**
+ * A surface is visible when its view is left in the view list of a screen,
+ * i.e. the surface and its layer are visible and it is not hidden by other
+ * surfaces. Notified only when it changes.
+ */
+static void
+notify_surface_visibility(struct weston_layout *layout)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+    struct link_surfaceVisibilityNotification *notification = NULL;
+    int32_t visible = 0;
+
+    wl_list_for_each(ivisurf, &layout->list_surface, link) {
+        visible = ivisurf->view != NULL &&
+                  !wl_list_empty(&ivisurf->view->layer_link);
+        if (visible == ivisurf->visible) {
+            continue;
+        }
+        ivisurf->visible = visible;
+
+        wl_list_for_each(notification,
+                &layout->surface_notification.list_visibility, link) {
+            notification->callback(ivisurf, visible, notification->userdata);
+        }
+    }
+}
+
+/**
+ * Remembers the views left in the view list of the screen. Returns 1 if
+ * they differ from the ones of the last call.
+ */
+static int
+update_arranged_views(struct weston_layout_screen *iviscrn)
+{
+    struct wl_array *arranged = &iviscrn->arranged_views;
+    struct weston_view **entry = arranged->data;
+    struct weston_view *view = NULL;
+    size_t count = arranged->size / sizeof *entry;
+    size_t i = 0;
+
+    wl_list_for_each(view, &iviscrn->layout_layer.view_list, layer_link) {
+        if (i == count || entry[i] != view) {
+            break;
+        }
+        i++;
+    }
+
+    if (i == count && &view->layer_link == &iviscrn->layout_layer.view_list) {
+        return 0;
+    }
+
+    arranged->size = 0;
+    wl_list_for_each(view, &iviscrn->layout_layer.view_list, layer_link) {
+        entry = wl_array_add(arranged, sizeof *entry);
+        if (entry == NULL) {
+            /* compared as changed next time */
+            arranged->size = 0;
+            break;
+        }
+        *entry = view;
+    }
+
+    return 1;
+}
+
+/**
+ * Called after transform of views is updated, because culling and bypass
+ * of composition need geometry of views. The view list of the compositor
+ * is marked changed only when views of screens are changed.
+ */
+static uint32_t
+arrange_view_list(struct weston_layout *layout)
+{
+    struct weston_layout_screen *iviscrn = NULL;
+    uint32_t count = 0;
+    int changed = 0;
+
+    layout->view_list_culled = 0;
+
+    wl_list_for_each(iviscrn, &layout->list_screen, link) {
+        count += cull_occluded_views(iviscrn);
+        bypass_composition(iviscrn);
+        validate_layer_caches(iviscrn);
+
+        if (iviscrn->optimization_state &
+            IVI_BIT(IVI_OPTIMIZATION_BYPASS_COMPOSITION)) {
+            layout->view_list_culled = 1;
+        }
+        changed |= update_arranged_views(iviscrn);
+    }
+
+    if (count > 0) {
+        layout->view_list_culled = 1;
+    }
+
+    /* the compositor rebuilds its view list only when it is changed */
+    if (changed) {
+        weston_compositor_scene_changed(layout->compositor);
+    }
+
+    notify_surface_visibility(layout);
+
+    return count;
+}
+
+static void
+clear_view_list(struct weston_layer *layer)
+{
+    struct weston_view *view = NULL;
+    struct weston_view *next = NULL;
+
+    wl_list_for_each_safe(view, next, &layer->view_list, layer_link) {
+        wl_list_remove(&view->layer_link);
+        wl_list_init(&view->layer_link);
+    }
+}
+
+/**
+ * Each screen has own weston_layer bound to its output. A view can be
+ * linked to only one weston_layer, so a surface is shown on the first
+ * screen where it is visible.
+ */
+static void
+build_view_list(struct weston_layout *layout)
+{
+    struct weston_layout_screen  *iviscrn  = NULL;
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_surface *ivisurf  = NULL;
+
+    wl_list_for_each(iviscrn, &layout->list_screen, link) {
+        clear_view_list(&iviscrn->layout_layer);
+    }
+
+    wl_list_for_each(iviscrn, &layout->list_screen, link) {
+        wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+
+            if (ivilayer->prop.visibility == 0)
+                continue;
+
+            wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+
+                if (ivisurf->prop.visibility == 0)
+                    continue;
+                if (ivisurf->surface == NULL || ivisurf->view == NULL)
+                    continue;
+                if (!wl_list_empty(&ivisurf->view->layer_link))
+                    continue;
+
+                wl_list_insert(&iviscrn->layout_layer.view_list,
+                               &ivisurf->view->layer_link);
+
+                if (ivisurf->output != iviscrn->output) {
+                    ivisurf->output = iviscrn->output;
+                    update_transform(ivilayer, ivisurf);
+                }
+            }
+
+            /* the cache is above all surfaces of the layer */
+            if (ivilayer->cache.valid && ivilayer->cache.iviscrn == iviscrn) {
+                wl_list_insert(&iviscrn->layout_layer.view_list,
+                               &ivilayer->cache.view->layer_link);
+            }
+        }
+    }
+}
+
+static void
+commit_list_screen(struct weston_layout *layout)
+{
+    struct weston_layout_screen  *iviscrn  = NULL;
+    struct weston_layout_screen  *next_scrn = NULL;
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_layer   *next     = NULL;
+
+    wl_list_for_each_safe(iviscrn, next_scrn,
+                          &layout->dirty.list_screen, dirty_link) {
+        if (iviscrn->event_mask & IVI_NOTIFICATION_ADD) {
+            wl_list_for_each_safe(ivilayer, next,
+                     &iviscrn->order.list_layer, order.link) {
+                remove_orderlayer_from_screen(ivilayer);
+
+                if (!wl_list_empty(&ivilayer->order.link)) {
+                    wl_list_remove(&ivilayer->order.link);
+                }
+
+                wl_list_init(&ivilayer->order.link);
+            }
+
+            wl_list_init(&iviscrn->order.list_layer);
+            wl_list_for_each(ivilayer, &iviscrn->pending.list_layer,
+                                  pending.link) {
+                wl_list_insert(&iviscrn->order.list_layer,
+                               &ivilayer->order.link);
+                add_orderlayer_to_screen(ivilayer, iviscrn);
+            }
+        }
+
+        commit_optimization_mode(iviscrn);
+
+        /* No notification is sent for screen */
+        iviscrn->event_mask = 0;
+        wl_list_remove(&iviscrn->dirty_link);
+        wl_list_init(&iviscrn->dirty_link);
+        layout->commit_stats.screenCount++;
+    }
+
+    /* culled views are back only by building it again */
+    if (layout->dirty.view_list ||
+        (layout->dirty.cull && layout->view_list_culled)) {
+        build_view_list(layout);
+    }
+}
+
+/**
+ * Pending changes are cleared before notification so that callbacks can
+ * request new changes for the next commit.
+ */
+static void
+send_surface_prop(struct weston_layout_surface *ivisurf)
+{
+    struct link_surfacePropertyNotification *notification = NULL;
+    uint32_t mask = ivisurf->event_mask;
+
+    ivisurf->event_mask = 0;
+    wl_list_remove(&ivisurf->dirty_link);
+    wl_list_init(&ivisurf->dirty_link);
+
+    wl_list_for_each(notification, &ivisurf->list_notification, link) {
+        notification->callback(ivisurf, &ivisurf->prop, mask,
+                               notification->userdata);
+    }
+}
+
+static void
+send_layer_prop(struct weston_layout_layer *ivilayer)
+{
+    struct link_layerPropertyNotification *notification = NULL;
+    uint32_t mask = ivilayer->event_mask;
+
+    ivilayer->event_mask = 0;
+    wl_list_remove(&ivilayer->dirty_link);
+    wl_list_init(&ivilayer->dirty_link);
+
+    /* e.g. only render cache is changed */
+    if (mask == 0) {
+        return;
+    }
+
+    wl_list_for_each(notification, &ivilayer->list_notification, link) {
+        notification->callback(ivilayer, &ivilayer->prop, mask,
+                               notification->userdata);
+    }
+}
+
+static void
+append_change_entry(struct weston_layout *layout,
+                    struct weston_layout_surface *ivisurf,
+                    struct weston_layout_layer *ivilayer,
+                    uint32_t mask)
+{
+    struct weston_layout_ChangeEntry *entries = NULL;
+    struct weston_layout_ChangeEntry *entry = NULL;
+    uint32_t capacity = 0;
+
+    if (layout->commit_notification.length ==
+        layout->commit_notification.capacity) {
+        capacity = layout->commit_notification.capacity ?
+                   layout->commit_notification.capacity * 2 : 64;
+
+        /* only the first half is kept */
+        entries = realloc(layout->commit_notification.entries,
+                          2 * capacity * sizeof *entries);
+        if (entries == NULL) {
+            weston_log("fails to allocate memory\n");
+            return;
+        }
+
+        layout->commit_notification.entries  = entries;
+        layout->commit_notification.capacity = capacity;
+    }
+
+    entry = &layout->commit_notification.entries[layout->commit_notification.length++];
+    entry->ivisurf  = ivisurf;
+    entry->ivilayer = ivilayer;
+    entry->mask     = mask;
+}
+
+/**
+ * Called at removal of surface/layer so that commit notification never
+ * delivers freed object.
+ */
+static void
+forget_change_entry(struct weston_layout *layout,
+                    struct weston_layout_surface *ivisurf,
+                    struct weston_layout_layer *ivilayer)
+{
+    struct weston_layout_ChangeEntry *entry = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < layout->commit_notification.length; i++) {
+        entry = &layout->commit_notification.entries[i];
+        if ((ivisurf  != NULL && entry->ivisurf  == ivisurf) ||
+            (ivilayer != NULL && entry->ivilayer == ivilayer)) {
+            entry->mask = 0;
+        }
+    }
+
+    for (i = 0; i < layout->commit_notification.sending_length; i++) {
+        entry = &layout->commit_notification.sending[i];
+        if ((ivisurf  != NULL && entry->ivisurf  == ivisurf) ||
+            (ivilayer != NULL && entry->ivilayer == ivilayer)) {
+            entry->mask = 0;
+        }
+    }
+}
+
+static void
+send_commit_notification(struct weston_layout *layout)
+{
+    struct link_commitNotification *notification = NULL;
+    struct link_commitNotification *next = NULL;
+    struct weston_layout_ChangeEntry *entries = NULL;
+    struct weston_layout_ChangeEntry *filtered = NULL;
+    struct weston_layout_ChangeEntry *saved_sending = NULL;
+    uint32_t saved_sending_length = 0;
+    uint32_t length = 0;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+    uint32_t mask = 0;
+    uint32_t i = 0;
+
+    if (layout->commit_notification.length == 0) {
+        return;
+    }
+
+    /* Take over entries, callbacks may commit changes again */
+    entries  = layout->commit_notification.entries;
+    length   = layout->commit_notification.length;
+    capacity = layout->commit_notification.capacity;
+    filtered = entries + capacity;
+
+    layout->commit_notification.entries  = NULL;
+    layout->commit_notification.length   = 0;
+    layout->commit_notification.capacity = 0;
+
+    saved_sending        = layout->commit_notification.sending;
+    saved_sending_length = layout->commit_notification.sending_length;
+    layout->commit_notification.sending        = entries;
+    layout->commit_notification.sending_length = length;
+    layout->commit_notification.delivering++;
+
+    wl_list_for_each(notification, &layout->commit_notification.list, link) {
+        if (notification->removed) {
+            continue;
+        }
+
+        count = 0;
+        for (i = 0; i < length; i++) {
+            mask = entries[i].mask & notification->mask;
+            if (mask == 0) {
+                continue;
+            }
+
+            filtered[count] = entries[i];
+            filtered[count].mask = mask;
+            count++;
+        }
+
+        if (count > 0) {
+            notification->callback(filtered, count, notification->userdata);
+        }
+    }
+
+    layout->commit_notification.sending        = saved_sending;
+    layout->commit_notification.sending_length = saved_sending_length;
+
+    /* Free notifications removed by callbacks */
+    layout->commit_notification.delivering--;
+    if (layout->commit_notification.delivering == 0) {
+        wl_list_for_each_safe(notification, next,
+                              &layout->commit_notification.list, link) {
+            if (notification->removed) {
+                wl_list_remove(&notification->link);
+                free(notification);
+            }
+        }
+    }
+
+    /* Give back memory to be reused by next commit */
+    if (layout->commit_notification.entries == NULL) {
+        layout->commit_notification.entries  = entries;
+        layout->commit_notification.capacity = capacity;
+    } else {
+        free(entries);
+    }
+}
+
+static void
+send_prop(struct weston_layout *layout)
+{
+    struct weston_layout_layer   *ivilayer = NULL;
+    struct weston_layout_surface *ivisurf  = NULL;
+    struct wl_list list_layer;
+    struct wl_list list_surface;
+    int batch = !wl_list_empty(&layout->commit_notification.list);
+
+    /* Take over dirty lists in order not to see changes by callbacks */
+    wl_list_init(&list_layer);
+    wl_list_insert_list(&list_layer, &layout->dirty.list_layer);
+    wl_list_init(&layout->dirty.list_layer);
+
+    wl_list_init(&list_surface);
+    wl_list_insert_list(&list_surface, &layout->dirty.list_surface);
+    wl_list_init(&layout->dirty.list_surface);
+
+    while (!wl_list_empty(&list_layer)) {
+        ivilayer = container_of(list_layer.next,
+                                struct weston_layout_layer, dirty_link);
+        if (batch && ivilayer->event_mask) {
+            append_change_entry(layout, NULL, ivilayer, ivilayer->event_mask);
+        }
+        send_layer_prop(ivilayer);
+    }
+
+    while (!wl_list_empty(&list_surface)) {
+        ivisurf = container_of(list_surface.next,
+                               struct weston_layout_surface, dirty_link);
+        if (batch && ivisurf->event_mask) {
+            append_change_entry(layout, ivisurf, NULL, ivisurf->event_mask);
+        }
+        send_surface_prop(ivisurf);
+    }
+
+    send_commit_notification(layout);
+}
+
+/**
+ * Internal APIs for screenshot of screen. Output is read back into a
+ * pooled buffer on compositor thread. Y-flip and png encoding are done in
+ * place by worker thread, then the result is reported on compositor
+ * thread through the pipe.
+ */
+static struct screenshot_buffer *
+screenshot_get_buffer(struct weston_layout *layout, size_t size)
+{
+    struct screenshot_buffer *buffer = NULL;
+
+    if (!wl_list_empty(&layout->screenshot.list_buffer)) {
+        buffer = container_of(layout->screenshot.list_buffer.next,
+                              struct screenshot_buffer, link);
+        wl_list_remove(&buffer->link);
+        layout->screenshot.buffer_count--;
+
+        if (buffer->size >= size) {
+            return buffer;
+        }
+
+        free(buffer->data);
+        free(buffer);
+    }
+
+    buffer = malloc(sizeof *buffer);
+    if (buffer == NULL) {
+        weston_log("fails to allocate memory\n");
+        return NULL;
+    }
+
+    buffer->data = malloc(size);
+    if (buffer->data == NULL) {
+        weston_log("fails to allocate memory\n");
+        free(buffer);
+        return NULL;
+    }
+    buffer->size = size;
+
+    return buffer;
+}
+
+static void
+screenshot_put_buffer(struct weston_layout *layout,
+                      struct screenshot_buffer *buffer)
+{
+    if (layout->screenshot.buffer_count >= SCREENSHOT_BUFFER_POOL_SIZE) {
+        free(buffer->data);
+        free(buffer);
+        return;
+    }
+
+    wl_list_insert(&layout->screenshot.list_buffer, &buffer->link);
+    layout->screenshot.buffer_count++;
+}
+
+static void
+screenshot_finish_job(struct weston_layout *layout, struct screenshot_job *job)
+{
+    if (job->buffer != NULL) {
+        screenshot_put_buffer(layout, job->buffer);
+    }
+
+    if (job->callback != NULL) {
+        job->callback(job->iviscrn, job->filename, job->result,
+                      job->userdata);
+    }
+
+    wl_list_remove(&job->job_link);
+    free(job->filename);
+    free(job);
+}
+
+static void
+screenshot_encode(struct screenshot_job *job)
+{
+    cairo_surface_t *cairo_surf = NULL;
+    uint8_t *top = job->buffer->data;
+    uint8_t *bottom = top + job->stride * (job->height - 1);
+    uint32_t *pixel = NULL;
+    uint32_t *end = NULL;
+    uint8_t *row = NULL;
+
+    if (job->yflip) {
+        row = malloc(job->stride);
+        if (row == NULL) {
+            job->result = -1;
+            return;
+        }
+
+        for (; top < bottom; top += job->stride, bottom -= job->stride) {
+            memcpy(row, top, job->stride);
+            memcpy(top, bottom, job->stride);
+            memcpy(bottom, row, job->stride);
+        }
+        free(row);
+    }
+
+    if (job->swap_rb) {
+        pixel = (uint32_t *)job->buffer->data;
+        end = pixel + job->height * job->stride / 4;
+        for (; pixel < end; pixel++) {
+            *pixel = (*pixel & 0xff00ff00) |
+                     ((*pixel & 0x00ff0000) >> 16) |
+                     ((*pixel & 0x000000ff) << 16);
+        }
+    }
+
+    cairo_surf = cairo_image_surface_create_for_data(job->buffer->data,
+                                                  CAIRO_FORMAT_ARGB32,
+                                                  job->width, job->height,
+                                                  job->stride);
+    if (cairo_surface_write_to_png(cairo_surf, job->filename) !=
+        CAIRO_STATUS_SUCCESS) {
+        job->result = -1;
+    }
+    cairo_surface_destroy(cairo_surf);
+}
+
+static void *
+screenshot_worker_thread(void *data)
+{
+    struct weston_layout *layout = data;
+    struct screenshot_job *job = NULL;
+    char tmp = 0;
+    ssize_t ret = 0;
+
+    pthread_mutex_lock(&layout->screenshot.mutex);
+
+    while (1) {
+        while (wl_list_empty(&layout->screenshot.list_input) &&
+               !layout->screenshot.stop) {
+            pthread_cond_wait(&layout->screenshot.input_cond,
+                              &layout->screenshot.mutex);
+        }
+
+        if (layout->screenshot.stop) {
+            break;
+        }
+
+        job = container_of(layout->screenshot.list_input.next,
+                           struct screenshot_job, link);
+        wl_list_remove(&job->link);
+
+        pthread_mutex_unlock(&layout->screenshot.mutex);
+        screenshot_encode(job);
+        pthread_mutex_lock(&layout->screenshot.mutex);
+
+        wl_list_insert(layout->screenshot.list_done.prev, &job->link);
+
+        /* If the pipe is full, pending bytes wake compositor thread anyway */
+        ret = write(layout->screenshot.writefd, &tmp, 1);
+        (void)ret;
+    }
+
+    pthread_mutex_unlock(&layout->screenshot.mutex);
+
+    return NULL;
+}
+
+static int
+screenshot_dispatch_done(int fd, uint32_t mask, void *data)
+{
+    struct weston_layout *layout = data;
+    struct screenshot_job *job = NULL;
+    struct wl_list list_done;
+    char tmp[16];
+
+    while (read(fd, tmp, sizeof tmp) == sizeof tmp)
+        ;
+
+    wl_list_init(&list_done);
+    pthread_mutex_lock(&layout->screenshot.mutex);
+    wl_list_insert_list(&list_done, &layout->screenshot.list_done);
+    wl_list_init(&layout->screenshot.list_done);
+    pthread_mutex_unlock(&layout->screenshot.mutex);
+
+    while (!wl_list_empty(&list_done)) {
+        job = container_of(list_done.next, struct screenshot_job, link);
+        wl_list_remove(&job->link);
+        screenshot_finish_job(layout, job);
+    }
+
+    return 1;
+}
+
+/**
+ * Jobs which are not read back yet fail. Jobs being encoded are reported
+ * without screen.
+ */
+static void
+screenshot_cancel_screen(struct weston_layout *layout,
+                         struct weston_layout_screen *iviscrn)
+{
+    struct screenshot_job *job = NULL;
+    struct screenshot_job *next = NULL;
+
+    if (!layout->screenshot.started) {
+        return;
+    }
+
+    wl_list_for_each_safe(job, next, &layout->screenshot.list_job, job_link) {
+        if (job->iviscrn != iviscrn) {
+            continue;
+        }
+
+        if (job->reading) {
+            wl_list_remove(&job->frame_listener.link);
+            iviscrn->output->disable_planes--;
+            job->result = -1;
+            screenshot_finish_job(layout, job);
+            continue;
+        }
+
+        job->iviscrn = NULL;
+    }
+}
+
+/**
+ * Called at destruction of compositor. Jobs left are dropped without
+ * callback.
+ */
+static void
+screenshot_stop_worker(struct wl_listener *listener, void *data)
+{
+    struct weston_layout *layout =
+        container_of(listener, struct weston_layout,
+                     screenshot.destroy_listener);
+    struct screenshot_job *job = NULL;
+    struct screenshot_job *next = NULL;
+    struct screenshot_buffer *buffer = NULL;
+    struct screenshot_buffer *next_buffer = NULL;
+
+    pthread_mutex_lock(&layout->screenshot.mutex);
+    layout->screenshot.stop = 1;
+    pthread_cond_signal(&layout->screenshot.input_cond);
+    pthread_mutex_unlock(&layout->screenshot.mutex);
+
+    pthread_join(layout->screenshot.thread, NULL);
+
+    wl_list_remove(&layout->screenshot.destroy_listener.link);
+    wl_event_source_remove(layout->screenshot.done_source);
+    close(layout->screenshot.readfd);
+    close(layout->screenshot.writefd);
+    pthread_mutex_destroy(&layout->screenshot.mutex);
+    pthread_cond_destroy(&layout->screenshot.input_cond);
+
+    wl_list_for_each_safe(job, next, &layout->screenshot.list_job, job_link) {
+        if (job->reading) {
+            wl_list_remove(&job->frame_listener.link);
+            job->iviscrn->output->disable_planes--;
+        }
+        if (job->buffer != NULL) {
+            free(job->buffer->data);
+            free(job->buffer);
+        }
+        free(job->filename);
+        free(job);
+    }
+
+    wl_list_for_each_safe(buffer, next_buffer,
+                          &layout->screenshot.list_buffer, link) {
+        free(buffer->data);
+        free(buffer);
+    }
+
+    layout->screenshot.started = 0;
+}
+
+static int
+screenshot_start_worker(struct weston_layout *layout)
+{
+    struct wl_event_loop *loop = NULL;
+    int fd[2];
+
+    if (layout->screenshot.started) {
+        return 0;
+    }
+
+    wl_list_init(&layout->screenshot.list_input);
+    wl_list_init(&layout->screenshot.list_done);
+    wl_list_init(&layout->screenshot.list_job);
+    wl_list_init(&layout->screenshot.list_buffer);
+    layout->screenshot.buffer_count = 0;
+    layout->screenshot.stop = 0;
 
-        break;
+    if (pipe2(fd, O_CLOEXEC | O_NONBLOCK) == -1) {
+        weston_log("fails to create pipe for screenshot\n");
+        return -1;
+    }
+    layout->screenshot.readfd  = fd[0];
+    layout->screenshot.writefd = fd[1];
+
+    loop = wl_display_get_event_loop(layout->compositor->wl_display);
+    layout->screenshot.done_source =
+        wl_event_loop_add_fd(loop, layout->screenshot.readfd,
+                             WL_EVENT_READABLE,
+                             screenshot_dispatch_done, layout);
+    if (layout->screenshot.done_source == NULL) {
+        goto err_pipe;
     }
+
+    pthread_mutex_init(&layout->screenshot.mutex, NULL);
+    pthread_cond_init(&layout->screenshot.input_cond, NULL);
+    if (pthread_create(&layout->screenshot.thread, NULL,
+                       screenshot_worker_thread, layout) != 0) {
+        weston_log("fails to create thread for screenshot\n");
+        goto err_thread;
+    }
+
+    layout->screenshot.destroy_listener.notify = screenshot_stop_worker;
+    wl_signal_add(&layout->compositor->destroy_signal,
+                  &layout->screenshot.destroy_listener);
+
+    layout->screenshot.started = 1;
+
+    return 0;
+
+err_thread:
+    pthread_mutex_destroy(&layout->screenshot.mutex);
+    pthread_cond_destroy(&layout->screenshot.input_cond);
+    wl_event_source_remove(layout->screenshot.done_source);
+err_pipe:
+    close(layout->screenshot.readfd);
+    close(layout->screenshot.writefd);
+
+    return -1;
 }
 
 static void
-send_surface_prop(struct weston_layout_surface *ivisurf)
+screenshot_frame_notify(struct wl_listener *listener, void *data)
 {
-    struct link_surfacePropertyNotification *notification = NULL;
+    struct weston_layout *layout = get_instance();
+    struct screenshot_job *job =
+        container_of(listener, struct screenshot_job, frame_listener);
+    struct weston_output *output = data;
+    struct weston_compositor *ec = output->compositor;
 
-    wl_list_for_each(notification, &ivisurf->list_notification, link) {
-        notification->callback(ivisurf, &ivisurf->prop,
-                               ivisurf->event_mask,
-                               notification->userdata);
+    output->disable_planes--;
+    wl_list_remove(&listener->link);
+    job->reading = 0;
+
+    job->width  = output->current_mode->width;
+    job->height = output->current_mode->height;
+    job->stride = job->width * (PIXMAN_FORMAT_BPP(ec->read_format) / 8);
+    job->yflip  = !!(ec->capabilities & WESTON_CAP_CAPTURE_YFLIP);
+    job->swap_rb = ec->read_format == PIXMAN_a8b8g8r8 ||
+                   ec->read_format == PIXMAN_x8b8g8r8;
+
+    job->buffer = screenshot_get_buffer(layout, job->stride * job->height);
+    if (job->buffer == NULL ||
+        ec->renderer->read_pixels(output, ec->read_format, job->buffer->data,
+                                  0, 0, job->width, job->height) != 0) {
+        job->result = -1;
+        screenshot_finish_job(layout, job);
+        return;
     }
 
-    ivisurf->event_mask = 0;
+    pthread_mutex_lock(&layout->screenshot.mutex);
+    wl_list_insert(layout->screenshot.list_input.prev, &job->link);
+    pthread_cond_signal(&layout->screenshot.input_cond);
+    pthread_mutex_unlock(&layout->screenshot.mutex);
+}
+
+/**
+ * Internal APIs for offscreen screenshot of surface and layer.
+ */
+static pixman_image_t *
+read_surface_image(struct weston_layout_surface *ivisurf)
+{
+    struct weston_renderer *renderer = ivisurf->layout->compositor->renderer;
+    pixman_image_t *image = NULL;
+    int32_t width  = ivisurf->buffer_width;
+    int32_t height = ivisurf->buffer_height;
+
+    if (ivisurf->surface == NULL || renderer->read_surface_pixels == NULL ||
+        width == 0 || height == 0) {
+        return NULL;
+    }
+
+    image = pixman_image_create_bits(PIXMAN_a8r8g8b8, width, height, NULL, 0);
+    if (image == NULL) {
+        weston_log("fails to allocate memory\n");
+        return NULL;
+    }
+
+    if (renderer->read_surface_pixels(ivisurf->surface, PIXMAN_a8r8g8b8,
+                                      pixman_image_get_data(image),
+                                      0, 0, width, height) != 0) {
+        pixman_image_unref(image);
+        return NULL;
+    }
+
+    return image;
+}
+
+/**
+ * Alpha of a surface as update_opacity gives its view, where opacity is in
+ * wl_fixed units. ivilayer may be NULL to take the surface alone. Returns
+ * NULL if the surface is opaque.
+ */
+static pixman_image_t *
+create_opacity_mask(struct weston_layout_layer *ivilayer,
+                    struct weston_layout_surface *ivisurf)
+{
+    pixman_color_t color = {0};
+    double alpha = wl_fixed_to_double(ivisurf->prop.opacity);
+
+    if (ivilayer != NULL) {
+        alpha *= wl_fixed_to_double(ivilayer->prop.opacity);
+    }
+
+    if (alpha >= 1.0) {
+        return NULL;
+    }
+    if (alpha < 0.0) {
+        alpha = 0.0;
+    }
+
+    color.alpha = (uint16_t)(alpha * 0xffff + 0.5);
+
+    return pixman_image_create_solid_fill(&color);
 }
 
+/**
+ * Draw a surface in layer coordinates where the source rectangle of
+ * layer starts at (0, 0) of image.
+ */
 static void
-send_layer_prop(struct weston_layout_layer *ivilayer)
+draw_surface_image(pixman_image_t *image, pixman_image_t *surf_image,
+                   struct weston_layout_layer *ivilayer,
+                   struct weston_layout_surface *ivisurf)
 {
-    struct link_layerPropertyNotification *notification = NULL;
+    struct weston_layout_SurfaceProperties *prop = &ivisurf->prop;
+    pixman_image_t *mask = NULL;
+    pixman_transform_t transform;
+    int32_t x = prop->destX - (int32_t)ivilayer->prop.sourceX;
+    int32_t y = prop->destY - (int32_t)ivilayer->prop.sourceY;
+    uint32_t src_width  = prop->sourceWidth  ? prop->sourceWidth  : ivisurf->buffer_width;
+    uint32_t src_height = prop->sourceHeight ? prop->sourceHeight : ivisurf->buffer_height;
+    uint32_t dst_width  = prop->destWidth  ? prop->destWidth  : src_width;
+    uint32_t dst_height = prop->destHeight ? prop->destHeight : src_height;
+
+    /* destination rect to source rect, offset (x, y) is by composite */
+    pixman_transform_init_identity(&transform);
+    pixman_transform_scale(&transform, NULL,
+            pixman_double_to_fixed((double)src_width  / dst_width),
+            pixman_double_to_fixed((double)src_height / dst_height));
+    pixman_transform_translate(&transform, NULL,
+                               pixman_int_to_fixed(prop->sourceX),
+                               pixman_int_to_fixed(prop->sourceY));
+    pixman_image_set_transform(surf_image, &transform);
+
+    if (src_width != dst_width || src_height != dst_height) {
+        pixman_image_set_filter(surf_image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    }
+
+    mask = create_opacity_mask(ivilayer, ivisurf);
+
+    pixman_image_composite32(PIXMAN_OP_OVER, surf_image, mask, image,
+                             0, 0, 0, 0, x, y, dst_width, dst_height);
+
+    if (mask != NULL) {
+        pixman_image_unref(mask);
+    }
+}
 
-    wl_list_for_each(notification, &ivilayer->list_notification, link) {
-        notification->callback(ivilayer, &ivilayer->prop,
-                               ivilayer->event_mask,
-                               notification->userdata);
+static int32_t
+write_png(const char *filename, pixman_image_t *image)
+{
+    cairo_surface_t *cairo_surf = NULL;
+    cairo_status_t status;
+
+    cairo_surf = cairo_image_surface_create_for_data(
+                     (unsigned char *)pixman_image_get_data(image),
+                     CAIRO_FORMAT_ARGB32,
+                     pixman_image_get_width(image),
+                     pixman_image_get_height(image),
+                     pixman_image_get_stride(image));
+    status = cairo_surface_write_to_png(cairo_surf, filename);
+    cairo_surface_destroy(cairo_surf);
+
+    if (status != CAIRO_STATUS_SUCCESS) {
+        weston_log("fails to write %s\n", filename);
+        return -1;
     }
 
-    ivilayer->event_mask = 0;
+    return 0;
+}
+
+/**
+ * Internal APIs to record calls of exported APIs which change layout, so
+ * that the same sequence can be replayed to analyze performance without
+ * the whole system. The file format is described in weston-layout-record.h.
+ */
+static uint64_t
+record_get_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
 }
 
 static void
-send_prop(struct weston_layout *layout)
+record_call(uint32_t opcode, const uint32_t *args, uint32_t count)
 {
-    struct weston_layout_layer   *ivilayer = NULL;
-    struct weston_layout_surface *ivisurf  = NULL;
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_Record record;
+    uint64_t now = 0;
 
-    wl_list_for_each(ivilayer, &layout->list_layer, link) {
-        send_layer_prop(ivilayer);
+    if (layout->record.file == NULL) {
+        return;
+    }
+
+    now = record_get_time_us();
+    record.opcode = opcode;
+    record.argCount = count;
+    record.timeDelta = (uint32_t)(now - layout->record.time);
+    layout->record.time = now;
+
+    if (fwrite(&record, sizeof record, 1, layout->record.file) != 1 ||
+        (count > 0 &&
+         fwrite(args, sizeof *args, count, layout->record.file) != count)) {
+        weston_log("fails to write recording of weston-layout\n");
+        weston_layout_stopRecording();
+        return;
+    }
+
+    /* recording survives a crash up to the last commit */
+    if (opcode == WESTON_LAYOUT_RECORD_COMMIT) {
+        fflush(layout->record.file);
+    }
+}
+
+#define RECORD_MAX_ARGS 8
+
+static void
+record_args(uint32_t opcode, uint32_t count, ...)
+{
+    struct weston_layout *layout = get_instance();
+    uint32_t args[RECORD_MAX_ARGS];
+    va_list ap;
+    uint32_t i = 0;
+
+    if (layout->record.file == NULL) {
+        return;
+    }
+
+    assert(count <= RECORD_MAX_ARGS);
+
+    va_start(ap, count);
+    for (i = 0; i < count; i++) {
+        args[i] = va_arg(ap, uint32_t);
+    }
+    va_end(ap);
+
+    record_call(opcode, args, count);
+}
+
+static uint32_t
+record_float(float value)
+{
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+
+    bits.f = value;
+
+    return bits.u;
+}
+
+static void
+record_surface_order(struct weston_layout_layer *ivilayer,
+                     struct weston_layout_surface **pSurface,
+                     uint32_t number)
+{
+    struct weston_layout *layout = get_instance();
+    uint32_t *args = NULL;
+    uint32_t i = 0;
+
+    if (layout->record.file == NULL) {
+        return;
+    }
+
+    if (pSurface == NULL) {
+        number = 0;
+    }
+
+    args = malloc((number + 1) * sizeof *args);
+    if (args == NULL) {
+        weston_log("fails to allocate memory\n");
+        return;
+    }
+
+    args[0] = ivilayer->id_layer;
+    for (i = 0; i < number; i++) {
+        args[i + 1] = pSurface[i]->id_surface;
+    }
+
+    record_call(WESTON_LAYOUT_RECORD_LAYER_RENDER_ORDER, args, number + 1);
+    free(args);
+}
+
+static void
+record_layer_order(struct weston_layout_screen *iviscrn,
+                   struct weston_layout_layer **pLayer,
+                   uint32_t number)
+{
+    struct weston_layout *layout = get_instance();
+    uint32_t *args = NULL;
+    uint32_t i = 0;
+
+    if (layout->record.file == NULL) {
+        return;
+    }
+
+    if (pLayer == NULL) {
+        number = 0;
     }
 
+    args = malloc((number + 1) * sizeof *args);
+    if (args == NULL) {
+        weston_log("fails to allocate memory\n");
+        return;
+    }
+
+    args[0] = iviscrn->id_screen;
+    for (i = 0; i < number; i++) {
+        args[i + 1] = pLayer[i]->id_layer;
+    }
+
+    record_call(WESTON_LAYOUT_RECORD_SCREEN_RENDER_ORDER, args, number + 1);
+    free(args);
+}
+
+/**
+ * Objects which exist when recording starts are recorded as if they were
+ * created and committed at the time.
+ */
+static void
+record_snapshot(struct weston_layout *layout)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+    struct weston_layout_layer *ivilayer = NULL;
+    struct weston_layout_screen *iviscrn = NULL;
+    struct weston_layout_SurfaceProperties *sprop = NULL;
+    struct weston_layout_LayerProperties *lprop = NULL;
+    uint32_t id = 0;
+
     wl_list_for_each(ivisurf, &layout->list_surface, link) {
-        send_surface_prop(ivisurf);
+        id = ivisurf->id_surface;
+        sprop = &ivisurf->prop;
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_CREATE, 1, id);
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_CONFIGURE, 3, id,
+                    ivisurf->buffer_width, ivisurf->buffer_height);
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_VISIBILITY, 2, id,
+                    sprop->visibility);
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_OPACITY, 2, id,
+                    record_float(sprop->opacity));
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_SOURCE_RECT, 5, id,
+                    sprop->sourceX, sprop->sourceY,
+                    sprop->sourceWidth, sprop->sourceHeight);
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_DEST_RECT, 5, id,
+                    sprop->destX, sprop->destY,
+                    sprop->destWidth, sprop->destHeight);
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_ORIENTATION, 2, id,
+                    sprop->orientation);
+    }
+
+    wl_list_for_each(ivilayer, &layout->list_layer, link) {
+        id = ivilayer->id_layer;
+        lprop = &ivilayer->prop;
+        record_args(WESTON_LAYOUT_RECORD_LAYER_CREATE, 3, id,
+                    lprop->origSourceWidth, lprop->origSourceHeight);
+        record_args(WESTON_LAYOUT_RECORD_LAYER_VISIBILITY, 2, id,
+                    lprop->visibility);
+        record_args(WESTON_LAYOUT_RECORD_LAYER_OPACITY, 2, id,
+                    record_float(lprop->opacity));
+        record_args(WESTON_LAYOUT_RECORD_LAYER_SOURCE_RECT, 5, id,
+                    lprop->sourceX, lprop->sourceY,
+                    lprop->sourceWidth, lprop->sourceHeight);
+        record_args(WESTON_LAYOUT_RECORD_LAYER_DEST_RECT, 5, id,
+                    lprop->destX, lprop->destY,
+                    lprop->destWidth, lprop->destHeight);
+        record_args(WESTON_LAYOUT_RECORD_LAYER_ORIENTATION, 2, id,
+                    lprop->orientation);
+        record_args(WESTON_LAYOUT_RECORD_LAYER_RENDER_CACHE, 2, id,
+                    ivilayer->cache.enabled);
+
+        /* surfaces and layers are added to the head of the order */
+        wl_list_for_each_reverse(ivisurf, &ivilayer->order.list_surface,
+                                 order.link) {
+            record_args(WESTON_LAYOUT_RECORD_LAYER_ADD_SURFACE, 2, id,
+                        ivisurf->id_surface);
+        }
+    }
+
+    wl_list_for_each(iviscrn, &layout->list_screen, link) {
+        wl_list_for_each_reverse(ivilayer, &iviscrn->order.list_layer,
+                                 order.link) {
+            record_args(WESTON_LAYOUT_RECORD_SCREEN_ADD_LAYER, 2,
+                        iviscrn->id_screen, ivilayer->id_layer);
+        }
     }
+
+    record_call(WESTON_LAYOUT_RECORD_COMMIT, NULL, 0);
+}
+
+static void
+record_compositor_destroy(struct wl_listener *listener, void *data)
+{
+    weston_layout_stopRecording();
 }
 
 /**
@@ -903,6 +3219,7 @@ WL_EXPORT void
 weston_layout_initWithCompositor(struct weston_compositor *ec)
 {
     struct weston_layout *layout = get_instance();
+    struct weston_output *output = NULL;
 
     layout->compositor = ec;
 
@@ -910,30 +3227,169 @@ weston_layout_initWithCompositor(struct weston_compositor *ec)
     wl_list_init(&layout->list_layer);
     wl_list_init(&layout->list_screen);
 
+    wl_list_init(&layout->dirty.list_surface);
+    wl_list_init(&layout->dirty.list_layer);
+    wl_list_init(&layout->dirty.list_screen);
+
     wl_list_init(&layout->layer_notification.list_create);
     wl_list_init(&layout->layer_notification.list_remove);
 
     wl_list_init(&layout->surface_notification.list_create);
     wl_list_init(&layout->surface_notification.list_remove);
     wl_list_init(&layout->surface_notification.list_configure);
+    wl_list_init(&layout->surface_notification.list_visibility);
 
-    /* Add layout_layer at the last of weston_compositor.layer_list */
-    weston_layer_init(&layout->layout_layer, ec->layer_list.prev);
+    wl_list_init(&layout->commit_notification.list);
+
+    wl_list_for_each(output, &ec->output_list, link) {
+        create_screen(layout, output);
+    }
+
+    layout->output_created_listener.notify = output_created;
+    wl_signal_add(&ec->output_created_signal,
+                  &layout->output_created_listener);
+
+    struct weston_config *config = weston_config_parse("weston.ini");
+    struct weston_config_section *s =
+            weston_config_get_section(config, "ivi-shell", NULL, NULL);
+
+    /*A cursor is configured if weston.ini has keys.*/
+    char* cursor_theme = NULL;
+    weston_config_section_get_string(s, "cursor-theme", &cursor_theme, NULL);
+    if (cursor_theme)
+        free(cursor_theme);
+    else {
+        wl_list_remove(&ec->cursor_layer.link);
+        weston_compositor_scene_changed(ec);
+    }
+
+    char *record_file = NULL;
+    weston_config_section_get_string(s, "layout-record", &record_file, NULL);
+    if (record_file) {
+        weston_layout_startRecording(record_file);
+        free(record_file);
+    }
+    weston_config_destroy(config);
+}
+
+WL_EXPORT int32_t
+weston_layout_startRecording(const char *filename)
+{
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_RecordHeader header;
+
+    if (filename == NULL) {
+        weston_log("weston_layout_startRecording: invalid argument\n");
+        return -1;
+    }
+
+    if (layout->record.file != NULL) {
+        weston_log("weston_layout_startRecording: already recording\n");
+        return -1;
+    }
+
+    layout->record.file = fopen(filename, "wb");
+    if (layout->record.file == NULL) {
+        weston_log("fails to open %s\n", filename);
+        return -1;
+    }
+
+    header.magic = WESTON_LAYOUT_RECORD_MAGIC;
+    header.version = WESTON_LAYOUT_RECORD_VERSION;
+    if (fwrite(&header, sizeof header, 1, layout->record.file) != 1) {
+        weston_log("fails to write %s\n", filename);
+        fclose(layout->record.file);
+        layout->record.file = NULL;
+        return -1;
+    }
+
+    layout->record.destroy_listener.notify = record_compositor_destroy;
+    wl_signal_add(&layout->compositor->destroy_signal,
+                  &layout->record.destroy_listener);
+
+    layout->record.time = record_get_time_us();
+    record_snapshot(layout);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_stopRecording(void)
+{
+    struct weston_layout *layout = get_instance();
+
+    if (layout->record.file == NULL) {
+        weston_log("weston_layout_stopRecording: not recording\n");
+        return -1;
+    }
+
+    wl_list_remove(&layout->record.destroy_listener.link);
+    fclose(layout->record.file);
+    layout->record.file = NULL;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_setNotificationCommit(uint32_t mask,
+                                    commitNotificationFunc callback,
+                                    void *userdata)
+{
+    struct weston_layout *layout = get_instance();
+    struct link_commitNotification *notification = NULL;
+
+    if (callback == NULL || mask == 0) {
+        weston_log("weston_layout_setNotificationCommit: invalid argument\n");
+        return -1;
+    }
+
+    notification = malloc(sizeof *notification);
+    if (notification == NULL) {
+        weston_log("fails to allocate memory\n");
+        return -1;
+    }
+
+    notification->callback = callback;
+    notification->userdata = userdata;
+    notification->mask = mask;
+    notification->removed = 0;
+    wl_list_init(&notification->link);
+    wl_list_insert(layout->commit_notification.list.prev, &notification->link);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_removeNotificationCommit(commitNotificationFunc callback,
+                                       void *userdata)
+{
+    struct weston_layout *layout = get_instance();
+    struct link_commitNotification *notification = NULL;
+    struct link_commitNotification *next = NULL;
+
+    if (callback == NULL) {
+        weston_log("weston_layout_removeNotificationCommit: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each_safe(notification, next,
+                          &layout->commit_notification.list, link) {
+        if (notification->callback != callback ||
+            notification->userdata != userdata) {
+            continue;
+        }
 
-    create_screen(ec);
+        /* the entry may be the next one of a delivery in progress */
+        if (layout->commit_notification.delivering > 0) {
+            notification->removed = 1;
+            continue;
+        }
 
-    struct weston_config *config = weston_config_parse("weston.ini");
-    struct weston_config_section *s =
-            weston_config_get_section(config, "ivi-shell", NULL, NULL);
+        wl_list_remove(&notification->link);
+        free(notification);
+    }
 
-    /*A cursor is configured if weston.ini has keys.*/
-    char* cursor_theme = NULL;
-    weston_config_section_get_string(s, "cursor-theme", &cursor_theme, NULL);
-    if (cursor_theme)
-        free(cursor_theme);
-    else
-        wl_list_remove(&ec->cursor_layer.link);
-    weston_config_destroy(config);
+    return 0;
 }
 
 WL_EXPORT int32_t
@@ -1066,6 +3522,46 @@ weston_layout_setNotificationConfigureSurface(surfaceConfigureNotificationFunc c
     return 0;
 }
 
+WL_EXPORT int32_t
+weston_layout_setNotificationSurfaceVisibility(surfaceVisibilityNotificationFunc callback,
+                                               void *userdata)
+{
+    struct weston_layout *layout = get_instance();
+    struct link_surfaceVisibilityNotification *notification = NULL;
+
+    if (callback == NULL) {
+        weston_log("weston_layout_setNotificationSurfaceVisibility: invalid argument\n");
+        return -1;
+    }
+
+    notification = malloc(sizeof *notification);
+    if (notification == NULL) {
+        weston_log("fails to allocate memory\n");
+        return -1;
+    }
+
+    notification->callback = callback;
+    notification->userdata = userdata;
+    wl_list_init(&notification->link);
+    wl_list_insert(&layout->surface_notification.list_visibility, &notification->link);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_surfaceGetVisibleOnScreen(struct weston_layout_surface *ivisurf,
+                                        int32_t *pVisible)
+{
+    if (ivisurf == NULL || pVisible == NULL) {
+        weston_log("weston_layout_surfaceGetVisibleOnScreen: invalid argument\n");
+        return -1;
+    }
+
+    *pVisible = ivisurf->visible;
+
+    return 0;
+}
+
 WL_EXPORT uint32_t
 weston_layout_getIdOfSurface(struct weston_layout_surface *ivisurf)
 {
@@ -1082,46 +3578,24 @@ WL_EXPORT struct weston_layout_layer *
 weston_layout_getLayerFromId(uint32_t id_layer)
 {
     struct weston_layout *layout = get_instance();
-    struct weston_layout_layer *ivilayer = NULL;
-
-    wl_list_for_each(ivilayer, &layout->list_layer, link) {
-        if (ivilayer->id_layer == id_layer) {
-            return ivilayer;
-        }
-    }
 
-    return NULL;
+    return get_layer(layout, id_layer);
 }
 
 WL_EXPORT struct weston_layout_surface *
 weston_layout_getSurfaceFromId(uint32_t id_surface)
 {
     struct weston_layout *layout = get_instance();
-    struct weston_layout_surface *ivisurf = NULL;
-
-    wl_list_for_each(ivisurf, &layout->list_surface, link) {
-        if (ivisurf->id_surface == id_surface) {
-            return ivisurf;
-        }
-    }
 
-    return NULL;
+    return get_surface(layout, id_surface);
 }
 
 WL_EXPORT struct weston_layout_screen *
 weston_layout_getScreenFromId(uint32_t id_screen)
 {
     struct weston_layout *layout = get_instance();
-    struct weston_layout_screen *iviscrn = NULL;
-    (void)id_screen;
-
-    wl_list_for_each(iviscrn, &layout->list_screen, link) {
-//FIXME : select iviscrn from list_screen by id_screen
-        return iviscrn;
-        break;
-    }
 
-    return NULL;
+    return get_screen(layout, id_screen);
 }
 
 WL_EXPORT int32_t
@@ -1204,7 +3678,7 @@ weston_layout_surfaceCreate(struct weston_surface *wl_surface,
         return NULL;
     }
 
-    ivisurf = get_surface(&layout->list_surface, id_surface);
+    ivisurf = get_surface(layout, id_surface);
     if (ivisurf != NULL) {
         if (ivisurf->surface != NULL) {
             weston_log("id_surface(%d) is already created\n", id_surface);
@@ -1228,16 +3702,32 @@ weston_layout_surfaceCreate(struct weston_surface *wl_surface,
     }
 
     wl_list_init(&ivisurf->link);
+    wl_list_init(&ivisurf->hash.link);
+    wl_list_init(&ivisurf->dirty_link);
     wl_list_init(&ivisurf->list_notification);
     wl_list_init(&ivisurf->list_layer);
+    pixman_region32_init(&ivisurf->occlusion.opaque);
     ivisurf->id_surface = id_surface;
     ivisurf->layout = layout;
 
+    if (id_hash_insert(&layout->hash_surface, &ivisurf->hash,
+                       id_surface) != 0) {
+        pixman_region32_fini(&ivisurf->occlusion.opaque);
+        free(ivisurf);
+        return NULL;
+    }
+
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_CREATE, 1, id_surface);
+
     ivisurf->surface = wl_surface;
     ivisurf->surface_destroy_listener.notify =
         westonsurface_destroy_from_ivisurface;
-    wl_resource_add_destroy_listener(wl_surface->resource,
-                                     &ivisurf->surface_destroy_listener);
+    wl_signal_add(&wl_surface->destroy_signal,
+                  &ivisurf->surface_destroy_listener);
+    ivisurf->surface_commit_listener.notify =
+        westonsurface_commit_from_ivisurface;
+    wl_signal_add(&wl_surface->commit_signal,
+                  &ivisurf->surface_commit_listener);
 
     ivisurf->view = weston_view_create(wl_surface);
     if (ivisurf->view == NULL) {
@@ -1249,17 +3739,8 @@ weston_layout_surfaceCreate(struct weston_surface *wl_surface,
 
     weston_matrix_init(&ivisurf->view->transform.matrix);
 
-    weston_matrix_init(&ivisurf->surface_rotation.matrix);
-    weston_matrix_init(&ivisurf->layer_rotation.matrix);
-    weston_matrix_init(&ivisurf->surface_pos.matrix);
-    weston_matrix_init(&ivisurf->layer_pos.matrix);
-    weston_matrix_init(&ivisurf->scaling.matrix);
-
-    wl_list_init(&ivisurf->surface_rotation.link);
-    wl_list_init(&ivisurf->layer_rotation.link);
-    wl_list_init(&ivisurf->surface_pos.link);
-    wl_list_init(&ivisurf->layer_pos.link);
-    wl_list_init(&ivisurf->scaling.link);
+    weston_matrix_init(&ivisurf->layout_transform.matrix);
+    wl_list_init(&ivisurf->layout_transform.link);
 
     init_surfaceProperties(&ivisurf->prop);
     ivisurf->pixelformat = WESTON_LAYOUT_SURFACE_PIXELFORMAT_RGBA_8888;
@@ -1293,12 +3774,15 @@ weston_layout_surfaceSetNativeContent(struct weston_surface *surface,
     struct weston_layout_surface *ivisurf;
     struct link_surfaceCreateNotification *notification = NULL;
 
-    ivisurf = get_surface(&layout->list_surface, id_surface);
+    ivisurf = get_surface(layout, id_surface);
     if (ivisurf == NULL) {
         weston_log("layout surface is not found\n");
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_NATIVE_CONTENT, 4, id_surface,
+                surface != NULL, width, height);
+
     if (ivisurf->surface != NULL) {
         if (surface != NULL) {
             weston_log("id_surface(%d) is already set the native content\n",
@@ -1306,7 +3790,13 @@ weston_layout_surfaceSetNativeContent(struct weston_surface *surface,
             return -1;
         }
 
+        invalidate_surface_layer_caches(ivisurf);
         wl_list_remove(&ivisurf->surface_destroy_listener.link);
+        wl_list_remove(&ivisurf->surface_commit_listener.link);
+        if (!wl_list_empty(&ivisurf->layout_transform.link)) {
+            wl_list_remove(&ivisurf->layout_transform.link);
+            wl_list_init(&ivisurf->layout_transform.link);
+        }
         weston_view_destroy(ivisurf->view);
 
         ivisurf->surface = NULL;
@@ -1319,8 +3809,12 @@ weston_layout_surfaceSetNativeContent(struct weston_surface *surface,
     ivisurf->surface = surface;
     ivisurf->surface_destroy_listener.notify =
         westonsurface_destroy_from_ivisurface;
-    wl_resource_add_destroy_listener(surface->resource,
-                                     &ivisurf->surface_destroy_listener);
+    wl_signal_add(&surface->destroy_signal,
+                  &ivisurf->surface_destroy_listener);
+    ivisurf->surface_commit_listener.notify =
+        westonsurface_commit_from_ivisurface;
+    wl_signal_add(&surface->commit_signal,
+                  &ivisurf->surface_commit_listener);
     ivisurf->view = weston_view_create(surface);
     if (ivisurf->view == NULL) {
         weston_log("fails to allocate memory\n");
@@ -1331,6 +3825,9 @@ weston_layout_surfaceSetNativeContent(struct weston_surface *surface,
     ivisurf->buffer_height = height;
     ivisurf->pixelformat = WESTON_LAYOUT_SURFACE_PIXELFORMAT_RGBA_8888;
 
+    /* new view needs to be added to view list by next commit */
+    layout->dirty.view_list = 1;
+
     wl_list_for_each(notification,
             &layout->surface_notification.list_create, link) {
         if (notification->callback != NULL) {
@@ -1348,6 +3845,9 @@ weston_layout_surfaceConfigure(struct weston_layout_surface *ivisurf,
     struct weston_layout *layout = get_instance();
     struct link_surfaceCreateNotification *notification = NULL;
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_CONFIGURE, 3, ivisurf->id_surface,
+                width, height);
+
     ivisurf->buffer_width  = width;
     ivisurf->buffer_height = height;
 
@@ -1370,6 +3870,8 @@ weston_layout_surfaceRemove(struct weston_layout_surface *ivisurf)
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_REMOVE, 1, ivisurf->id_surface);
+
     if (!wl_list_empty(&ivisurf->pending.link)) {
         wl_list_remove(&ivisurf->pending.link);
     }
@@ -1379,7 +3881,18 @@ weston_layout_surfaceRemove(struct weston_layout_surface *ivisurf)
     if (!wl_list_empty(&ivisurf->link)) {
         wl_list_remove(&ivisurf->link);
     }
+    id_hash_remove(&layout->hash_surface, &ivisurf->hash);
+    if (!wl_list_empty(&ivisurf->dirty_link)) {
+        wl_list_remove(&ivisurf->dirty_link);
+    }
+    invalidate_surface_layer_caches(ivisurf);
     remove_ordersurface_from_layer(ivisurf);
+    forget_change_entry(layout, ivisurf, NULL);
+    if (ivisurf->surface != NULL) {
+        wl_list_remove(&ivisurf->surface_destroy_listener.link);
+        wl_list_remove(&ivisurf->surface_commit_listener.link);
+    }
+    layout->dirty.view_list = 1;
 
     wl_list_for_each(notification,
             &layout->surface_notification.list_remove, link) {
@@ -1388,6 +3901,7 @@ weston_layout_surfaceRemove(struct weston_layout_surface *ivisurf)
         }
     }
 
+    pixman_region32_fini(&ivisurf->occlusion.opaque);
     free(ivisurf);
 
     return 0;
@@ -1562,7 +4076,7 @@ weston_layout_getLayersOnScreen(struct weston_layout_screen *iviscrn,
             return -1;
         }
 
-        wl_list_for_each(ivilayer, &iviscrn->order.list_layer, link) {
+        wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
             (*ppArray)[n++] = ivilayer;
         }
     }
@@ -1634,41 +4148,279 @@ weston_layout_getSurfaces(uint32_t *pLength, weston_layout_surface_ptr **ppArray
         }
     }
 
-    *pLength = length;
+    *pLength = length;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_getSurfacesOnLayer(struct weston_layout_layer *ivilayer,
+                                 uint32_t *pLength,
+                                 weston_layout_surface_ptr **ppArray)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+    uint32_t length = 0;
+    uint32_t n = 0;
+
+    if (ivilayer == NULL || pLength == NULL || ppArray == NULL) {
+        weston_log("weston_layout_getSurfaceIDsOnLayer: invalid argument\n");
+        return -1;
+    }
+
+    length = wl_list_length(&ivilayer->order.list_surface);
+
+    if (length != 0) {
+        /* the Array must be free by module which called this function */
+        *ppArray = calloc(length, sizeof(weston_layout_surface_ptr));
+        if (*ppArray == NULL) {
+            weston_log("fails to allocate memory\n");
+            return -1;
+        }
+
+        wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+            (*ppArray)[n++] = ivisurf;
+        }
+    }
+
+    *pLength = length;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_forEachSurface(surfaceEnumerateFunc callback, void *userdata)
+{
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_surface *ivisurf = NULL;
+    struct weston_layout_surface *next = NULL;
+
+    if (callback == NULL) {
+        weston_log("weston_layout_forEachSurface: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each_safe(ivisurf, next, &layout->list_surface, link) {
+        if (callback(ivisurf, userdata) != 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_forEachLayer(layerEnumerateFunc callback, void *userdata)
+{
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_layer *ivilayer = NULL;
+    struct weston_layout_layer *next = NULL;
+
+    if (callback == NULL) {
+        weston_log("weston_layout_forEachLayer: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each_safe(ivilayer, next, &layout->list_layer, link) {
+        if (callback(ivilayer, userdata) != 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_forEachLayerOnScreen(struct weston_layout_screen *iviscrn,
+                                   layerEnumerateFunc callback,
+                                   void *userdata)
+{
+    struct weston_layout_layer *ivilayer = NULL;
+
+    if (iviscrn == NULL || callback == NULL) {
+        weston_log("weston_layout_forEachLayerOnScreen: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+        if (callback(ivilayer, userdata) != 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_forEachSurfaceOnLayer(struct weston_layout_layer *ivilayer,
+                                    surfaceEnumerateFunc callback,
+                                    void *userdata)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+
+    if (ivilayer == NULL || callback == NULL) {
+        weston_log("weston_layout_forEachSurfaceOnLayer: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (callback(ivisurf, userdata) != 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_forEachScreenUnderLayer(struct weston_layout_layer *ivilayer,
+                                      screenEnumerateFunc callback,
+                                      void *userdata)
+{
+    struct link_screen *link_scrn = NULL;
+
+    if (ivilayer == NULL || callback == NULL) {
+        weston_log("weston_layout_forEachScreenUnderLayer: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(link_scrn, &ivilayer->list_screen, link) {
+        if (callback(link_scrn->iviscrn, userdata) != 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_getSurfacesInto(uint32_t capacity,
+                              weston_layout_surface_ptr *pArray,
+                              uint32_t *pLength)
+{
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_surface *ivisurf = NULL;
+    uint32_t n = 0;
+
+    if (pLength == NULL || (pArray == NULL && capacity != 0)) {
+        weston_log("weston_layout_getSurfacesInto: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(ivisurf, &layout->list_surface, link) {
+        if (n < capacity) {
+            pArray[n] = ivisurf;
+        }
+        n++;
+    }
+
+    *pLength = n;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_getLayersInto(uint32_t capacity,
+                            weston_layout_layer_ptr *pArray,
+                            uint32_t *pLength)
+{
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_layer *ivilayer = NULL;
+    uint32_t n = 0;
+
+    if (pLength == NULL || (pArray == NULL && capacity != 0)) {
+        weston_log("weston_layout_getLayersInto: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(ivilayer, &layout->list_layer, link) {
+        if (n < capacity) {
+            pArray[n] = ivilayer;
+        }
+        n++;
+    }
+
+    *pLength = n;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_getLayersOnScreenInto(struct weston_layout_screen *iviscrn,
+                                    uint32_t capacity,
+                                    weston_layout_layer_ptr *pArray,
+                                    uint32_t *pLength)
+{
+    struct weston_layout_layer *ivilayer = NULL;
+    uint32_t n = 0;
+
+    if (iviscrn == NULL || pLength == NULL ||
+        (pArray == NULL && capacity != 0)) {
+        weston_log("weston_layout_getLayersOnScreenInto: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(ivilayer, &iviscrn->order.list_layer, order.link) {
+        if (n < capacity) {
+            pArray[n] = ivilayer;
+        }
+        n++;
+    }
+
+    *pLength = n;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_getSurfacesOnLayerInto(struct weston_layout_layer *ivilayer,
+                                     uint32_t capacity,
+                                     weston_layout_surface_ptr *pArray,
+                                     uint32_t *pLength)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+    uint32_t n = 0;
+
+    if (ivilayer == NULL || pLength == NULL ||
+        (pArray == NULL && capacity != 0)) {
+        weston_log("weston_layout_getSurfacesOnLayerInto: invalid argument\n");
+        return -1;
+    }
+
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (n < capacity) {
+            pArray[n] = ivisurf;
+        }
+        n++;
+    }
+
+    *pLength = n;
 
     return 0;
 }
 
 WL_EXPORT int32_t
-weston_layout_getSurfacesOnLayer(struct weston_layout_layer *ivilayer,
-                                 uint32_t *pLength,
-                                 weston_layout_surface_ptr **ppArray)
+weston_layout_getScreensUnderLayerInto(struct weston_layout_layer *ivilayer,
+                                       uint32_t capacity,
+                                       weston_layout_screen_ptr *pArray,
+                                       uint32_t *pLength)
 {
-    struct weston_layout_surface *ivisurf = NULL;
-    uint32_t length = 0;
+    struct link_screen *link_scrn = NULL;
     uint32_t n = 0;
 
-    if (ivilayer == NULL || pLength == NULL || ppArray == NULL) {
-        weston_log("weston_layout_getSurfaceIDsOnLayer: invalid argument\n");
+    if (ivilayer == NULL || pLength == NULL ||
+        (pArray == NULL && capacity != 0)) {
+        weston_log("weston_layout_getScreensUnderLayerInto: invalid argument\n");
         return -1;
     }
 
-    length = wl_list_length(&ivilayer->order.list_surface);
-
-    if (length != 0) {
-        /* the Array must be free by module which called this function */
-        *ppArray = calloc(length, sizeof(weston_layout_surface_ptr));
-        if (*ppArray == NULL) {
-            weston_log("fails to allocate memory\n");
-            return -1;
-        }
-
-        wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
-            (*ppArray)[n++] = ivisurf;
+    wl_list_for_each(link_scrn, &ivilayer->list_screen, link) {
+        if (n < capacity) {
+            pArray[n] = link_scrn->iviscrn;
         }
+        n++;
     }
 
-    *pLength = length;
+    *pLength = n;
 
     return 0;
 }
@@ -1681,7 +4433,7 @@ weston_layout_layerCreateWithDimension(uint32_t id_layer,
     struct weston_layout_layer *ivilayer = NULL;
     struct link_layerCreateNotification *notification = NULL;
 
-    ivilayer = get_layer(&layout->list_layer, id_layer);
+    ivilayer = get_layer(layout, id_layer);
     if (ivilayer != NULL) {
         weston_log("id_layer is already created\n");
         return ivilayer;
@@ -1694,11 +4446,20 @@ weston_layout_layerCreateWithDimension(uint32_t id_layer,
     }
 
     wl_list_init(&ivilayer->link);
+    wl_list_init(&ivilayer->hash.link);
+    wl_list_init(&ivilayer->dirty_link);
     wl_list_init(&ivilayer->list_notification);
     wl_list_init(&ivilayer->list_screen);
     ivilayer->layout = layout;
     ivilayer->id_layer = id_layer;
 
+    if (id_hash_insert(&layout->hash_layer, &ivilayer->hash, id_layer) != 0) {
+        free(ivilayer);
+        return NULL;
+    }
+
+    record_args(WESTON_LAYOUT_RECORD_LAYER_CREATE, 3, id_layer, width, height);
+
     init_layerProperties(&ivilayer->prop, width, height);
     ivilayer->event_mask = 0;
 
@@ -1732,6 +4493,8 @@ weston_layout_layerRemove(struct weston_layout_layer *ivilayer)
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_REMOVE, 1, ivilayer->id_layer);
+
     wl_list_for_each(notification,
             &layout->layer_notification.list_remove, link) {
         if (notification->callback != NULL) {
@@ -1748,7 +4511,15 @@ weston_layout_layerRemove(struct weston_layout_layer *ivilayer)
     if (!wl_list_empty(&ivilayer->link)) {
         wl_list_remove(&ivilayer->link);
     }
+    id_hash_remove(&layout->hash_layer, &ivilayer->hash);
+    if (!wl_list_empty(&ivilayer->dirty_link)) {
+        wl_list_remove(&ivilayer->dirty_link);
+    }
+    destroy_layer_cache(ivilayer);
     remove_orderlayer_from_screen(ivilayer);
+    remove_layer_from_surfaces(ivilayer);
+    forget_change_entry(layout, NULL, ivilayer);
+    layout->dirty.view_list = 1;
 
     free(ivilayer);
 
@@ -1777,10 +4548,13 @@ weston_layout_layerSetVisibility(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_VISIBILITY, 2, ivilayer->id_layer,
+                newVisibility);
+
     prop = &ivilayer->pending.prop;
     prop->visibility = newVisibility;
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_VISIBILITY;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_VISIBILITY);
 
     return 0;
 }
@@ -1809,10 +4583,13 @@ weston_layout_layerSetOpacity(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_OPACITY, 2, ivilayer->id_layer,
+                record_float(opacity));
+
     prop = &ivilayer->pending.prop;
     prop->opacity = opacity;
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_OPACITY;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_OPACITY);
 
     return 0;
 }
@@ -1843,13 +4620,16 @@ weston_layout_layerSetSourceRectangle(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_SOURCE_RECT, 5, ivilayer->id_layer,
+                x, y, width, height);
+
     prop = &ivilayer->pending.prop;
     prop->sourceX = x;
     prop->sourceY = y;
     prop->sourceWidth = width;
     prop->sourceHeight = height;
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_SOURCE_RECT;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_SOURCE_RECT);
 
     return 0;
 }
@@ -1866,13 +4646,16 @@ weston_layout_layerSetDestinationRectangle(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_DEST_RECT, 5, ivilayer->id_layer,
+                x, y, width, height);
+
     prop = &ivilayer->pending.prop;
     prop->destX = x;
     prop->destY = y;
     prop->destWidth = width;
     prop->destHeight = height;
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_DEST_RECT;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_DEST_RECT);
 
     return 0;
 }
@@ -1903,12 +4686,15 @@ weston_layout_layerSetDimension(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_DIMENSION, 3, ivilayer->id_layer,
+                pDimension[0], pDimension[1]);
+
     prop = &ivilayer->pending.prop;
 
     prop->destWidth  = pDimension[0];
     prop->destHeight = pDimension[1];
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_DIMENSION;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_DIMENSION);
 
     return 0;
 }
@@ -1937,11 +4723,14 @@ weston_layout_layerSetPosition(struct weston_layout_layer *ivilayer, int32_t *pP
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_POSITION, 3, ivilayer->id_layer,
+                pPosition[0], pPosition[1]);
+
     prop = &ivilayer->pending.prop;
     prop->destX = pPosition[0];
     prop->destY = pPosition[1];
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_POSITION;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_POSITION);
 
     return 0;
 }
@@ -1957,10 +4746,13 @@ weston_layout_layerSetOrientation(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_ORIENTATION, 2, ivilayer->id_layer,
+                orientation);
+
     prop = &ivilayer->pending.prop;
     prop->orientation = orientation;
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_ORIENTATION;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_ORIENTATION);
 
     return 0;
 }
@@ -1982,9 +4774,32 @@ weston_layout_layerGetOrientation(struct weston_layout_layer *ivilayer,
 WL_EXPORT int32_t
 weston_layout_layerSetChromaKey(struct weston_layout_layer *ivilayer, uint32_t* pColor)
 {
-    /* not supported */
-    (void)ivilayer;
-    (void)pColor;
+    struct weston_layout_LayerProperties *prop = NULL;
+
+    if (ivilayer == NULL) {
+        weston_log("weston_layout_layerSetChromaKey: invalid argument\n");
+        return -1;
+    }
+
+    if (pColor == NULL) {
+        record_args(WESTON_LAYOUT_RECORD_LAYER_CHROMA_KEY, 5,
+                    ivilayer->id_layer, 0, 0, 0, 0);
+    } else {
+        record_args(WESTON_LAYOUT_RECORD_LAYER_CHROMA_KEY, 5,
+                    ivilayer->id_layer, 1, pColor[0], pColor[1], pColor[2]);
+    }
+
+    prop = &ivilayer->pending.prop;
+    if (pColor == NULL) {
+        prop->chromaKeyEnabled = 0;
+    } else {
+        prop->chromaKeyEnabled = 1;
+        prop->chromaKeyRed   = pColor[0] & 0xff;
+        prop->chromaKeyGreen = pColor[1] & 0xff;
+        prop->chromaKeyBlue  = pColor[2] & 0xff;
+    }
+
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_CHROMA_KEY);
 
     return 0;
 }
@@ -1997,7 +4812,6 @@ weston_layout_layerSetRenderOrder(struct weston_layout_layer *ivilayer,
     struct weston_layout *layout = get_instance();
     struct weston_layout_surface *ivisurf = NULL;
     struct weston_layout_surface *next = NULL;
-    uint32_t *id_surface = NULL;
     uint32_t i = 0;
 
     if (ivilayer == NULL) {
@@ -2005,6 +4819,8 @@ weston_layout_layerSetRenderOrder(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_surface_order(ivilayer, pSurface, number);
+
     wl_list_for_each_safe(ivisurf, next,
                           &ivilayer->pending.list_surface, pending.link) {
         wl_list_init(&ivisurf->pending.link);
@@ -2017,24 +4833,67 @@ weston_layout_layerSetRenderOrder(struct weston_layout_layer *ivilayer,
     }
 
     for (i = 0; i < number; i++) {
-        id_surface = &pSurface[i]->id_surface;
-
-        wl_list_for_each(ivisurf, &layout->list_surface, link) {
-            if (*id_surface != ivisurf->id_surface) {
-                continue;
-            }
+        ivisurf = get_surface(layout, pSurface[i]->id_surface);
+        if (ivisurf == NULL) {
+            continue;
+        }
 
-            if (!wl_list_empty(&ivisurf->pending.link)) {
-                wl_list_remove(&ivisurf->pending.link);
-            }
-            wl_list_init(&ivisurf->pending.link);
-            wl_list_insert(&ivilayer->pending.list_surface,
-                           &ivisurf->pending.link);
-            break;
+        if (!wl_list_empty(&ivisurf->pending.link)) {
+            wl_list_remove(&ivisurf->pending.link);
         }
+        wl_list_init(&ivisurf->pending.link);
+        wl_list_insert(&ivilayer->pending.list_surface,
+                       &ivisurf->pending.link);
+    }
+
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_ADD);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_layerSetRenderCache(struct weston_layout_layer *ivilayer,
+                                  int32_t enabled)
+{
+    if (ivilayer == NULL) {
+        weston_log("weston_layout_layerSetRenderCache: invalid argument\n");
+        return -1;
+    }
+
+    record_args(WESTON_LAYOUT_RECORD_LAYER_RENDER_CACHE, 2, ivilayer->id_layer,
+                enabled);
+
+    ivilayer->pending.cache_enabled = enabled ? 1 : 0;
+
+    mark_layer_dirty(ivilayer, 0);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_layerGetRenderCache(struct weston_layout_layer *ivilayer,
+                                  int32_t *pEnabled)
+{
+    if (ivilayer == NULL || pEnabled == NULL) {
+        weston_log("weston_layout_layerGetRenderCache: invalid argument\n");
+        return -1;
+    }
+
+    *pEnabled = ivilayer->cache.enabled;
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_layerGetRenderCacheStatistics(struct weston_layout_layer *ivilayer,
+                struct weston_layout_RenderCacheStatistics *pStatistics)
+{
+    if (ivilayer == NULL || pStatistics == NULL) {
+        weston_log("weston_layout_layerGetRenderCacheStatistics: invalid argument\n");
+        return -1;
     }
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_ADD;
+    *pStatistics = ivilayer->cache.stats;
 
     return 0;
 }
@@ -2072,10 +4931,13 @@ weston_layout_surfaceSetVisibility(struct weston_layout_surface *ivisurf,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_VISIBILITY, 2, ivisurf->id_surface,
+                newVisibility);
+
     prop = &ivisurf->pending.prop;
     prop->visibility = newVisibility;
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_VISIBILITY;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_VISIBILITY);
 
     return 0;
 }
@@ -2105,10 +4967,13 @@ weston_layout_surfaceSetOpacity(struct weston_layout_surface *ivisurf,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_OPACITY, 2, ivisurf->id_surface,
+                record_float(opacity));
+
     prop = &ivisurf->pending.prop;
     prop->opacity = opacity;
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_OPACITY;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_OPACITY);
 
     return 0;
 }
@@ -2157,13 +5022,16 @@ weston_layout_surfaceSetDestinationRectangle(struct weston_layout_surface *ivisu
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_DEST_RECT, 5, ivisurf->id_surface,
+                x, y, width, height);
+
     prop = &ivisurf->pending.prop;
     prop->destX = x;
     prop->destY = y;
     prop->destWidth = width;
     prop->destHeight = height;
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_DEST_RECT;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_DEST_RECT);
 
     return 0;
 }
@@ -2178,11 +5046,14 @@ weston_layout_surfaceSetDimension(struct weston_layout_surface *ivisurf, uint32_
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_DIMENSION, 3, ivisurf->id_surface,
+                pDimension[0], pDimension[1]);
+
     prop = &ivisurf->pending.prop;
     prop->destWidth  = pDimension[0];
     prop->destHeight = pDimension[1];
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_DIMENSION;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_DIMENSION);
 
     return 0;
 }
@@ -2213,11 +5084,14 @@ weston_layout_surfaceSetPosition(struct weston_layout_surface *ivisurf,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_POSITION, 3, ivisurf->id_surface,
+                pPosition[0], pPosition[1]);
+
     prop = &ivisurf->pending.prop;
     prop->destX = pPosition[0];
     prop->destY = pPosition[1];
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_POSITION;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_POSITION);
 
     return 0;
 }
@@ -2248,10 +5122,13 @@ weston_layout_surfaceSetOrientation(struct weston_layout_surface *ivisurf,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_ORIENTATION, 2, ivisurf->id_surface,
+                orientation);
+
     prop = &ivisurf->pending.prop;
     prop->orientation = orientation;
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_ORIENTATION;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_ORIENTATION);
 
     return 0;
 }
@@ -2283,9 +5160,32 @@ weston_layout_surfaceGetPixelformat(struct weston_layout_layer *ivisurf, uint32_
 WL_EXPORT int32_t
 weston_layout_surfaceSetChromaKey(struct weston_layout_surface *ivisurf, uint32_t* pColor)
 {
-    /* not supported */
-    (void)ivisurf;
-    (void)pColor;
+    struct weston_layout_SurfaceProperties *prop = NULL;
+
+    if (ivisurf == NULL) {
+        weston_log("weston_layout_surfaceSetChromaKey: invalid argument\n");
+        return -1;
+    }
+
+    if (pColor == NULL) {
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_CHROMA_KEY, 5,
+                    ivisurf->id_surface, 0, 0, 0, 0);
+    } else {
+        record_args(WESTON_LAYOUT_RECORD_SURFACE_CHROMA_KEY, 5,
+                    ivisurf->id_surface, 1, pColor[0], pColor[1], pColor[2]);
+    }
+
+    prop = &ivisurf->pending.prop;
+    if (pColor == NULL) {
+        prop->chromaKeyEnabled = 0;
+    } else {
+        prop->chromaKeyEnabled = 1;
+        prop->chromaKeyRed   = pColor[0] & 0xff;
+        prop->chromaKeyGreen = pColor[1] & 0xff;
+        prop->chromaKeyBlue  = pColor[2] & 0xff;
+    }
+
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_CHROMA_KEY);
 
     return 0;
 }
@@ -2296,7 +5196,6 @@ weston_layout_screenAddLayer(struct weston_layout_screen *iviscrn,
 {
     struct weston_layout *layout = get_instance();
     struct weston_layout_layer *ivilayer = NULL;
-    struct weston_layout_layer *next = NULL;
     int is_layer_in_scrn = 0;
 
     if (iviscrn == NULL || addlayer == NULL) {
@@ -2304,25 +5203,26 @@ weston_layout_screenAddLayer(struct weston_layout_screen *iviscrn,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SCREEN_ADD_LAYER, 2, iviscrn->id_screen,
+                addlayer->id_layer);
+
     is_layer_in_scrn = is_layer_in_screen(addlayer, iviscrn);
     if (is_layer_in_scrn == 1) {
         weston_log("weston_layout_screenAddLayer: addlayer is already available\n");
         return 0;
     }
 
-    wl_list_for_each_safe(ivilayer, next, &layout->list_layer, link) {
-        if (ivilayer->id_layer == addlayer->id_layer) {
-            if (!wl_list_empty(&ivilayer->pending.link)) {
-                wl_list_remove(&ivilayer->pending.link);
-            }
-            wl_list_init(&ivilayer->pending.link);
-            wl_list_insert(&iviscrn->pending.list_layer,
-                           &ivilayer->pending.link);
-            break;
+    ivilayer = get_layer(layout, addlayer->id_layer);
+    if (ivilayer != NULL) {
+        if (!wl_list_empty(&ivilayer->pending.link)) {
+            wl_list_remove(&ivilayer->pending.link);
         }
+        wl_list_init(&ivilayer->pending.link);
+        wl_list_insert(&iviscrn->pending.list_layer,
+                       &ivilayer->pending.link);
     }
 
-    iviscrn->event_mask |= IVI_NOTIFICATION_ADD;
+    mark_screen_dirty(iviscrn, IVI_NOTIFICATION_ADD);
 
     return 0;
 }
@@ -2335,7 +5235,6 @@ weston_layout_screenSetRenderOrder(struct weston_layout_screen *iviscrn,
     struct weston_layout *layout = get_instance();
     struct weston_layout_layer *ivilayer = NULL;
     struct weston_layout_layer *next = NULL;
-    uint32_t *id_layer = NULL;
     uint32_t i = 0;
 
     if (iviscrn == NULL) {
@@ -2343,6 +5242,8 @@ weston_layout_screenSetRenderOrder(struct weston_layout_screen *iviscrn,
         return -1;
     }
 
+    record_layer_order(iviscrn, pLayer, number);
+
     wl_list_for_each_safe(ivilayer, next,
                           &iviscrn->pending.list_layer, pending.link) {
         wl_list_init(&ivilayer->pending.link);
@@ -2355,23 +5256,20 @@ weston_layout_screenSetRenderOrder(struct weston_layout_screen *iviscrn,
     }
 
     for (i = 0; i < number; i++) {
-        id_layer = &pLayer[i]->id_layer;
-        wl_list_for_each(ivilayer, &layout->list_layer, link) {
-            if (*id_layer != ivilayer->id_layer) {
-                continue;
-            }
+        ivilayer = get_layer(layout, pLayer[i]->id_layer);
+        if (ivilayer == NULL) {
+            continue;
+        }
 
-            if (!wl_list_empty(&ivilayer->pending.link)) {
-                wl_list_remove(&ivilayer->pending.link);
-            }
-            wl_list_init(&ivilayer->pending.link);
-            wl_list_insert(&iviscrn->pending.list_layer,
-                           &ivilayer->pending.link);
-            break;
+        if (!wl_list_empty(&ivilayer->pending.link)) {
+            wl_list_remove(&ivilayer->pending.link);
         }
+        wl_list_init(&ivilayer->pending.link);
+        wl_list_insert(&iviscrn->pending.list_layer,
+                       &ivilayer->pending.link);
     }
 
-    iviscrn->event_mask |= IVI_NOTIFICATION_ADD;
+    mark_screen_dirty(iviscrn, IVI_NOTIFICATION_ADD);
 
     return 0;
 }
@@ -2380,99 +5278,222 @@ WL_EXPORT int32_t
 weston_layout_takeScreenshot(struct weston_layout_screen *iviscrn,
                           const char *filename)
 {
-    struct weston_output *output = NULL;
-    cairo_surface_t *cairo_surf = NULL;
-    int32_t i = 0;
-    int32_t width  = 0;
-    int32_t height = 0;
-    int32_t stride = 0;
-    uint8_t *readpixs = NULL;
-    uint8_t *writepixs = NULL;
-    uint8_t *d = NULL;
-    uint8_t *s = NULL;
+    return weston_layout_takeScreenshotAsync(iviscrn, filename, NULL, NULL);
+}
+
+WL_EXPORT int32_t
+weston_layout_takeScreenshotAsync(struct weston_layout_screen *iviscrn,
+                                  const char *filename,
+                                  screenshotDoneFunc callback,
+                                  void *userdata)
+{
+    struct weston_layout *layout = get_instance();
+    struct screenshot_job *job = NULL;
 
     if (iviscrn == NULL || filename == NULL) {
         weston_log("weston_layout_takeScreenshot: invalid argument\n");
         return -1;
     }
 
-    output = iviscrn->output;
-    output->disable_planes--;
+    if (screenshot_start_worker(layout) != 0) {
+        return -1;
+    }
 
-    width = output->current_mode->width;
-    height = output->current_mode->height;
-    stride = width * (PIXMAN_FORMAT_BPP(output->compositor->read_format) / 8);
+    job = calloc(1, sizeof *job);
+    if (job == NULL) {
+        weston_log("fails to allocate memory\n");
+        return -1;
+    }
 
-    readpixs = malloc(stride * height);
-    if (readpixs == NULL) {
+    job->filename = strdup(filename);
+    if (job->filename == NULL) {
         weston_log("fails to allocate memory\n");
+        free(job);
+        return -1;
+    }
+
+    job->iviscrn  = iviscrn;
+    job->callback = callback;
+    job->userdata = userdata;
+    wl_list_init(&job->link);
+    wl_list_insert(&layout->screenshot.list_job, &job->job_link);
+
+    /* Read back at next frame composited without planes */
+    job->frame_listener.notify = screenshot_frame_notify;
+    wl_signal_add(&iviscrn->output->frame_signal, &job->frame_listener);
+    job->reading = 1;
+    iviscrn->output->disable_planes++;
+    weston_output_schedule_repaint(iviscrn->output);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_takeLayerScreenshot(const char *filename, struct weston_layout_layer *ivilayer)
+{
+    struct weston_layout_surface *ivisurf = NULL;
+    pixman_image_t *image = NULL;
+    pixman_image_t *surf_image = NULL;
+    int32_t width  = 0;
+    int32_t height = 0;
+    int32_t ret = 0;
+
+    if (filename == NULL || ivilayer == NULL) {
+        weston_log("weston_layout_takeLayerScreenshot: invalid argument\n");
+        return -1;
+    }
+
+    width  = ivilayer->prop.sourceWidth;
+    height = ivilayer->prop.sourceHeight;
+    if (width == 0 || height == 0) {
+        weston_log("weston_layout_takeLayerScreenshot: layer has no size\n");
         return -1;
     }
-    writepixs = malloc(stride * height);
-    if (writepixs == NULL) {
+
+    /* cleared to transparent */
+    image = pixman_image_create_bits(PIXMAN_a8r8g8b8, width, height, NULL, 0);
+    if (image == NULL) {
         weston_log("fails to allocate memory\n");
         return -1;
     }
 
-    output->compositor->renderer->read_pixels(output,
-                             output->compositor->read_format, readpixs,
-                             0, 0, width, height);
+    /* from bottom to top */
+    wl_list_for_each(ivisurf, &ivilayer->order.list_surface, order.link) {
+        if (ivisurf->prop.visibility == 0) {
+            continue;
+        }
 
-    s = readpixs;
-    d = writepixs + stride * (height - 1);
+        surf_image = read_surface_image(ivisurf);
+        if (surf_image == NULL) {
+            continue;
+        }
 
-    for (i = 0; i < height; i++) {
-        memcpy(d, s, stride);
-        d -= stride;
-        s += stride;
+        draw_surface_image(image, surf_image, ivilayer, ivisurf);
+        pixman_image_unref(surf_image);
     }
 
-    cairo_surf = cairo_image_surface_create_for_data(writepixs,
-                                                  CAIRO_FORMAT_ARGB32,
-                                                  width, height, stride);
-    cairo_surface_write_to_png(cairo_surf, filename);
-    cairo_surface_destroy(cairo_surf);
-    free(writepixs);
-    free(readpixs);
+    ret = write_png(filename, image);
+    pixman_image_unref(image);
+
+    return ret;
+}
+
+WL_EXPORT int32_t
+weston_layout_takeSurfaceScreenshot(const char *filename,
+                                 struct weston_layout_surface *ivisurf)
+{
+    pixman_image_t *image = NULL;
+    pixman_image_t *mask = NULL;
+    int32_t ret = 0;
+
+    if (filename == NULL || ivisurf == NULL) {
+        weston_log("weston_layout_takeSurfaceScreenshot: invalid argument\n");
+        return -1;
+    }
+
+    image = read_surface_image(ivisurf);
+    if (image == NULL) {
+        weston_log("weston_layout_takeSurfaceScreenshot: "
+                   "fails to read surface\n");
+        return -1;
+    }
+
+    /* premultiplied pixels are scaled by opacity of the surface */
+    mask = create_opacity_mask(NULL, ivisurf);
+    if (mask != NULL) {
+        pixman_image_composite32(PIXMAN_OP_IN, mask, NULL, image,
+                                 0, 0, 0, 0, 0, 0,
+                                 pixman_image_get_width(image),
+                                 pixman_image_get_height(image));
+        pixman_image_unref(mask);
+    }
+
+    ret = write_png(filename, image);
+    pixman_image_unref(image);
+
+    return ret;
+}
+
+WL_EXPORT int32_t
+weston_layout_SetOptimizationMode(uint32_t id, uint32_t mode)
+{
+    struct weston_layout *layout = get_instance();
+    struct weston_layout_screen *iviscrn = NULL;
+
+    if (!is_valid_optimization(id, mode)) {
+        weston_log("weston_layout_SetOptimizationMode: invalid argument\n");
+        return -1;
+    }
+
+    record_args(WESTON_LAYOUT_RECORD_OPTIMIZATION, 2, id, mode);
+
+    layout->optimization_mode[id] = mode;
+
+    wl_list_for_each(iviscrn, &layout->list_screen, link) {
+        iviscrn->pending.optimization_mode[id] = mode;
+        mark_screen_dirty(iviscrn, 0);
+    }
 
     return 0;
 }
 
 WL_EXPORT int32_t
-weston_layout_takeLayerScreenshot(const char *filename, struct weston_layout_layer *ivilayer)
+weston_layout_GetOptimizationMode(uint32_t id, uint32_t *pMode)
 {
-    /* not supported */
-    (void)filename;
-    (void)ivilayer;
+    struct weston_layout *layout = get_instance();
+
+    if (id >= IVI_OPTIMIZATION_COUNT || pMode == NULL) {
+        weston_log("weston_layout_GetOptimizationMode: invalid argument\n");
+        return -1;
+    }
+
+    *pMode = layout->optimization_mode[id];
 
     return 0;
 }
 
 WL_EXPORT int32_t
-weston_layout_takeSurfaceScreenshot(const char *filename,
-                                 struct weston_layout_surface *ivisurf)
+weston_layout_screenSetOptimizationMode(struct weston_layout_screen *iviscrn,
+                                        uint32_t id, uint32_t mode)
 {
-    weston_log("weston_layout_takeSurfaceScreenshot: "
-               "This function is not supported now\n");
+    if (iviscrn == NULL || !is_valid_optimization(id, mode)) {
+        weston_log("weston_layout_screenSetOptimizationMode: invalid argument\n");
+        return -1;
+    }
+
+    record_args(WESTON_LAYOUT_RECORD_SCREEN_OPTIMIZATION, 3, iviscrn->id_screen,
+                id, mode);
+
+    iviscrn->pending.optimization_mode[id] = mode;
+    mark_screen_dirty(iviscrn, 0);
+
     return 0;
 }
 
 WL_EXPORT int32_t
-weston_layout_SetOptimizationMode(uint32_t id, uint32_t mode)
+weston_layout_screenGetOptimizationMode(struct weston_layout_screen *iviscrn,
+                                        uint32_t id, uint32_t *pMode)
 {
-    /* not supported */
-    (void)id;
-    (void)mode;
+    if (iviscrn == NULL || id >= IVI_OPTIMIZATION_COUNT || pMode == NULL) {
+        weston_log("weston_layout_screenGetOptimizationMode: invalid argument\n");
+        return -1;
+    }
+
+    *pMode = iviscrn->optimization_mode[id];
 
     return 0;
 }
 
 WL_EXPORT int32_t
-weston_layout_GetOptimizationMode(uint32_t id, uint32_t *pMode)
+weston_layout_screenGetOptimizationState(struct weston_layout_screen *iviscrn,
+                                         uint32_t *pState)
 {
-    /* not supported */
-    (void)id;
-    (void)pMode;
+    if (iviscrn == NULL || pState == NULL) {
+        weston_log("weston_layout_screenGetOptimizationState: invalid argument\n");
+        return -1;
+    }
+
+    *pState = iviscrn->optimization_state;
 
     return 0;
 }
@@ -2546,7 +5567,6 @@ weston_layout_layerAddSurface(struct weston_layout_layer *ivilayer,
 {
     struct weston_layout *layout = get_instance();
     struct weston_layout_surface *ivisurf = NULL;
-    struct weston_layout_surface *next = NULL;
     int is_surf_in_layer = 0;
 
     if (ivilayer == NULL || addsurf == NULL) {
@@ -2554,25 +5574,26 @@ weston_layout_layerAddSurface(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_ADD_SURFACE, 2, ivilayer->id_layer,
+                addsurf->id_surface);
+
     is_surf_in_layer = is_surface_in_layer(addsurf, ivilayer);
     if (is_surf_in_layer == 1) {
         weston_log("weston_layout_layerAddSurface: addsurf is already available\n");
         return 0;
     }
 
-    wl_list_for_each_safe(ivisurf, next, &layout->list_surface, link) {
-        if (ivisurf->id_surface == addsurf->id_surface) {
-            if (!wl_list_empty(&ivisurf->pending.link)) {
-                wl_list_remove(&ivisurf->pending.link);
-            }
-            wl_list_init(&ivisurf->pending.link);
-            wl_list_insert(&ivilayer->pending.list_surface,
-                           &ivisurf->pending.link);
-            break;
+    ivisurf = get_surface(layout, addsurf->id_surface);
+    if (ivisurf != NULL) {
+        if (!wl_list_empty(&ivisurf->pending.link)) {
+            wl_list_remove(&ivisurf->pending.link);
         }
+        wl_list_init(&ivisurf->pending.link);
+        wl_list_insert(&ivilayer->pending.list_surface,
+                       &ivisurf->pending.link);
     }
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_ADD;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_ADD);
 
     return 0;
 }
@@ -2589,6 +5610,9 @@ weston_layout_layerRemoveSurface(struct weston_layout_layer *ivilayer,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_LAYER_REMOVE_SURFACE, 2, ivilayer->id_layer,
+                remsurf->id_surface);
+
     wl_list_for_each_safe(ivisurf, next,
                           &ivilayer->pending.list_surface, pending.link) {
         if (ivisurf->id_surface == remsurf->id_surface) {
@@ -2600,7 +5624,7 @@ weston_layout_layerRemoveSurface(struct weston_layout_layer *ivilayer,
         }
     }
 
-    ivilayer->event_mask |= IVI_NOTIFICATION_REMOVE;
+    mark_layer_dirty(ivilayer, IVI_NOTIFICATION_REMOVE);
 
     return 0;
 }
@@ -2617,13 +5641,32 @@ weston_layout_surfaceSetSourceRectangle(struct weston_layout_surface *ivisurf,
         return -1;
     }
 
+    record_args(WESTON_LAYOUT_RECORD_SURFACE_SOURCE_RECT, 5, ivisurf->id_surface,
+                x, y, width, height);
+
     prop = &ivisurf->pending.prop;
     prop->sourceX = x;
     prop->sourceY = y;
     prop->sourceWidth = width;
     prop->sourceHeight = height;
 
-    ivisurf->event_mask |= IVI_NOTIFICATION_SOURCE_RECT;
+    mark_surface_dirty(ivisurf, IVI_NOTIFICATION_SOURCE_RECT);
+
+    return 0;
+}
+
+WL_EXPORT int32_t
+weston_layout_getCommitStatistics(
+                    struct weston_layout_CommitStatistics *pStatistics)
+{
+    struct weston_layout *layout = get_instance();
+
+    if (pStatistics == NULL) {
+        weston_log("weston_layout_getCommitStatistics: invalid argument\n");
+        return -1;
+    }
+
+    *pStatistics = layout->commit_stats;
 
     return 0;
 }
@@ -2632,12 +5675,35 @@ WL_EXPORT int32_t
 weston_layout_commitChanges(void)
 {
     struct weston_layout *layout = get_instance();
+    struct weston_layout_CommitStatistics *stats = &layout->commit_stats;
+    int rearrange = 0;
+
+    record_call(WESTON_LAYOUT_RECORD_COMMIT, NULL, 0);
+
+    stats->commitCount++;
+    stats->surfaceCount = 0;
+    stats->layerCount   = 0;
+    stats->screenCount  = 0;
+    stats->updateCount  = 0;
+    stats->culledCount  = 0;
+
+    rearrange = layout->dirty.view_list || layout->dirty.cull;
+
+    invalidate_dirty_layer_caches(layout);
 
     commit_list_surface(layout);
     commit_list_layer(layout);
     commit_list_screen(layout);
 
     commit_changes(layout);
+
+    /* Transform of views is needed to know whether they are hidden */
+    if (rearrange) {
+        stats->culledCount = arrange_view_list(layout);
+        layout->dirty.view_list = 0;
+        layout->dirty.cull = 0;
+    }
+
     send_prop(layout);
     weston_compositor_schedule_repaint(layout->compositor);
 
@@ -102,6 +102,35 @@ struct weston_layout_LayerProperties
     int32_t  creatorPid;
 };
 
+/**
+ * Number of objects touched by the last weston_layout_commitChanges.
+ * Only surfaces/layers/screens which have pending changes are applied and
+ * notified, and updateCount is the number of surfaces whose view was
+ * updated as a result. culledCount is the number of views left out of the
+ * view list because they are hidden by opaque views above them.
+ */
+struct weston_layout_CommitStatistics
+{
+    uint32_t commitCount;
+    uint32_t surfaceCount;
+    uint32_t layerCount;
+    uint32_t screenCount;
+    uint32_t updateCount;
+    uint32_t culledCount;
+};
+
+/**
+ * Repaints of the screen where a layer with render cache was drawn from
+ * the cached image (hit) or from its surfaces (miss), and the number of
+ * times the cached image was built.
+ */
+struct weston_layout_RenderCacheStatistics
+{
+    uint32_t hitCount;
+    uint32_t missCount;
+    uint32_t buildCount;
+};
+
 struct weston_layout_layer;
 struct weston_layout_surface;
 struct weston_layout_screen;
@@ -122,9 +151,38 @@ enum weston_layout_notification_mask {
     IVI_NOTIFICATION_PIXELFORMAT = IVI_BIT(8),
     IVI_NOTIFICATION_ADD         = IVI_BIT(9),
     IVI_NOTIFICATION_REMOVE      = IVI_BIT(10),
+    IVI_NOTIFICATION_CHROMA_KEY  = IVI_BIT(11),
     IVI_NOTIFICATION_ALL         = 0xFFFF
 };
 
+/**
+ * Composition strategies of a screen.
+ * - IVI_OPTIMIZATION_BYPASS_COMPOSITION: when the top most surface covers
+ *   whole output of the screen, surfaces below it are not composited. Then
+ *   single fullscreen surface can be scanned out by backend directly.
+ * - IVI_OPTIMIZATION_FORCE_PRIMARY_PLANE: all surfaces of the screen are
+ *   composited to primary plane, backend doesn't assign other planes.
+ */
+enum weston_layout_optimization {
+    IVI_OPTIMIZATION_BYPASS_COMPOSITION  = 0,
+    IVI_OPTIMIZATION_FORCE_PRIMARY_PLANE = 1,
+    IVI_OPTIMIZATION_COUNT
+};
+
+/**
+ * - IVI_OPTIMIZATION_MODE_FORCE_OFF: the strategy is never used.
+ * - IVI_OPTIMIZATION_MODE_FORCE_ON: the strategy is always used. For
+ *   BYPASS_COMPOSITION, the top most surface is regarded as opaque.
+ * - IVI_OPTIMIZATION_MODE_HEURISTIC: the strategy is used only when it is
+ *   safe. For BYPASS_COMPOSITION, the top most surface must be opaque and
+ *   its opacity must be 1.0. Not supported for FORCE_PRIMARY_PLANE.
+ */
+enum weston_layout_optimization_mode {
+    IVI_OPTIMIZATION_MODE_FORCE_OFF = 0,
+    IVI_OPTIMIZATION_MODE_FORCE_ON  = 1,
+    IVI_OPTIMIZATION_MODE_HEURISTIC = 2
+};
+
 typedef void(*layerPropertyNotificationFunc)(struct weston_layout_layer *ivilayer,
                                             struct weston_layout_LayerProperties*,
                                             enum weston_layout_notification_mask mask,
@@ -150,6 +208,42 @@ typedef void(*surfaceRemoveNotificationFunc)(struct weston_layout_surface *ivisu
 typedef void(*surfaceConfigureNotificationFunc)(struct weston_layout_surface *ivisurf,
                                             void *userdata);
 
+typedef void(*surfaceVisibilityNotificationFunc)(struct weston_layout_surface *ivisurf,
+                                            int32_t visible,
+                                            void *userdata);
+
+/**
+ * An object changed by weston_layout_commitChanges. One of ivisurf or
+ * ivilayer is set, and mask is enum weston_layout_notification_mask.
+ */
+struct weston_layout_ChangeEntry
+{
+    struct weston_layout_surface *ivisurf;
+    struct weston_layout_layer   *ivilayer;
+    uint32_t mask;
+};
+
+typedef void(*commitNotificationFunc)(const struct weston_layout_ChangeEntry *pEntry,
+                                      uint32_t length,
+                                      void *userdata);
+
+typedef void(*screenshotDoneFunc)(struct weston_layout_screen *iviscrn,
+                                  const char *filename, int32_t result,
+                                  void *userdata);
+
+/**
+ * Callbacks of weston_layout_forEach* APIs. Return 0 to continue the
+ * enumeration, or non-zero to stop it.
+ */
+typedef int32_t(*surfaceEnumerateFunc)(struct weston_layout_surface *ivisurf,
+                                       void *userdata);
+
+typedef int32_t(*layerEnumerateFunc)(struct weston_layout_layer *ivilayer,
+                                     void *userdata);
+
+typedef int32_t(*screenEnumerateFunc)(struct weston_layout_screen *iviscrn,
+                                      void *userdata);
+
 /**
  * \brief to be called by ivi-shell in order to set initail view of
  * weston_surface.
@@ -163,6 +257,30 @@ weston_layout_get_weston_view(struct weston_layout_surface *surface);
 void
 weston_layout_initWithCompositor(struct weston_compositor *ec);
 
+/**
+ * \brief start recording calls of APIs which change layout to a file
+ * Every call which changes surfaces, layers, screens or optimization
+ * modes, and every commit, is written with its arguments and a timestamp
+ * in the format of weston-layout-record.h. Objects which already exist are
+ * recorded first as if they were created at the time. Recording is also
+ * started by initialization if weston.ini has layout-record=<file> in
+ * [ivi-shell] section.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_startRecording(const char *filename);
+
+/**
+ * \brief stop recording started by weston_layout_startRecording
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_stopRecording(void);
+
 /**
  * \brief register for notification when layer is created
  */
@@ -177,6 +295,35 @@ int32_t
 weston_layout_setNotificationRemoveLayer(layerRemoveNotificationFunc callback,
                                            void *userdata);
 
+/**
+ * \brief register for notification of changes applied by
+ * weston_layout_commitChanges
+ * Once per commit, callback is called with one array of objects whose
+ * changes intersect with mask. mask of each entry is also masked, and
+ * callback is not called if no object matches.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_setNotificationCommit(uint32_t mask,
+                                    commitNotificationFunc callback,
+                                    void *userdata);
+
+/**
+ * \brief unregister notification set by weston_layout_setNotificationCommit
+ *
+ * It may be called from a commit callback, also for other callbacks than
+ * the calling one. A callback unregistered during delivery is not called
+ * any more, and is freed when delivery is done.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_removeNotificationCommit(commitNotificationFunc callback,
+                                       void *userdata);
+
 /**
  * \brief register for notification when surface is created
  */
@@ -198,6 +345,32 @@ int32_t
 weston_layout_setNotificationConfigureSurface(surfaceConfigureNotificationFunc callback,
                                            void *userdata);
 
+/**
+ * \brief register for notification when surface becomes visible or
+ * invisible on screen
+ * A surface is visible on screen when the surface and a layer containing
+ * it are visible, the layer is on a screen, and the surface is not hidden
+ * by opaque surfaces above it. It is derived from the committed state and
+ * notified only when it changes.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_setNotificationSurfaceVisibility(surfaceVisibilityNotificationFunc callback,
+                                               void *userdata);
+
+/**
+ * \brief get whether surface is visible on screen, as notified by
+ * weston_layout_setNotificationSurfaceVisibility
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_surfaceGetVisibleOnScreen(struct weston_layout_surface *ivisurf,
+                                        int32_t *pVisible);
+
 /**
  * \brief get id of surface from weston_layout_surface
  *
@@ -427,6 +600,140 @@ weston_layout_getSurfacesOnLayer(struct weston_layout_layer *ivilayer,
                                  uint32_t *pLength,
                                  weston_layout_surface_ptr **ppArray);
 
+/**
+ * \brief Call the callback for each surface managed by the services
+ *
+ * No memory is allocated. The callback must not create or remove surfaces.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_forEachSurface(surfaceEnumerateFunc callback, void *userdata);
+
+/**
+ * \brief Call the callback for each layer managed by the services
+ *
+ * No memory is allocated. The callback must not create or remove layers.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_forEachLayer(layerEnumerateFunc callback, void *userdata);
+
+/**
+ * \brief Call the callback for each layer of the given screen, bottom first
+ *
+ * No memory is allocated. The callback must not change the render order
+ * of the screen.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_forEachLayerOnScreen(struct weston_layout_screen *iviscrn,
+                                   layerEnumerateFunc callback,
+                                   void *userdata);
+
+/**
+ * \brief Call the callback for each surface of the given layer, bottom first
+ *
+ * No memory is allocated. The callback must not change the render order
+ * of the layer.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_forEachSurfaceOnLayer(struct weston_layout_layer *ivilayer,
+                                    surfaceEnumerateFunc callback,
+                                    void *userdata);
+
+/**
+ * \brief Call the callback for each screen the given layer is added to
+ *
+ * No memory is allocated.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_forEachScreenUnderLayer(struct weston_layout_layer *ivilayer,
+                                      screenEnumerateFunc callback,
+                                      void *userdata);
+
+/**
+ * \brief Fill a caller-provided array with the surfaces managed by the services
+ *
+ * At most capacity entries are written to pArray, which may be NULL when
+ * capacity is 0. pLength is always set to the total number of surfaces, so
+ * that the caller can grow its array and call again when it is larger
+ * than capacity.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_getSurfacesInto(uint32_t capacity,
+                              weston_layout_surface_ptr *pArray,
+                              uint32_t *pLength);
+
+/**
+ * \brief Fill a caller-provided array with the layers managed by the services
+ *
+ * Same contract as weston_layout_getSurfacesInto.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_getLayersInto(uint32_t capacity,
+                            weston_layout_layer_ptr *pArray,
+                            uint32_t *pLength);
+
+/**
+ * \brief Fill a caller-provided array with the layers of the given screen
+ *
+ * Same contract as weston_layout_getSurfacesInto.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_getLayersOnScreenInto(struct weston_layout_screen *iviscrn,
+                                    uint32_t capacity,
+                                    weston_layout_layer_ptr *pArray,
+                                    uint32_t *pLength);
+
+/**
+ * \brief Fill a caller-provided array with the surfaces of the given layer
+ *
+ * Same contract as weston_layout_getSurfacesInto.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_getSurfacesOnLayerInto(struct weston_layout_layer *ivilayer,
+                                     uint32_t capacity,
+                                     weston_layout_surface_ptr *pArray,
+                                     uint32_t *pLength);
+
+/**
+ * \brief Fill a caller-provided array with the screens under the given layer
+ *
+ * Same contract as weston_layout_getSurfacesInto.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_getScreensUnderLayerInto(struct weston_layout_layer *ivilayer,
+                                       uint32_t capacity,
+                                       weston_layout_screen_ptr *pArray,
+                                       uint32_t *pLength);
+
 /**
  * \brief Create a layer which should be managed by the service
  *
@@ -582,6 +889,9 @@ weston_layout_layerGetOrientation(struct weston_layout_layer *ivilayer,
 
 /**
  * \brief Sets the color value which defines the transparency value.
+ * pColor is an array of red, green and blue in 0-255. Pixels of the color
+ * in surfaces of the layer are not drawn. NULL disables chroma key.
+ * A chroma key of a surface takes precedence over the one of its layer.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -601,6 +911,42 @@ weston_layout_layerSetRenderOrder(struct weston_layout_layer *ivilayer,
                                   struct weston_layout_surface **pSurface,
                                   uint32_t number);
 
+/**
+ * \brief Enable or disable render cache of the layer.
+ * Once surfaces of the layer are unchanged for some repaints, they are
+ * composited into one image which is drawn in place of them. The image is
+ * invalidated when a surface of the layer commits, or when properties of
+ * the layer or its surfaces change. Surfaces on hardware planes, with
+ * chroma key, or shared with other layers are not cached. Surfaces still
+ * receive input and frame events. Requires renderer support.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_layerSetRenderCache(struct weston_layout_layer *ivilayer,
+                                  int32_t enabled);
+
+/**
+ * \brief Get whether render cache of the layer is enabled.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_layerGetRenderCache(struct weston_layout_layer *ivilayer,
+                                  int32_t *pEnabled);
+
+/**
+ * \brief Get hit and miss counts of render cache of the layer.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_layerGetRenderCacheStatistics(struct weston_layout_layer *ivilayer,
+                struct weston_layout_RenderCacheStatistics *pStatistics);
+
 /**
  * \brief Get the capabilities of a layer
  *
@@ -777,6 +1123,8 @@ weston_layout_surfaceGetPixelformat(struct weston_layout_layer *ivisurf,
 
 /**
  * \brief Sets the color value which defines the transparency value of a surface.
+ * pColor is an array of red, green and blue in 0-255. Pixels of the color
+ * in the surface are not drawn. NULL disables chroma key.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -808,7 +1156,8 @@ weston_layout_screenSetRenderOrder(struct weston_layout_screen *iviscrn,
 
 /**
  * \brief Take a screenshot from the current displayed layer scene.
- * The screenshot is saved as bmp file with the corresponding filename.
+ * The screenshot is saved as png file with the corresponding filename.
+ * The file is written asynchronously after next frame of the screen.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -817,9 +1166,30 @@ int32_t
 weston_layout_takeScreenshot(struct weston_layout_screen *iviscrn,
                              const char *filename);
 
+/**
+ * \brief Take a screenshot like weston_layout_takeScreenshot, and call
+ * callback on compositor thread when the file is written. result of
+ * callback is 0 on success, and -1 on failure. If the screen is destroyed
+ * before its frame is read back, the screenshot fails. If it is destroyed
+ * while the file is being written, iviscrn of callback is NULL.
+ * Screenshots not reported at destruction of compositor are dropped.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_takeScreenshotAsync(struct weston_layout_screen *iviscrn,
+                                  const char *filename,
+                                  screenshotDoneFunc callback,
+                                  void *userdata);
+
 /**
  * \brief Take a screenshot of a certain layer
- * The screenshot is saved as bmp file with the corresponding filename.
+ * Surfaces of the layer are rendered offscreen into an image of the
+ * source rectangle of the layer, even if the layer is invisible or covered
+ * by other layers. Orientation of surfaces is not applied. Opacity of each
+ * surface is multiplied by the one of the layer, as on screen.
+ * The screenshot is saved as png file with the corresponding filename.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -830,7 +1200,10 @@ weston_layout_takeLayerScreenshot(const char *filename,
 
 /**
  * \brief Take a screenshot of a certain surface
- * The screenshot is saved as bmp file with the corresponding filename.
+ * The buffer of the surface is saved in its own size, even if the surface
+ * is invisible or covered by other surfaces. Opacity of the surface is
+ * applied, but not the one of its layers.
+ * The screenshot is saved as png file with the corresponding filename.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -840,7 +1213,9 @@ weston_layout_takeSurfaceScreenshot(const char *filename,
                                     struct weston_layout_surface *ivisurf);
 
 /**
- * \brief Enable or disable a rendering optimization
+ * \brief Enable or disable a rendering optimization on all screens
+ * id is enum weston_layout_optimization and mode is
+ * enum weston_layout_optimization_mode.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -849,7 +1224,8 @@ int32_t
 weston_layout_SetOptimizationMode(uint32_t id, uint32_t mode);
 
 /**
- * \brief Get the current enablement for an optimization
+ * \brief Get the current enablement for an optimization, which is set by
+ * weston_layout_SetOptimizationMode
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -857,6 +1233,37 @@ weston_layout_SetOptimizationMode(uint32_t id, uint32_t mode);
 int32_t
 weston_layout_GetOptimizationMode(uint32_t id, uint32_t *pMode);
 
+/**
+ * \brief Enable or disable a rendering optimization on a screen
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_screenSetOptimizationMode(struct weston_layout_screen *iviscrn,
+                                        uint32_t id, uint32_t mode);
+
+/**
+ * \brief Get the current enablement for an optimization on a screen
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_screenGetOptimizationMode(struct weston_layout_screen *iviscrn,
+                                        uint32_t id, uint32_t *pMode);
+
+/**
+ * \brief Get optimizations in effect on a screen by the last commit
+ * pState is set to IVI_BIT(enum weston_layout_optimization) of them.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_screenGetOptimizationState(struct weston_layout_screen *iviscrn,
+                                         uint32_t *pState);
+
 /**
  * \brief register for notification on property changes of layer
  *
@@ -909,6 +1316,8 @@ weston_layout_layerRemoveSurface(struct weston_layout_layer *ivilayer,
 
 /**
  * \brief Set the area of a surface which should be used for the rendering.
+ *        Only this part will be visible, and scaled to the destination
+ *        rectangle.
  *
  * \return  0 if the method call was successful
  * \return -1 if the client can not call the method on the service.
@@ -927,6 +1336,16 @@ weston_layout_surfaceSetSourceRectangle(struct weston_layout_surface *ivisurf,
 int32_t
 weston_layout_commitChanges(void);
 
+/**
+ * \brief Get the number of objects touched by the last commit.
+ *
+ * \return  0 if the method call was successful
+ * \return -1 if the client can not call the method on the service.
+ */
+int32_t
+weston_layout_getCommitStatistics(
+                struct weston_layout_CommitStatistics *pStatistics);
+
 #ifdef __cplusplus
 } /**/
 #endif /* __cplusplus */
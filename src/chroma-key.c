@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "chroma-key.h"
+
+#define CHROMA_KEY_RGB_MASK 0x00ffffff
+
+static void
+chroma_key_mask_row(uint8_t *mask, const uint32_t *pixels,
+		    int width, uint32_t key)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	const __m128i rgb = _mm_set1_epi32(CHROMA_KEY_RGB_MASK);
+	const __m128i k = _mm_set1_epi32(key);
+	const __m128i ones = _mm_set1_epi8(-1);
+	__m128i a, b, c, d;
+
+	/* 16 pixels per iteration: compare as 32 bit lanes, then narrow
+	 * the all-ones/all-zeros results to bytes with saturating packs. */
+	for (; i + 16 <= width; i += 16) {
+		a = _mm_loadu_si128((const __m128i *) (pixels + i));
+		b = _mm_loadu_si128((const __m128i *) (pixels + i + 4));
+		c = _mm_loadu_si128((const __m128i *) (pixels + i + 8));
+		d = _mm_loadu_si128((const __m128i *) (pixels + i + 12));
+
+		a = _mm_cmpeq_epi32(_mm_and_si128(a, rgb), k);
+		b = _mm_cmpeq_epi32(_mm_and_si128(b, rgb), k);
+		c = _mm_cmpeq_epi32(_mm_and_si128(c, rgb), k);
+		d = _mm_cmpeq_epi32(_mm_and_si128(d, rgb), k);
+
+		a = _mm_packs_epi16(_mm_packs_epi32(a, b),
+				    _mm_packs_epi32(c, d));
+
+		_mm_storeu_si128((__m128i *) (mask + i),
+				 _mm_xor_si128(a, ones));
+	}
+#endif
+
+	for (; i < width; i++)
+		mask[i] = (pixels[i] & CHROMA_KEY_RGB_MASK) == key ? 0x00 : 0xff;
+}
+
+void
+chroma_key_mask(uint8_t *mask, int mask_stride,
+		const uint32_t *pixels, int stride,
+		int width, int height, uint32_t key)
+{
+	int y;
+
+	key &= CHROMA_KEY_RGB_MASK;
+
+	for (y = 0; y < height; y++) {
+		chroma_key_mask_row(mask, pixels, width, key);
+		mask += mask_stride;
+		pixels = (const uint32_t *) ((const uint8_t *) pixels + stride);
+	}
+}
@@ -28,34 +28,63 @@
 #include <sys/time.h>
 
 #include "compositor.h"
+#include "pixman-renderer.h"
 
 struct headless_compositor {
 	struct weston_compositor base;
 	struct weston_seat fake_seat;
+	int use_pixman;
 };
 
 struct headless_output {
 	struct weston_output base;
 	struct weston_mode mode;
 	struct wl_event_source *finish_frame_timer;
-};
+	uint32_t *image_buf;
+	pixman_image_t *image;
 
+	/* Simulated vblank clock: a vblank happens every refresh period
+	 * since vblank_base, in us on the clock of gettimeofday(). */
+	uint64_t vblank_base;
+	uint64_t next_vblank;
+};
 
-static void
-headless_output_start_repaint_loop(struct weston_output *output)
+static uint64_t
+headless_get_time_usec(void)
 {
-	uint32_t msec;
 	struct timeval tv;
 
 	gettimeofday(&tv, NULL);
-	msec = tv.tv_sec * 1000 + tv.tv_usec / 1000;
-	weston_output_finish_frame(output, msec);
+
+	return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint64_t
+headless_output_period_usec(struct headless_output *output)
+{
+	return 1000000000ULL / output->mode.refresh;
+}
+
+static void
+headless_output_start_repaint_loop(struct weston_output *output_base)
+{
+	struct headless_output *output = (struct headless_output *) output_base;
+	uint64_t now, vblank;
+
+	/* the last vblank, as if the previous frame was shown then */
+	now = headless_get_time_usec();
+	vblank = now - (now - output->vblank_base) %
+		headless_output_period_usec(output);
+
+	weston_output_finish_frame(&output->base, vblank / 1000);
 }
 
 static int
 finish_frame_handler(void *data)
 {
-	headless_output_start_repaint_loop(data);
+	struct headless_output *output = data;
+
+	weston_output_finish_frame(&output->base, output->next_vblank / 1000);
 
 	return 1;
 }
@@ -66,13 +95,20 @@ headless_output_repaint(struct weston_output *output_base,
 {
 	struct headless_output *output = (struct headless_output *) output_base;
 	struct weston_compositor *ec = output->base.compositor;
+	uint64_t now, period;
 
 	ec->renderer->repaint_output(&output->base, damage);
 
 	pixman_region32_subtract(&ec->primary_plane.damage,
 				 &ec->primary_plane.damage, damage);
 
-	wl_event_source_timer_update(output->finish_frame_timer, 16);
+	/* the frame is shown at the next vblank */
+	now = headless_get_time_usec();
+	period = headless_output_period_usec(output);
+	output->next_vblank = now - (now - output->vblank_base) % period +
+		period;
+	wl_event_source_timer_update(output->finish_frame_timer,
+				     (output->next_vblank - now + 999) / 1000);
 
 	return 0;
 }
@@ -81,8 +117,19 @@ static void
 headless_output_destroy(struct weston_output *output_base)
 {
 	struct headless_output *output = (struct headless_output *) output_base;
+	struct headless_compositor *c =
+		(struct headless_compositor *) output->base.compositor;
 
 	wl_event_source_remove(output->finish_frame_timer);
+
+	if (c->use_pixman) {
+		pixman_renderer_output_destroy(&output->base);
+		pixman_image_unref(output->image);
+		free(output->image_buf);
+	}
+
+	weston_output_destroy(&output->base);
+
 	free(output);
 
 	return;
@@ -103,7 +150,7 @@ headless_compositor_create_output(struct headless_compositor *c,
 		WL_OUTPUT_MODE_CURRENT | WL_OUTPUT_MODE_PREFERRED;
 	output->mode.width = width;
 	output->mode.height = height;
-	output->mode.refresh = 60;
+	output->mode.refresh = 60000;
 	wl_list_init(&output->base.mode_list);
 	wl_list_insert(&output->base.mode_list, &output->mode.link);
 
@@ -117,6 +164,7 @@ headless_compositor_create_output(struct headless_compositor *c,
 	loop = wl_display_get_event_loop(c->base.wl_display);
 	output->finish_frame_timer =
 		wl_event_loop_add_timer(loop, finish_frame_handler, output);
+	output->vblank_base = headless_get_time_usec();
 
 	output->base.start_repaint_loop = headless_output_start_repaint_loop;
 	output->base.repaint = headless_output_repaint;
@@ -126,9 +174,39 @@ headless_compositor_create_output(struct headless_compositor *c,
 	output->base.set_dpms = NULL;
 	output->base.switch_mode = NULL;
 
+	if (c->use_pixman) {
+		output->image_buf = malloc(width * height * 4);
+		if (!output->image_buf)
+			goto err_output;
+
+		output->image = pixman_image_create_bits(PIXMAN_x8r8g8b8,
+							 width, height,
+							 output->image_buf,
+							 width * 4);
+		if (!output->image)
+			goto err_buf;
+
+		if (pixman_renderer_output_create(&output->base) < 0)
+			goto err_image;
+
+		pixman_renderer_output_set_buffer(&output->base,
+						  output->image);
+	}
+
 	wl_list_insert(c->base.output_list.prev, &output->base.link);
 
 	return 0;
+
+err_image:
+	pixman_image_unref(output->image);
+err_buf:
+	free(output->image_buf);
+err_output:
+	wl_event_source_remove(output->finish_frame_timer);
+	wl_list_init(&output->base.link);
+	weston_output_destroy(&output->base);
+	free(output);
+	return -1;
 }
 
 static void
@@ -150,7 +228,7 @@ headless_destroy(struct weston_compositor *ec)
 static struct weston_compositor *
 headless_compositor_create(struct wl_display *display,
 			   int width, int height, const char *display_name,
-			   int *argc, char *argv[],
+			   int use_pixman, int *argc, char *argv[],
 			   struct weston_config *config)
 {
 	struct headless_compositor *c;
@@ -167,10 +245,17 @@ headless_compositor_create(struct wl_display *display,
 	c->base.destroy = headless_destroy;
 	c->base.restore = headless_restore;
 
-	if (headless_compositor_create_output(c, width, height) < 0)
-		goto err_compositor;
+	/* outputs of the pixman renderer are created by it */
+	c->use_pixman = use_pixman;
+	if (use_pixman) {
+		if (pixman_renderer_init(&c->base) < 0)
+			goto err_compositor;
+	} else {
+		if (noop_renderer_init(&c->base) < 0)
+			goto err_compositor;
+	}
 
-	if (noop_renderer_init(&c->base) < 0)
+	if (headless_compositor_create_output(c, width, height) < 0)
 		goto err_compositor;
 
 	return &c->base;
@@ -188,15 +273,17 @@ backend_init(struct wl_display *display, int *argc, char *argv[],
 {
 	int width = 1024, height = 640;
 	char *display_name = NULL;
+	int use_pixman = 0;
 
 	const struct weston_option headless_options[] = {
 		{ WESTON_OPTION_INTEGER, "width", 0, &width },
 		{ WESTON_OPTION_INTEGER, "height", 0, &height },
+		{ WESTON_OPTION_BOOLEAN, "use-pixman", 0, &use_pixman },
 	};
 
 	parse_options(headless_options,
 		      ARRAY_LENGTH(headless_options), argc, argv);
 
 	return headless_compositor_create(display, width, height, display_name,
-					  argc, argv, config);
+					  use_pixman, argc, argv, config);
 }
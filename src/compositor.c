@@ -175,6 +175,7 @@ weston_output_switch_mode(struct weston_output *output, struct weston_mode *mode
 	pixman_region32_init(&output->previous_damage);
 	pixman_region32_init_rect(&output->region, output->x, output->y,
 				  output->width, output->height);
+	output->compositor->pick_index.dirty = 1;
 
 	weston_output_update_matrix(output);
 
@@ -462,6 +463,8 @@ weston_view_create(struct weston_surface *surface)
 		weston_view_output_destroy_handler;
 	wl_list_init(&view->output_destroy_listener.link);
 
+	wl_list_init(&view->pick.floating_link);
+
 	return view;
 }
 
@@ -475,6 +478,7 @@ weston_surface_create(struct weston_compositor *compositor)
 		return NULL;
 
 	wl_signal_init(&surface->destroy_signal);
+	wl_signal_init(&surface->commit_signal);
 
 	surface->resource = NULL;
 
@@ -973,9 +977,36 @@ view_compute_bbox(struct weston_view *view, int32_t sx, int32_t sy,
 				  ceilf(max_x) - int_x, ceilf(max_y) - int_y);
 }
 
+/* Part of the surface drawn by the view, in surface coordinates */
+static void
+view_get_crop_box(struct weston_view *view, pixman_box32_t *box)
+{
+	box->x1 = 0;
+	box->y1 = 0;
+	box->x2 = view->surface->width;
+	box->y2 = view->surface->height;
+
+	if (!view->crop.enabled)
+		return;
+
+	if (view->crop.x > box->x1)
+		box->x1 = view->crop.x;
+	if (view->crop.y > box->y1)
+		box->y1 = view->crop.y;
+	box->x2 = MIN(box->x2, view->crop.x + view->crop.width);
+	box->y2 = MIN(box->y2, view->crop.y + view->crop.height);
+
+	if (box->x2 < box->x1)
+		box->x2 = box->x1;
+	if (box->y2 < box->y1)
+		box->y2 = box->y1;
+}
+
 static void
 weston_view_update_transform_disable(struct weston_view *view)
 {
+	pixman_box32_t crop;
+
 	view->transform.enabled = 0;
 
 	/* round off fractions when not transformed */
@@ -993,15 +1024,19 @@ weston_view_update_transform_disable(struct weston_view *view)
 	view->transform.inverse.d[12] = -view->geometry.x;
 	view->transform.inverse.d[13] = -view->geometry.y;
 
+	view_get_crop_box(view, &crop);
 	pixman_region32_init_rect(&view->transform.boundingbox,
-				  view->geometry.x,
-				  view->geometry.y,
-				  view->surface->width,
-				  view->surface->height);
-
-	if (view->alpha == 1.0) {
-		pixman_region32_copy(&view->transform.opaque,
-				     &view->surface->opaque);
+				  view->geometry.x + crop.x1,
+				  view->geometry.y + crop.y1,
+				  crop.x2 - crop.x1,
+				  crop.y2 - crop.y1);
+
+	if (view->alpha == 1.0 && !view->chroma_key.enabled) {
+		pixman_region32_intersect_rect(&view->transform.opaque,
+					       &view->surface->opaque,
+					       crop.x1, crop.y1,
+					       crop.x2 - crop.x1,
+					       crop.y2 - crop.y1);
 		pixman_region32_translate(&view->transform.opaque,
 					  view->geometry.x,
 					  view->geometry.y);
@@ -1015,6 +1050,7 @@ weston_view_update_transform_enable(struct weston_view *view)
 	struct weston_matrix *matrix = &view->transform.matrix;
 	struct weston_matrix *inverse = &view->transform.inverse;
 	struct weston_transform *tform;
+	pixman_box32_t crop;
 
 	view->transform.enabled = 1;
 
@@ -1037,13 +1073,257 @@ weston_view_update_transform_enable(struct weston_view *view)
 		return -1;
 	}
 
-	view_compute_bbox(view, 0, 0,
-			  view->surface->width, view->surface->height,
+	view_get_crop_box(view, &crop);
+	view_compute_bbox(view, crop.x1, crop.y1,
+			  crop.x2 - crop.x1, crop.y2 - crop.y1,
 			  &view->transform.boundingbox);
 
 	return 0;
 }
 
+/* Cells of the pick index are PICK_CELL_SIZE pixels square, made larger
+ * when the outputs would need more than PICK_GRID_MAX cells on a side.
+ */
+#define PICK_CELL_SIZE 128
+#define PICK_GRID_MAX 64
+
+static int
+pick_cell_index(int32_t v, int32_t origin, int32_t cell_size, int32_t count)
+{
+	int32_t i;
+
+	if (v < origin)
+		return 0;
+
+	i = (v - origin) / cell_size;
+
+	return i < count ? i : count - 1;
+}
+
+static int
+view_pick_cells(struct weston_view *view, pixman_box32_t *cells)
+{
+	struct weston_compositor *ec = view->surface->compositor;
+	pixman_box32_t *input, *bbox;
+
+	/* A view is picked anywhere its input region contains the point,
+	 * which the bounding box covers only when the input region lies
+	 * within the surface size. Committed surfaces always have it
+	 * clipped to the size, but not surfaces made by the compositor.
+	 */
+	input = pixman_region32_extents(&view->surface->input);
+	if (pixman_region32_not_empty(&view->surface->input) &&
+	    (input->x1 < 0 || input->y1 < 0 ||
+	     input->x2 > view->surface->width ||
+	     input->y2 > view->surface->height))
+		return -1;
+
+	/* One extra pixel around the box covers rounding of the point. */
+	bbox = pixman_region32_extents(&view->transform.boundingbox);
+	cells->x1 = pick_cell_index(bbox->x1 - 1, ec->pick_index.x,
+				    ec->pick_index.cell_size,
+				    ec->pick_index.cols);
+	cells->y1 = pick_cell_index(bbox->y1 - 1, ec->pick_index.y,
+				    ec->pick_index.cell_size,
+				    ec->pick_index.rows);
+	cells->x2 = pick_cell_index(bbox->x2, ec->pick_index.x,
+				    ec->pick_index.cell_size,
+				    ec->pick_index.cols) + 1;
+	cells->y2 = pick_cell_index(bbox->y2, ec->pick_index.y,
+				    ec->pick_index.cell_size,
+				    ec->pick_index.rows) + 1;
+
+	return 0;
+}
+
+static int
+pick_cell_insert(struct wl_array *cell, struct weston_view *view)
+{
+	struct weston_view **views, **p;
+	int n, i;
+
+	p = wl_array_add(cell, sizeof *p);
+	if (!p)
+		return -1;
+
+	/* keep the cell in view_list order */
+	views = cell->data;
+	n = cell->size / sizeof *p - 1;
+	for (i = n; i > 0 && views[i - 1]->pick.rank > view->pick.rank; i--)
+		views[i] = views[i - 1];
+	views[i] = view;
+
+	return 0;
+}
+
+static void
+pick_cell_remove(struct wl_array *cell, struct weston_view *view)
+{
+	struct weston_view **views = cell->data;
+	int n = cell->size / sizeof *views;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (views[i] == view) {
+			memmove(&views[i], &views[i + 1],
+				(n - i - 1) * sizeof *views);
+			cell->size -= sizeof *views;
+			return;
+		}
+	}
+}
+
+static void
+view_pick_cells_update(struct weston_view *view, pixman_box32_t *cells)
+{
+	struct weston_compositor *ec = view->surface->compositor;
+	pixman_box32_t *old = &view->pick.cells;
+	int32_t x, y, cols = ec->pick_index.cols;
+
+	if (view->pick.in_cells) {
+		for (y = old->y1; y < old->y2; y++)
+			for (x = old->x1; x < old->x2; x++)
+				pick_cell_remove(&ec->pick_index.cells[y * cols + x],
+						 view);
+	}
+
+	view->pick.in_cells = cells != NULL;
+	if (!cells)
+		return;
+
+	/* Out of memory, weston_compositor_pick_view() scans view_list
+	 * until the index could be rebuilt. */
+	view->pick.cells = *cells;
+	for (y = cells->y1; y < cells->y2; y++)
+		for (x = cells->x1; x < cells->x2; x++)
+			if (pick_cell_insert(&ec->pick_index.cells[y * cols + x],
+					     view) < 0)
+				ec->pick_index.dirty = 1;
+}
+
+static int
+view_in_pick_index(struct weston_view *view)
+{
+	struct weston_compositor *ec = view->surface->compositor;
+
+	return !ec->pick_index.dirty &&
+		view->pick.generation == ec->pick_index.generation;
+}
+
+/* Called when the transform of a view was updated. Views that cannot be
+ * placed in the grid stay on the floating list.
+ */
+static void
+view_pick_index_update(struct weston_view *view)
+{
+	struct weston_compositor *ec = view->surface->compositor;
+	pixman_box32_t cells;
+
+	if (!view_in_pick_index(view))
+		return;
+
+	wl_list_remove(&view->pick.floating_link);
+	wl_list_init(&view->pick.floating_link);
+
+	if (view_pick_cells(view, &cells) < 0) {
+		view_pick_cells_update(view, NULL);
+		wl_list_insert(&ec->pick_index.floating,
+			       &view->pick.floating_link);
+		return;
+	}
+
+	if (view->pick.in_cells &&
+	    memcmp(&cells, &view->pick.cells, sizeof cells) == 0)
+		return;
+
+	view_pick_cells_update(view, &cells);
+}
+
+static void
+pick_index_rebuild(struct weston_compositor *ec)
+{
+	struct weston_output *output;
+	struct weston_view *view, *next;
+	int32_t x1 = INT32_MAX, y1 = INT32_MAX, x2 = INT32_MIN, y2 = INT32_MIN;
+	int32_t size, count, i;
+	uint32_t rank = 0;
+
+	wl_list_for_each_safe(view, next, &ec->pick_index.floating,
+			      pick.floating_link)
+		wl_list_init(&view->pick.floating_link);
+	wl_list_init(&ec->pick_index.floating);
+
+	wl_list_for_each(output, &ec->output_list, link) {
+		x1 = MIN(x1, output->x);
+		y1 = MIN(y1, output->y);
+		x2 = MAX(x2, output->x + output->width);
+		y2 = MAX(y2, output->y + output->height);
+	}
+	if (x1 >= x2 || y1 >= y2) {
+		x1 = y1 = 0;
+		x2 = y2 = 1;
+	}
+
+	size = MAX(x2 - x1, y2 - y1);
+	ec->pick_index.cell_size = MAX(PICK_CELL_SIZE,
+				       (size + PICK_GRID_MAX - 1) /
+				       PICK_GRID_MAX);
+	size = ec->pick_index.cell_size;
+	count = ec->pick_index.cols * ec->pick_index.rows;
+
+	ec->pick_index.x = x1;
+	ec->pick_index.y = y1;
+	ec->pick_index.cols = (x2 - x1 + size - 1) / size;
+	ec->pick_index.rows = (y2 - y1 + size - 1) / size;
+
+	if (count != ec->pick_index.cols * ec->pick_index.rows) {
+		for (i = 0; i < count; i++)
+			wl_array_release(&ec->pick_index.cells[i]);
+		free(ec->pick_index.cells);
+
+		count = ec->pick_index.cols * ec->pick_index.rows;
+		ec->pick_index.cells = calloc(count,
+					      sizeof *ec->pick_index.cells);
+		if (!ec->pick_index.cells) {
+			ec->pick_index.cols = ec->pick_index.rows = 0;
+			return;
+		}
+		for (i = 0; i < count; i++)
+			wl_array_init(&ec->pick_index.cells[i]);
+	} else {
+		for (i = 0; i < count; i++)
+			ec->pick_index.cells[i].size = 0;
+	}
+
+	ec->pick_index.generation++;
+	ec->pick_index.dirty = 0;
+
+	wl_list_for_each(view, &ec->view_list, link) {
+		view->pick.generation = ec->pick_index.generation;
+		view->pick.rank = rank++;
+		view->pick.in_cells = 0;
+
+		if (view->transform.dirty)
+			wl_list_insert(ec->pick_index.floating.prev,
+				       &view->pick.floating_link);
+		else
+			view_pick_index_update(view);
+	}
+}
+
+static void
+pick_index_release(struct weston_compositor *ec)
+{
+	int32_t i, count = ec->pick_index.cols * ec->pick_index.rows;
+
+	for (i = 0; i < count; i++)
+		wl_array_release(&ec->pick_index.cells[i]);
+	free(ec->pick_index.cells);
+	ec->pick_index.cells = NULL;
+	ec->pick_index.cols = ec->pick_index.rows = 0;
+	ec->pick_index.dirty = 1;
+}
+
 WL_EXPORT void
 weston_view_update_transform(struct weston_view *view)
 {
@@ -1079,6 +1359,8 @@ weston_view_update_transform(struct weston_view *view)
 
 	weston_view_assign_output(view);
 
+	view_pick_index_update(view);
+
 	wl_signal_emit(&view->surface->compositor->transform_signal,
 		       view->surface);
 }
@@ -1100,6 +1382,14 @@ weston_view_geometry_dirty(struct weston_view *view)
 
 	view->transform.dirty = 1;
 
+	if (pixman_region32_not_empty(&view->surface->input))
+		view->surface->compositor->pick_generation++;
+
+	if (view_in_pick_index(view) &&
+	    wl_list_empty(&view->pick.floating_link))
+		wl_list_insert(&view->surface->compositor->pick_index.floating,
+			       &view->pick.floating_link);
+
 	wl_list_for_each(child, &view->geometry.child_list,
 			 geometry.parent_link)
 		weston_view_geometry_dirty(child);
@@ -1299,8 +1589,8 @@ weston_surface_set_size_from_buffer(struct weston_surface *surface)
 	}
 
 	if (surface->buffer_viewport.viewport_set) {
-		surface->width = surface->buffer_viewport.dst_width;
-		surface->height = surface->buffer_viewport.dst_height;
+		surface_set_size(surface, surface->buffer_viewport.dst_width,
+				 surface->buffer_viewport.dst_height);
 		return;
 	}
 
@@ -1333,23 +1623,84 @@ weston_compositor_get_time(void)
        return tv.tv_sec * 1000 + tv.tv_usec / 1000;
 }
 
+static int
+view_contains_point(struct weston_view *view, wl_fixed_t x, wl_fixed_t y,
+		    wl_fixed_t *vx, wl_fixed_t *vy)
+{
+	if (view->crop.enabled &&
+	    !pixman_region32_contains_point(&view->transform.boundingbox,
+					    wl_fixed_to_int(x),
+					    wl_fixed_to_int(y),
+					    NULL))
+		return 0;
+
+	weston_view_from_global_fixed(view, x, y, vx, vy);
+
+	return pixman_region32_contains_point(&view->surface->input,
+					      wl_fixed_to_int(*vx),
+					      wl_fixed_to_int(*vy),
+					      NULL);
+}
+
+/** Find the topmost view whose input region contains a point
+ *
+ * \param compositor The compositor.
+ * \param x, y The point in global coordinates.
+ * \param vx, vy Set to the point in coordinates of the view found.
+ * \return The view, or NULL if there is none.
+ *
+ * Only the views in the grid cell of the point and the views with
+ * dirty geometry are tested, see weston_compositor::pick_index.
+ */
 WL_EXPORT struct weston_view *
 weston_compositor_pick_view(struct weston_compositor *compositor,
 			    wl_fixed_t x, wl_fixed_t y,
 			    wl_fixed_t *vx, wl_fixed_t *vy)
 {
-	struct weston_view *view;
+	struct weston_view *view, *picked = NULL;
+	struct weston_view **p, **end;
+	struct wl_array *cell;
+	int32_t col, row;
+
+	if (compositor->pick_index.dirty)
+		pick_index_rebuild(compositor);
+
+	if (compositor->pick_index.dirty || !compositor->pick_index.cells) {
+		wl_list_for_each(view, &compositor->view_list, link)
+			if (view_contains_point(view, x, y, vx, vy))
+				return view;
+		return NULL;
+	}
 
-	wl_list_for_each(view, &compositor->view_list, link) {
-		weston_view_from_global_fixed(view, x, y, vx, vy);
-		if (pixman_region32_contains_point(&view->surface->input,
-						   wl_fixed_to_int(*vx),
-						   wl_fixed_to_int(*vy),
-						   NULL))
-			return view;
+	col = pick_cell_index(wl_fixed_to_int(x), compositor->pick_index.x,
+			      compositor->pick_index.cell_size,
+			      compositor->pick_index.cols);
+	row = pick_cell_index(wl_fixed_to_int(y), compositor->pick_index.y,
+			      compositor->pick_index.cell_size,
+			      compositor->pick_index.rows);
+	cell = &compositor->pick_index.cells[row *
+					     compositor->pick_index.cols + col];
+
+	end = (struct weston_view **) ((char *) cell->data + cell->size);
+	for (p = cell->data; p < end; p++) {
+		if (view_contains_point(*p, x, y, vx, vy)) {
+			picked = *p;
+			break;
+		}
 	}
 
-	return NULL;
+	wl_list_for_each(view, &compositor->pick_index.floating,
+			 pick.floating_link) {
+		if (picked && view->pick.rank >= picked->pick.rank)
+			continue;
+		if (view_contains_point(view, x, y, vx, vy))
+			picked = view;
+	}
+
+	if (picked)
+		weston_view_from_global_fixed(picked, x, y, vx, vy);
+
+	return picked;
 }
 
 static void
@@ -1379,6 +1730,9 @@ weston_view_unmap(struct weston_view *view)
 	wl_list_init(&view->layer_link);
 	wl_list_remove(&view->link);
 	wl_list_init(&view->link);
+	weston_compositor_scene_changed(view->surface->compositor);
+	view->surface->compositor->pick_index.dirty = 1;
+	view->surface->compositor->pick_generation++;
 	wl_list_remove(&view->output_move_listener.link);
 	wl_list_init(&view->output_move_listener.link);
 	wl_list_remove(&view->output_destroy_listener.link);
@@ -1427,11 +1781,17 @@ weston_view_destroy(struct weston_view *view)
 	if (weston_view_is_mapped(view)) {
 		weston_view_unmap(view);
 		weston_compositor_build_view_list(view->surface->compositor);
+	} else if (!wl_list_empty(&view->layer_link)) {
+		weston_compositor_scene_changed(view->surface->compositor);
 	}
 
 	wl_list_remove(&view->link);
 	wl_list_remove(&view->layer_link);
 
+	if (view_in_pick_index(view))
+		view->surface->compositor->pick_index.dirty = 1;
+	wl_list_remove(&view->pick.floating_link);
+
 	pixman_region32_fini(&view->clip);
 	pixman_region32_fini(&view->transform.boundingbox);
 
@@ -1635,6 +1995,18 @@ view_accumulate_damage(struct weston_view *view,
 					  view->geometry.y - view->plane->y);
 	}
 
+	/* damage outside of the crop is not shown */
+	if (view->crop.enabled) {
+		pixman_box32_t *bbox;
+
+		bbox = pixman_region32_extents(&view->transform.boundingbox);
+		pixman_region32_intersect_rect(&damage, &damage,
+					       bbox->x1 - view->plane->x,
+					       bbox->y1 - view->plane->y,
+					       bbox->x2 - bbox->x1,
+					       bbox->y2 - bbox->y1);
+	}
+
 	pixman_region32_subtract(&damage, &damage, opaque);
 	pixman_region32_union(&view->plane->damage,
 			      &view->plane->damage, &damage);
@@ -1643,8 +2015,27 @@ view_accumulate_damage(struct weston_view *view,
 	pixman_region32_union(opaque, opaque, &view->transform.opaque);
 }
 
+/* Whether damage and clip of the view are computed for the output.
+ *
+ * Views on other outputs are left for the repaint of those outputs, which
+ * is scheduled by whatever damaged them. All views of a surface shown on
+ * the output are processed together, because the surface damage is
+ * flushed once for all of them. Views on no output are processed with
+ * every output, so that their buffers are still released.
+ */
+static int
+view_in_output_repaint(struct weston_view *view, struct weston_output *output)
+{
+	uint32_t bit = 1 << output->id;
+
+	return view->output_mask == 0 ||
+	       (view->output_mask & bit) ||
+	       (view->surface->output_mask & bit);
+}
+
 static void
-compositor_accumulate_damage(struct weston_compositor *ec)
+compositor_accumulate_damage(struct weston_compositor *ec,
+			     struct weston_output *output)
 {
 	struct weston_plane *plane;
 	struct weston_view *ev;
@@ -1658,7 +2049,8 @@ compositor_accumulate_damage(struct weston_compositor *ec)
 		pixman_region32_init(&opaque);
 
 		wl_list_for_each(ev, &ec->view_list, link) {
-			if (ev->plane != plane)
+			if (ev->plane != plane ||
+			    !view_in_output_repaint(ev, output))
 				continue;
 
 			view_accumulate_damage(ev, &opaque);
@@ -1674,7 +2066,8 @@ compositor_accumulate_damage(struct weston_compositor *ec)
 		ev->surface->touched = 0;
 
 	wl_list_for_each(ev, &ec->view_list, link) {
-		if (ev->surface->touched)
+		if (ev->surface->touched ||
+		    !view_in_output_repaint(ev, output))
 			continue;
 		ev->surface->touched = 1;
 
@@ -1795,6 +2188,12 @@ weston_compositor_build_view_list(struct weston_compositor *compositor)
 	struct weston_view *view;
 	struct weston_layer *layer;
 
+	/* Changes made while building, e.g. by destroying unused
+	 * subsurface views, cause another rebuild. */
+	compositor->view_list_generation = compositor->scene_generation;
+	compositor->pick_index.dirty = 1;
+	compositor->pick_generation++;
+
 	wl_list_for_each(layer, &compositor->layer_list, link)
 		wl_list_for_each(view, &layer->view_list, layer_link)
 			surface_stash_subsurface_views(view->surface);
@@ -1825,8 +2224,13 @@ weston_output_repaint(struct weston_output *output, uint32_t msecs)
 	if (output->destroying)
 		return 0;
 
-	/* Rebuild the surface list and update surface transforms up front. */
-	weston_compositor_build_view_list(ec);
+	/* Rebuild the surface list if the scene graph changed, and update
+	 * surface transforms up front. */
+	if (ec->view_list_generation != ec->scene_generation)
+		weston_compositor_build_view_list(ec);
+	else
+		wl_list_for_each(ev, &ec->view_list, link)
+			weston_view_update_transform(ev);
 
 	if (output->assign_planes && !output->disable_planes)
 		output->assign_planes(output);
@@ -1846,7 +2250,7 @@ weston_output_repaint(struct weston_output *output, uint32_t msecs)
 		}
 	}
 
-	compositor_accumulate_damage(ec);
+	compositor_accumulate_damage(ec, output);
 
 	pixman_region32_init(&output_damage);
 	pixman_region32_intersect(&output_damage,
@@ -1889,20 +2293,31 @@ weston_compositor_read_input(int fd, uint32_t mask, void *data)
 	return 1;
 }
 
-WL_EXPORT void
-weston_output_finish_frame(struct weston_output *output, uint32_t msecs)
+static void
+weston_output_repaint_or_stop(struct weston_output *output, uint32_t msecs)
 {
 	struct weston_compositor *compositor = output->compositor;
 	struct wl_event_loop *loop =
 		wl_display_get_event_loop(compositor->wl_display);
+	struct timespec begin, end;
+	uint32_t usec;
 	int fd, r;
 
-	output->frame_time = msecs;
-
 	if (output->repaint_needed &&
 	    compositor->state != WESTON_COMPOSITOR_SLEEPING &&
 	    compositor->state != WESTON_COMPOSITOR_OFFSCREEN) {
+		clock_gettime(CLOCK_MONOTONIC, &begin);
 		r = weston_output_repaint(output, msecs);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		/* follow a slower repaint at once, a faster one slowly */
+		usec = (end.tv_sec - begin.tv_sec) * 1000000 +
+			(end.tv_nsec - begin.tv_nsec) / 1000;
+		if (usec > output->repaint_usec)
+			output->repaint_usec = usec;
+		else
+			output->repaint_usec -= (output->repaint_usec - usec) / 8;
+
 		if (!r)
 			return;
 	}
@@ -1917,6 +2332,70 @@ weston_output_finish_frame(struct weston_output *output, uint32_t msecs)
 				     weston_compositor_read_input, compositor);
 }
 
+static int
+output_repaint_timer_handler(void *data)
+{
+	struct weston_output *output = data;
+
+	/* The input loop source is removed while a repaint is scheduled,
+	 * so input received while waiting is dispatched now, to be shown
+	 * by this repaint. */
+	wl_event_loop_dispatch(output->compositor->input_loop, 0);
+
+	weston_output_repaint_or_stop(output, output->frame_time);
+
+	return 1;
+}
+
+/* Time in ms from now until the repaint for the next vblank should start.
+ * The window before the vblank is repaint_msec, or one and a half times
+ * the measured repaint duration if that is longer.
+ */
+static int32_t
+output_repaint_delay(struct weston_output *output, uint32_t msecs)
+{
+	struct weston_compositor *compositor = output->compositor;
+	int32_t period_usec, window_usec, elapsed;
+
+	if (compositor->repaint_msec <= 0 || !output->current_mode ||
+	    output->current_mode->refresh <= 0)
+		return 0;
+
+	period_usec = 1000000000 / output->current_mode->refresh;
+	window_usec = MAX(compositor->repaint_msec * 1000,
+			  output->repaint_usec + output->repaint_usec / 2);
+	if (window_usec >= period_usec)
+		return 0;
+
+	/* msecs is the vblank that just passed. Backends whose clock is
+	 * not the one of weston_compositor_get_time() report a time far
+	 * from now, assume it was now. */
+	elapsed = weston_compositor_get_time() - msecs;
+	if (elapsed < 0 || elapsed > period_usec / 1000)
+		elapsed = 0;
+
+	return (period_usec - window_usec) / 1000 - elapsed;
+}
+
+WL_EXPORT void
+weston_output_finish_frame(struct weston_output *output, uint32_t msecs)
+{
+	int32_t delay;
+
+	output->frame_time = msecs;
+
+	if (output->repaint_needed) {
+		delay = output_repaint_delay(output, msecs);
+		if (delay > 0) {
+			wl_event_source_timer_update(output->repaint_timer,
+						     delay);
+			return;
+		}
+	}
+
+	weston_output_repaint_or_stop(output, msecs);
+}
+
 static void
 idle_repaint(void *data)
 {
@@ -1933,6 +2412,20 @@ weston_layer_init(struct weston_layer *layer, struct wl_list *below)
 		wl_list_insert(below, &layer->link);
 }
 
+/** Notify that the scene graph changed
+ *
+ * \param compositor The compositor
+ *
+ * Must be called after changing compositor->layer_list or the view_list
+ * of a layer, so that the view list is rebuilt on the next repaint.
+ * Subsurface stacking changes are tracked by the compositor itself.
+ */
+WL_EXPORT void
+weston_compositor_scene_changed(struct weston_compositor *compositor)
+{
+	compositor->scene_generation++;
+}
+
 WL_EXPORT void
 weston_output_schedule_repaint(struct weston_output *output)
 {
@@ -2086,16 +2579,48 @@ surface_set_input_region(struct wl_client *client,
 	}
 }
 
+static void
+surface_commit_input(struct weston_surface *surface, pixman_region32_t *input)
+{
+	pixman_region32_t region;
+
+	pixman_region32_init_rect(&region, 0, 0,
+				  surface->width,
+				  surface->height);
+	pixman_region32_intersect(&region, &region, input);
+
+	if (!pixman_region32_equal(&region, &surface->input)) {
+		pixman_region32_copy(&surface->input, &region);
+		surface->compositor->pick_generation++;
+	}
+
+	pixman_region32_fini(&region);
+}
+
 static void
 weston_surface_commit_subsurface_order(struct weston_surface *surface)
 {
 	struct weston_subsurface *sub;
+	struct wl_list *link = surface->subsurface_list.next;
+
+	/* Both lists hold the same subsurfaces, only the order differs. */
+	wl_list_for_each(sub, &surface->subsurface_list_pending,
+			 parent_link_pending) {
+		if (link != &sub->parent_link)
+			break;
+		link = link->next;
+	}
+
+	if (link == &surface->subsurface_list)
+		return;
 
 	wl_list_for_each_reverse(sub, &surface->subsurface_list_pending,
 				 parent_link_pending) {
 		wl_list_remove(&sub->parent_link);
 		wl_list_insert(&surface->subsurface_list, &sub->parent_link);
 	}
+
+	weston_compositor_scene_changed(surface->compositor);
 }
 
 static void
@@ -2151,12 +2676,7 @@ weston_surface_commit(struct weston_surface *surface)
 	pixman_region32_fini(&opaque);
 
 	/* wl_surface.set_input_region */
-	pixman_region32_fini(&surface->input);
-	pixman_region32_init_rect(&surface->input, 0, 0,
-				  surface->width,
-				  surface->height);
-	pixman_region32_intersect(&surface->input,
-				  &surface->input, &surface->pending.input);
+	surface_commit_input(surface, &surface->pending.input);
 
 	/* wl_surface.frame */
 	wl_list_insert_list(&surface->frame_callback_list,
@@ -2166,6 +2686,8 @@ weston_surface_commit(struct weston_surface *surface)
 	weston_surface_commit_subsurface_order(surface);
 
 	weston_surface_schedule_repaint(surface);
+
+	wl_signal_emit(&surface->commit_signal, surface);
 }
 
 static void
@@ -2373,12 +2895,7 @@ weston_subsurface_commit_from_cache(struct weston_subsurface *sub)
 	pixman_region32_fini(&opaque);
 
 	/* wl_surface.set_input_region */
-	pixman_region32_fini(&surface->input);
-	pixman_region32_init_rect(&surface->input, 0, 0,
-				  surface->width,
-				  surface->height);
-	pixman_region32_intersect(&surface->input,
-				  &surface->input, &sub->cached.input);
+	surface_commit_input(surface, &sub->cached.input);
 
 	/* wl_surface.frame */
 	wl_list_insert_list(&surface->frame_callback_list,
@@ -2718,6 +3235,7 @@ weston_subsurface_cache_fini(struct weston_subsurface *sub)
 static void
 weston_subsurface_unlink_parent(struct weston_subsurface *sub)
 {
+	weston_compositor_scene_changed(sub->parent->compositor);
 	wl_list_remove(&sub->parent_link);
 	wl_list_remove(&sub->parent_link_pending);
 	wl_list_remove(&sub->parent_destroy_listener.link);
@@ -2784,6 +3302,7 @@ weston_subsurface_link_parent(struct weston_subsurface *sub,
 	wl_list_insert(&parent->subsurface_list, &sub->parent_link);
 	wl_list_insert(&parent->subsurface_list_pending,
 		       &sub->parent_link_pending);
+	weston_compositor_scene_changed(parent->compositor);
 }
 
 static void
@@ -2824,6 +3343,7 @@ weston_subsurface_destroy(struct weston_subsurface *sub)
 		assert(sub->parent_destroy_listener.notify == NULL);
 		wl_list_remove(&sub->parent_link);
 		wl_list_remove(&sub->parent_link_pending);
+		weston_compositor_scene_changed(sub->surface->compositor);
 	}
 
 	wl_list_remove(&sub->surface_destroy_listener.link);
@@ -2887,6 +3407,7 @@ weston_subsurface_create_for_parent(struct weston_surface *parent)
 	wl_list_insert(&parent->subsurface_list, &sub->parent_link);
 	wl_list_insert(&parent->subsurface_list_pending,
 		       &sub->parent_link_pending);
+	weston_compositor_scene_changed(parent->compositor);
 
 	return sub;
 }
@@ -3190,11 +3711,14 @@ weston_output_destroy(struct weston_output *output)
 
 	weston_compositor_remove_output(output->compositor, output);
 	wl_list_remove(&output->link);
+	output->compositor->pick_index.dirty = 1;
 
 	weston_compositor_verify_pointers(output->compositor);
 
 	wl_signal_emit(&output->destroy_signal, output);
 
+	wl_event_source_remove(output->repaint_timer);
+
 	free(output->name);
 	pixman_region32_fini(&output->region);
 	pixman_region32_fini(&output->previous_damage);
@@ -3334,6 +3858,7 @@ weston_output_init_geometry(struct weston_output *output, int x, int y)
 	pixman_region32_init_rect(&output->region, x, y,
 				  output->width,
 				  output->height);
+	output->compositor->pick_index.dirty = 1;
 }
 
 WL_EXPORT void
@@ -3399,6 +3924,10 @@ weston_output_init(struct weston_output *output, struct weston_compositor *c,
 	output->id = ffs(~output->compositor->output_id_pool) - 1;
 	output->compositor->output_id_pool |= 1 << output->id;
 
+	output->repaint_timer =
+		wl_event_loop_add_timer(wl_display_get_event_loop(c->wl_display),
+					output_repaint_timer_handler, output);
+
 	output->global =
 		wl_global_create(c->wl_display, &wl_output_interface, 2,
 				 output, bind_output);
@@ -3672,6 +4201,10 @@ weston_compositor_init(struct weston_compositor *ec,
 		return -1;
 
 	wl_list_init(&ec->view_list);
+	ec->scene_generation = 1;
+	ec->view_list_generation = 0;
+	ec->pick_index.dirty = 1;
+	wl_list_init(&ec->pick_index.floating);
 	wl_list_init(&ec->plane_list);
 	wl_list_init(&ec->layer_list);
 	wl_list_init(&ec->seat_list);
@@ -3686,6 +4219,10 @@ weston_compositor_init(struct weston_compositor *ec,
 	weston_plane_init(&ec->primary_plane, ec, 0, 0);
 	weston_compositor_stack_plane(ec, &ec->primary_plane, NULL);
 
+	s = weston_config_get_section(ec->config, "core", NULL, NULL);
+	weston_config_section_get_int(s, "repaint-window",
+				      &ec->repaint_msec, 0);
+
 	s = weston_config_get_section(ec->config, "keyboard", NULL, NULL);
 	weston_config_section_get_string(s, "keymap_rules",
 					 (char **) &xkb_names.rules, NULL);
@@ -3748,6 +4285,8 @@ weston_compositor_shutdown(struct weston_compositor *ec)
 
 	weston_plane_release(&ec->primary_plane);
 
+	pick_index_release(ec);
+
 	wl_event_loop_destroy(ec->input_loop);
 
 	weston_config_destroy(ec->config);
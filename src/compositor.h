@@ -43,6 +43,10 @@ extern "C" {
 #define MIN(x,y) (((x) < (y)) ? (x) : (y))
 #endif
 
+#ifndef MAX
+#define MAX(x,y) (((x) > (y)) ? (x) : (y))
+#endif
+
 #define ARRAY_LENGTH(a) (sizeof (a) / sizeof (a)[0])
 
 #define container_of(ptr, type, member) ({				\
@@ -200,6 +204,11 @@ struct weston_output {
 	int disable_planes;
 	int destroying;
 
+	/* Delays the repaint after a vblank, see
+	 * weston_compositor::repaint_msec */
+	struct wl_event_source *repaint_timer;
+	uint32_t repaint_usec; /* smoothed duration of a repaint */
+
 	char *make, *model, *serial_number;
 	uint32_t subpixel;
 	uint32_t transform;
@@ -329,6 +338,15 @@ struct weston_pointer {
 
 	wl_fixed_t x, y;
 	uint32_t button_count;
+
+	/* Last pick of the default grab, reused while the pointer stays
+	 * on the view and weston_compositor::pick_generation is unchanged.
+	 */
+	struct {
+		struct weston_view *view;
+		uint32_t generation;
+		pixman_region32_t cover;
+	} pick_cache;
 };
 
 
@@ -550,6 +568,10 @@ struct weston_renderer {
 	void (*surface_set_color)(struct weston_surface *surface,
 			       float red, float green,
 			       float blue, float alpha);
+	/* Show a premultiplied a8r8g8b8 image which is owned by compositor,
+	 * instead of a client buffer. Optional, may be NULL. */
+	void (*surface_set_image)(struct weston_surface *surface,
+				  pixman_image_t *image);
 	void (*destroy)(struct weston_compositor *ec);
 };
 
@@ -596,6 +618,34 @@ struct weston_compositor {
 	struct wl_list seat_list;
 	struct wl_list layer_list;
 	struct wl_list view_list;
+	/* view_list is rebuilt only when scene_generation has moved since
+	 * view_list_generation, see weston_compositor_scene_changed() */
+	uint32_t scene_generation;
+	uint32_t view_list_generation;
+
+	/* Uniform grid over the outputs used by
+	 * weston_compositor_pick_view(). Each cell lists the views whose
+	 * bounding box touches it, in view_list order. Views with dirty
+	 * geometry are on the floating list and tested on every pick
+	 * until their transform is updated. Rebuilt on the next pick
+	 * after view_list or the outputs changed.
+	 */
+	struct {
+		int dirty;
+		uint32_t generation;
+		int32_t x, y;
+		int32_t cell_size;
+		int32_t cols, rows;
+		struct wl_array *cells;  /* struct weston_view * */
+		struct wl_list floating; /* weston_view::pick.floating_link */
+	} pick_index;
+
+	/* Incremented whenever the result of weston_compositor_pick_view()
+	 * may have changed at some point: view_list was rebuilt, a view
+	 * with an input region moved or an input region changed.
+	 */
+	uint32_t pick_generation;
+
 	struct wl_list plane_list;
 	struct wl_list key_binding_list;
 	struct wl_list modifier_binding_list;
@@ -609,6 +659,10 @@ struct weston_compositor {
 	uint32_t idle_inhibit;
 	int idle_time;			/* timeout, s */
 
+	/* Repaint this long before the next vblank instead of right after
+	 * the previous one, or at once if 0, in ms. */
+	int32_t repaint_msec;
+
 	const struct weston_pointer_grab_interface *default_pointer_grab;
 
 	/* Repaint state. */
@@ -771,6 +825,30 @@ struct weston_view {
 	pixman_region32_t clip;
 	float alpha;                     /* part of geometry, see below */
 
+	/* Pixels whose RGB is equal to color (0x00RRGGBB) are not drawn.
+	 * Part of geometry like alpha, and supported by pixman renderer.
+	 */
+	struct {
+		int enabled;
+		uint32_t color;
+	} chroma_key;
+
+	/* Part of the surface drawn by this view, in surface coordinates,
+	 * like the source rectangle of wl_viewport but without scaling.
+	 * Nothing outside is drawn, damaged or picked. Part of geometry,
+	 * call weston_view_geometry_dirty() after changing it.
+	 */
+	struct {
+		int enabled;
+		int32_t x, y;
+		int32_t width, height;
+	} crop;
+
+	/* Content is drawn by another view which caches it. The view stays
+	 * in the view list, e.g. for input, but renderers skip it.
+	 */
+	int cached;
+
 	void *renderer_state;
 
 	/* Surface geometry state, mutable.
@@ -824,11 +902,23 @@ struct weston_view {
 
 	struct wl_listener output_move_listener;
 	struct wl_listener output_destroy_listener;
+
+	/* State of the view in weston_compositor::pick_index, valid only
+	 * while generation matches the index.
+	 */
+	struct {
+		uint32_t generation;
+		uint32_t rank; /* position in weston_compositor::view_list */
+		int in_cells;
+		pixman_box32_t cells; /* cell range, x2 and y2 exclusive */
+		struct wl_list floating_link;
+	} pick;
 };
 
 struct weston_surface {
 	struct wl_resource *resource;
 	struct wl_signal destroy_signal;
+	struct wl_signal commit_signal;
 	struct weston_compositor *compositor;
 	pixman_region32_t damage;
 	pixman_region32_t opaque;        /* part of geometry, see below */
@@ -1005,6 +1095,8 @@ notify_touch(struct weston_seat *seat, uint32_t time, int touch_id,
 
 void
 weston_layer_init(struct weston_layer *layer, struct wl_list *below);
+void
+weston_compositor_scene_changed(struct weston_compositor *compositor);
 
 void
 weston_plane_init(struct weston_plane *plane,
@@ -202,6 +202,7 @@ drag_surface_configure(struct weston_drag *drag,
 
 		wl_list_remove(&drag->icon->layer_link);
 		wl_list_insert(list, &drag->icon->layer_link);
+		weston_compositor_scene_changed(es->compositor);
 		weston_view_update_transform(drag->icon);
 		empty_region(&es->pending.input);
 	}
@@ -642,7 +642,9 @@ repaint_views(struct weston_output *output, pixman_region32_t *damage)
 	struct weston_view *view;
 
 	wl_list_for_each_reverse(view, &compositor->view_list, link)
-		if (view->plane == &compositor->primary_plane)
+		if (view->plane == &compositor->primary_plane &&
+		    view->output_mask & (1 << output->id) &&
+		    !view->cached)
 			draw_view(view, output, damage);
 }
 
@@ -1211,6 +1213,33 @@ gl_renderer_surface_set_color(struct weston_surface *surface,
 	gs->shader = &gr->solid_shader;
 }
 
+static void
+gl_renderer_surface_set_image(struct weston_surface *surface,
+			      pixman_image_t *image)
+{
+	struct gl_surface_state *gs = get_surface_state(surface);
+	struct gl_renderer *gr = get_renderer(surface->compositor);
+
+	/* No buffer is held, so flush_damage never uploads over the image */
+	gl_renderer_attach(surface, NULL);
+
+	gs->shader = &gr->texture_shader_rgba;
+	gs->pitch = pixman_image_get_stride(image) / 4;
+	gs->height = pixman_image_get_height(image);
+	gs->target = GL_TEXTURE_2D;
+	gs->buffer_type = BUFFER_TYPE_SHM;
+	gs->needs_full_upload = 0;
+	gs->y_inverted = 1;
+	gs->surface = surface;
+
+	ensure_textures(gs, 1);
+	glBindTexture(GL_TEXTURE_2D, gs->textures[0]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_BGRA_EXT,
+		     gs->pitch, gs->height, 0,
+		     GL_BGRA_EXT, GL_UNSIGNED_BYTE,
+		     pixman_image_get_data(image));
+}
+
 static void
 surface_state_destroy(struct gl_surface_state *gs, struct gl_renderer *gr)
 {
@@ -1757,6 +1786,7 @@ gl_renderer_create(struct weston_compositor *ec, EGLNativeDisplayType display,
 	gr->base.flush_damage = gl_renderer_flush_damage;
 	gr->base.attach = gl_renderer_attach;
 	gr->base.surface_set_color = gl_renderer_surface_set_color;
+	gr->base.surface_set_image = gl_renderer_surface_set_image;
 	gr->base.destroy = gl_renderer_destroy;
 
 	gr->egl_display = eglGetDisplay(display);
@@ -143,6 +143,99 @@ move_resources_for_client(struct wl_list *destination,
 	}
 }
 
+static int
+view_input_contains_point(struct weston_view *view, wl_fixed_t x, wl_fixed_t y)
+{
+	wl_fixed_t vx, vy;
+
+	if (view->crop.enabled &&
+	    !pixman_region32_contains_point(&view->transform.boundingbox,
+					    wl_fixed_to_int(x),
+					    wl_fixed_to_int(y),
+					    NULL))
+		return 0;
+
+	weston_view_from_global_fixed(view, x, y, &vx, &vy);
+
+	return pixman_region32_contains_point(&view->surface->input,
+					      wl_fixed_to_int(vx),
+					      wl_fixed_to_int(vy),
+					      NULL);
+}
+
+/* Remember the view picked for the pointer, together with the area where
+ * views above it could be picked instead. While the compositor's
+ * pick_generation is unchanged, the pick stays the same at any point
+ * inside the view's input region and outside that area.
+ */
+static void
+pointer_pick_cache_update(struct weston_pointer *pointer,
+			  struct weston_view *picked)
+{
+	struct weston_compositor *ec = pointer->seat->compositor;
+	pixman_region32_t *cover = &pointer->pick_cache.cover;
+	pixman_box32_t *input, *box, area;
+	struct weston_view *view;
+
+	pointer->pick_cache.view = NULL;
+	if (!picked || picked->transform.dirty)
+		return;
+
+	empty_region(cover);
+	box = pixman_region32_extents(&picked->transform.boundingbox);
+	area = *box;
+
+	wl_list_for_each(view, &ec->view_list, link) {
+		if (view == picked)
+			break;
+
+		if (!pixman_region32_not_empty(&view->surface->input))
+			continue;
+
+		/* The bounding box is stale or does not cover the input
+		 * region, don't cache. */
+		input = pixman_region32_extents(&view->surface->input);
+		if (view->transform.dirty ||
+		    input->x1 < 0 || input->y1 < 0 ||
+		    input->x2 > view->surface->width ||
+		    input->y2 > view->surface->height)
+			return;
+
+		/* One extra pixel covers rounding of the point. */
+		box = pixman_region32_extents(&view->transform.boundingbox);
+		if (box->x2 + 1 <= area.x1 || box->x1 - 1 >= area.x2 ||
+		    box->y2 + 1 <= area.y1 || box->y1 - 1 >= area.y2)
+			continue;
+
+		pixman_region32_union_rect(cover, cover,
+					   box->x1 - 1, box->y1 - 1,
+					   box->x2 - box->x1 + 2,
+					   box->y2 - box->y1 + 2);
+	}
+
+	if (view != picked)
+		return;
+
+	pointer->pick_cache.view = picked;
+	pointer->pick_cache.generation = ec->pick_generation;
+}
+
+static int
+pointer_pick_cache_valid(struct weston_pointer *pointer)
+{
+	struct weston_compositor *ec = pointer->seat->compositor;
+
+	return pointer->pick_cache.view &&
+		pointer->pick_cache.view == pointer->focus &&
+		pointer->pick_cache.generation == ec->pick_generation &&
+		!pixman_region32_contains_point(&pointer->pick_cache.cover,
+						wl_fixed_to_int(pointer->x),
+						wl_fixed_to_int(pointer->y),
+						NULL) &&
+		view_input_contains_point(pointer->focus,
+					  pointer->x, pointer->y);
+}
+
 static void
 default_grab_pointer_focus(struct weston_pointer_grab *grab)
 {
@@ -153,12 +246,17 @@ default_grab_pointer_focus(struct weston_pointer_grab *grab)
 	if (pointer->button_count > 0)
 		return;
 
+	if (pointer_pick_cache_valid(pointer))
+		return;
+
 	view = weston_compositor_pick_view(pointer->seat->compositor,
 					   pointer->x, pointer->y,
 					   &sx, &sy);
 
 	if (pointer->focus != view)
 		weston_pointer_set_focus(pointer, view, sx, sy);
+
+	pointer_pick_cache_update(pointer, view);
 }
 
 static void
@@ -458,6 +556,7 @@ weston_pointer_create(struct weston_seat *seat)
 	wl_signal_init(&pointer->motion_signal);
 	wl_signal_init(&pointer->focus_signal);
 	wl_list_init(&pointer->focus_view_listener.link);
+	pixman_region32_init(&pointer->pick_cache.cover);
 
 	pointer->sprite_destroy_listener.notify = pointer_handle_sprite_destroy;
 
@@ -478,6 +577,7 @@ weston_pointer_destroy(struct weston_pointer *pointer)
 
 	wl_list_remove(&pointer->focus_resource_listener.link);
 	wl_list_remove(&pointer->focus_view_listener.link);
+	pixman_region32_fini(&pointer->pick_cache.cover);
 	free(pointer);
 }
 
@@ -1533,6 +1633,7 @@ pointer_cursor_surface_configure(struct weston_surface *es,
 	if (!weston_surface_is_mapped(es)) {
 		wl_list_insert(&es->compositor->cursor_layer.view_list,
 			       &pointer->sprite->layer_link);
+		weston_compositor_scene_changed(es->compositor);
 		weston_view_update_transform(pointer->sprite);
 	}
 }
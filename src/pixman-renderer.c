@@ -27,6 +27,7 @@
 #include <stdlib.h>
 
 #include "pixman-renderer.h"
+#include "chroma-key.h"
 
 #include <linux/input.h>
 
@@ -42,6 +43,13 @@ struct pixman_surface_state {
 	pixman_image_t *image;
 	struct weston_buffer_reference buffer_ref;
 
+	/* a8 mask of image for chroma key, 0x00 for keyed pixels */
+	struct {
+		pixman_image_t *mask;
+		uint32_t color;
+		int dirty;
+	} chroma_key;
+
 	struct wl_listener buffer_destroy_listener;
 	struct wl_listener surface_destroy_listener;
 	struct wl_listener renderer_destroy_listener;
@@ -127,6 +135,49 @@ pixman_renderer_read_pixels(struct weston_output *output,
 	return 0;
 }
 
+static int
+pixman_renderer_read_surface_pixels(struct weston_surface *es,
+				    pixman_format_code_t format, void *pixels,
+				    int x, int y, int width, int height)
+{
+	struct pixman_surface_state *ps = get_surface_state(es);
+	pixman_image_t *out_buf;
+
+	if (!ps->image)
+		return -1;
+
+	out_buf = pixman_image_create_bits(format,
+		width,
+		height,
+		pixels,
+		(PIXMAN_FORMAT_BPP(format) / 8) * width);
+	if (!out_buf)
+		return -1;
+
+	/* Transform and filter are left by the last repaint */
+	pixman_image_set_transform(ps->image, NULL);
+	pixman_image_set_filter(ps->image, PIXMAN_FILTER_NEAREST, NULL, 0);
+
+	if (ps->buffer_ref.buffer)
+		wl_shm_buffer_begin_access(ps->buffer_ref.buffer->shm_buffer);
+
+	pixman_image_composite32(PIXMAN_OP_SRC,
+				 ps->image, /* src */
+				 NULL /* mask */,
+				 out_buf, /* dest */
+				 x, y, /* src_x, src_y */
+				 0, 0, /* mask_x, mask_y */
+				 0, 0, /* dest_x, dest_y */
+				 width, height);
+
+	if (ps->buffer_ref.buffer)
+		wl_shm_buffer_end_access(ps->buffer_ref.buffer->shm_buffer);
+
+	pixman_image_unref(out_buf);
+
+	return 0;
+}
+
 static void
 region_global_to_output(struct weston_output *output, pixman_region32_t *region)
 {
@@ -138,6 +189,51 @@ region_global_to_output(struct weston_output *output, pixman_region32_t *region)
 
 #define D2F(v) pixman_double_to_fixed((double)v)
 
+static pixman_image_t *
+get_chroma_key_mask(struct pixman_surface_state *ps, uint32_t color)
+{
+	int width = pixman_image_get_width(ps->image);
+	int height = pixman_image_get_height(ps->image);
+	pixman_image_t *mask = ps->chroma_key.mask;
+
+	if (PIXMAN_FORMAT_BPP(pixman_image_get_format(ps->image)) != 32)
+		return NULL;
+
+	if (mask && !ps->chroma_key.dirty && ps->chroma_key.color == color)
+		return mask;
+
+	if (mask && (pixman_image_get_width(mask) != width ||
+		     pixman_image_get_height(mask) != height)) {
+		pixman_image_unref(mask);
+		mask = NULL;
+	}
+
+	if (!mask) {
+		mask = pixman_image_create_bits(PIXMAN_a8, width, height,
+						NULL, 0);
+		ps->chroma_key.mask = mask;
+		if (!mask)
+			return NULL;
+	}
+
+	if (ps->buffer_ref.buffer)
+		wl_shm_buffer_begin_access(ps->buffer_ref.buffer->shm_buffer);
+
+	chroma_key_mask(pixman_image_get_data(mask),
+			pixman_image_get_stride(mask),
+			pixman_image_get_data(ps->image),
+			pixman_image_get_stride(ps->image),
+			width, height, color);
+
+	if (ps->buffer_ref.buffer)
+		wl_shm_buffer_end_access(ps->buffer_ref.buffer->shm_buffer);
+
+	ps->chroma_key.color = color;
+	ps->chroma_key.dirty = 0;
+
+	return mask;
+}
+
 static void
 repaint_region(struct weston_view *ev, struct weston_output *output,
 	       pixman_region32_t *region, pixman_region32_t *surf_region,
@@ -151,6 +247,8 @@ repaint_region(struct weston_view *ev, struct weston_output *output,
 	float view_x, view_y;
 	pixman_transform_t transform;
 	pixman_fixed_t fw, fh;
+	pixman_image_t *mask = NULL;
+	pixman_filter_t filter;
 
 	/* The final region to be painted is the intersection of
 	 * 'region' and 'surf_region'. However, 'region' is in the global
@@ -320,16 +418,25 @@ repaint_region(struct weston_view *ev, struct weston_output *output,
 	pixman_image_set_transform(ps->image, &transform);
 
 	if (ev->transform.enabled || output->current_scale != ev->surface->buffer_viewport.scale)
-		pixman_image_set_filter(ps->image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+		filter = PIXMAN_FILTER_BILINEAR;
 	else
-		pixman_image_set_filter(ps->image, PIXMAN_FILTER_NEAREST, NULL, 0);
+		filter = PIXMAN_FILTER_NEAREST;
+	pixman_image_set_filter(ps->image, filter, NULL, 0);
+
+	/* The mask is sampled in the same buffer coordinates as the source */
+	if (ev->chroma_key.enabled)
+		mask = get_chroma_key_mask(ps, ev->chroma_key.color);
+	if (mask) {
+		pixman_image_set_transform(mask, &transform);
+		pixman_image_set_filter(mask, filter, NULL, 0);
+	}
 
 	if (ps->buffer_ref.buffer)
 		wl_shm_buffer_begin_access(ps->buffer_ref.buffer->shm_buffer);
 
 	pixman_image_composite32(pixman_op,
 				 ps->image, /* src */
-				 NULL /* mask */,
+				 mask, /* mask */
 				 po->shadow_image, /* dest */
 				 0, 0, /* src_x, src_y */
 				 0, 0, /* mask_x, mask_y */
@@ -384,13 +491,23 @@ draw_view(struct weston_view *ev, struct weston_output *output,
 	}
 
 	/* TODO: Implement repaint_region_complex() using pixman_composite_trapezoids() */
-	if (ev->transform.enabled &&
-	    ev->transform.matrix.type != WESTON_MATRIX_TRANSFORM_TRANSLATE) {
+	/* Keyed pixels are transparent even in the opaque region */
+	if ((ev->transform.enabled &&
+	     ev->transform.matrix.type != WESTON_MATRIX_TRANSFORM_TRANSLATE) ||
+	    ev->chroma_key.enabled) {
 		repaint_region(ev, output, &repaint, NULL, PIXMAN_OP_OVER);
 	} else {
-		/* blended region is whole surface minus opaque region: */
-		pixman_region32_init_rect(&surface_blend, 0, 0,
-					  ev->surface->width, ev->surface->height);
+		/* blended region is whole surface, or its crop, minus
+		 * opaque region: */
+		if (ev->crop.enabled)
+			pixman_region32_init_rect(&surface_blend,
+						  ev->crop.x, ev->crop.y,
+						  ev->crop.width,
+						  ev->crop.height);
+		else
+			pixman_region32_init_rect(&surface_blend, 0, 0,
+						  ev->surface->width,
+						  ev->surface->height);
 		pixman_region32_subtract(&surface_blend, &surface_blend, &ev->surface->opaque);
 
 		if (pixman_region32_not_empty(&ev->surface->opaque)) {
@@ -414,7 +531,9 @@ repaint_surfaces(struct weston_output *output, pixman_region32_t *damage)
 	struct weston_view *view;
 
 	wl_list_for_each_reverse(view, &compositor->view_list, link)
-		if (view->plane == &compositor->primary_plane)
+		if (view->plane == &compositor->primary_plane &&
+		    view->output_mask & (1 << output->id) &&
+		    !view->cached)
 			draw_view(view, output, damage);
 }
 
@@ -465,7 +584,10 @@ pixman_renderer_repaint_output(struct weston_output *output,
 static void
 pixman_renderer_flush_damage(struct weston_surface *surface)
 {
-	/* No-op for pixman renderer */
+	struct pixman_surface_state *ps = get_surface_state(surface);
+
+	/* Buffer content is used directly, only chroma key mask is cached */
+	ps->chroma_key.dirty = 1;
 }
 
 static void
@@ -492,6 +614,7 @@ pixman_renderer_attach(struct weston_surface *es, struct weston_buffer *buffer)
 	pixman_format_code_t pixman_format;
 
 	weston_buffer_reference(&ps->buffer_ref, buffer);
+	ps->chroma_key.dirty = 1;
 
 	if (ps->buffer_destroy_listener.notify) {
 		wl_list_remove(&ps->buffer_destroy_listener.link);
@@ -562,6 +685,10 @@ pixman_renderer_surface_state_destroy(struct pixman_surface_state *ps)
 		pixman_image_unref(ps->image);
 		ps->image = NULL;
 	}
+	if (ps->chroma_key.mask) {
+		pixman_image_unref(ps->chroma_key.mask);
+		ps->chroma_key.mask = NULL;
+	}
 	weston_buffer_reference(&ps->buffer_ref, NULL);
 	free(ps);
 }
@@ -635,6 +762,17 @@ pixman_renderer_surface_set_color(struct weston_surface *es,
 	ps->image = pixman_image_create_solid_fill(&color);
 }
 
+static void
+pixman_renderer_surface_set_image(struct weston_surface *es,
+				  pixman_image_t *image)
+{
+	struct pixman_surface_state *ps = get_surface_state(es);
+
+	pixman_renderer_attach(es, NULL);
+
+	ps->image = pixman_image_ref(image);
+}
+
 static void
 pixman_renderer_destroy(struct weston_compositor *ec)
 {
@@ -680,10 +818,12 @@ pixman_renderer_init(struct weston_compositor *ec)
 	renderer->repaint_debug = 0;
 	renderer->debug_color = NULL;
 	renderer->base.read_pixels = pixman_renderer_read_pixels;
+	renderer->base.read_surface_pixels = pixman_renderer_read_surface_pixels;
 	renderer->base.repaint_output = pixman_renderer_repaint_output;
 	renderer->base.flush_damage = pixman_renderer_flush_damage;
 	renderer->base.attach = pixman_renderer_attach;
 	renderer->base.surface_set_color = pixman_renderer_surface_set_color;
+	renderer->base.surface_set_image = pixman_renderer_surface_set_image;
 	renderer->base.destroy = pixman_renderer_destroy;
 	ec->renderer = &renderer->base;
 	ec->capabilities |= WESTON_CAP_ROTATION_ANY;
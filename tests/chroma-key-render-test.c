@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * A view with chroma key over a blue view is repainted by the pixman
+ * renderer of the headless backend, see weston-tests-env, and the output
+ * is read back. Keyed pixels show the blue view below.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "../src/compositor.h"
+
+#define KEY		0x0000ff00
+#define OPAQUE_GREEN	(0xff000000 | KEY)
+#define OPAQUE_RED	0xffff0000
+#define BLUE		0x000000ff
+
+/* Odd width to cover both the vectorised part and the tail of a row */
+#define VIEW_X		16
+#define VIEW_Y		8
+#define WIDTH		37
+#define HEIGHT		5
+
+struct render_test {
+	struct weston_compositor *compositor;
+	struct weston_output *output;
+	struct weston_layer layer;
+	struct weston_view *background;
+	struct weston_view *keyed;
+	struct weston_animation animation;
+};
+
+static int
+is_keyed(int x, int y)
+{
+	return (x + y) % 3 == 0;
+}
+
+static void
+check_output(struct weston_animation *animation,
+	     struct weston_output *output, uint32_t msecs)
+{
+	struct render_test *test =
+		container_of(animation, struct render_test, animation);
+	struct weston_compositor *compositor = test->compositor;
+	int width = output->current_mode->width;
+	int height = output->current_mode->height;
+	uint32_t *pixels, pixel;
+	int x, y, row;
+
+	wl_list_remove(&animation->link);
+	wl_list_init(&animation->link);
+
+	pixels = calloc(width * height, sizeof *pixels);
+	assert(pixels);
+	assert(PIXMAN_FORMAT_BPP(compositor->read_format) == 32);
+	assert(compositor->renderer->read_pixels(output,
+						 compositor->read_format,
+						 pixels, 0, 0,
+						 width, height) == 0);
+
+	for (y = -1; y <= HEIGHT; y++) {
+		row = VIEW_Y + y;
+		if (compositor->capabilities & WESTON_CAP_CAPTURE_YFLIP)
+			row = height - 1 - row;
+
+		for (x = -1; x <= WIDTH; x++) {
+			pixel = pixels[row * width + VIEW_X + x] & 0x00ffffff;
+
+			if (x < 0 || x == WIDTH || y < 0 || y == HEIGHT ||
+			    is_keyed(x, y))
+				assert(pixel == BLUE);
+			else
+				assert(pixel == (OPAQUE_RED & 0x00ffffff));
+		}
+	}
+
+	free(pixels);
+
+	weston_surface_destroy(test->keyed->surface);
+	weston_surface_destroy(test->background->surface);
+	wl_list_remove(&test->layer.link);
+	weston_compositor_scene_changed(compositor);
+	free(test);
+
+	wl_display_terminate(compositor->wl_display);
+}
+
+static struct weston_view *
+create_view(struct render_test *test, int x, int y, int width, int height)
+{
+	struct weston_surface *surface;
+	struct weston_view *view;
+
+	surface = weston_surface_create(test->compositor);
+	assert(surface);
+	weston_surface_set_size(surface, width, height);
+	pixman_region32_fini(&surface->opaque);
+	pixman_region32_init_rect(&surface->opaque, 0, 0, width, height);
+
+	view = weston_view_create(surface);
+	assert(view);
+	weston_view_set_position(view, x, y);
+	wl_list_insert(test->layer.view_list.prev, &view->layer_link);
+
+	return view;
+}
+
+static void
+chroma_key_render(void *data)
+{
+	struct weston_compositor *compositor = data;
+	struct render_test *test;
+	pixman_image_t *image;
+	uint32_t *bits;
+	int x, y;
+
+	assert(!wl_list_empty(&compositor->output_list));
+	assert(compositor->renderer->surface_set_image);
+
+	test = calloc(1, sizeof *test);
+	assert(test);
+	test->compositor = compositor;
+	test->output = container_of(compositor->output_list.next,
+				    struct weston_output, link);
+
+	weston_layer_init(&test->layer, &compositor->cursor_layer.link);
+
+	test->keyed = create_view(test, VIEW_X, VIEW_Y, WIDTH, HEIGHT);
+	test->background = create_view(test, 0, 0, test->output->width,
+				       test->output->height);
+	weston_surface_set_color(test->background->surface, 0.0, 0.0, 1.0, 1.0);
+
+	image = pixman_image_create_bits(PIXMAN_a8r8g8b8, WIDTH, HEIGHT,
+					 NULL, 0);
+	assert(image);
+	bits = pixman_image_get_data(image);
+	for (y = 0; y < HEIGHT; y++)
+		for (x = 0; x < WIDTH; x++)
+			bits[y * pixman_image_get_stride(image) / 4 + x] =
+				is_keyed(x, y) ? OPAQUE_GREEN : OPAQUE_RED;
+	compositor->renderer->surface_set_image(test->keyed->surface, image);
+	pixman_image_unref(image);
+
+	test->keyed->chroma_key.enabled = 1;
+	test->keyed->chroma_key.color = KEY;
+	weston_view_geometry_dirty(test->keyed);
+
+	weston_compositor_scene_changed(compositor);
+	weston_surface_damage(test->background->surface);
+	weston_surface_damage(test->keyed->surface);
+
+	test->animation.frame = check_output;
+	wl_list_insert(&test->output->animation_list, &test->animation.link);
+	weston_output_schedule_repaint(test->output);
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct wl_event_loop *loop;
+
+	loop = wl_display_get_event_loop(compositor->wl_display);
+
+	wl_event_loop_add_idle(loop, chroma_key_render, compositor);
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "weston-test-runner.h"
+
+#include "../src/chroma-key.h"
+
+#define KEY		0x0000ff00
+#define OPAQUE_RED	0xffff0000
+
+/* Odd width to cover both the vectorised part and the tail of a row */
+#define WIDTH		37
+#define HEIGHT		5
+#define STRIDE		(WIDTH + 3)
+
+static int
+is_keyed(int x, int y)
+{
+	return (x + y) % 3 == 0;
+}
+
+static void
+fill_source(uint32_t *pixels, int stride)
+{
+	int x, y;
+
+	for (y = 0; y < HEIGHT; y++)
+		for (x = 0; x < WIDTH; x++)
+			/* Alpha byte must not take part in the comparison */
+			pixels[y * stride + x] = is_keyed(x, y) ?
+				(uint32_t) (y << 24) | KEY : OPAQUE_RED;
+}
+
+TEST(chroma_key_mask_keyed_pixels)
+{
+	uint32_t pixels[HEIGHT * STRIDE];
+	uint8_t mask[HEIGHT * STRIDE];
+	int x, y;
+
+	fill_source(pixels, STRIDE);
+	memset(mask, 0x55, sizeof mask);
+
+	chroma_key_mask(mask, STRIDE, pixels, STRIDE * 4,
+			WIDTH, HEIGHT, 0xff000000 | KEY);
+
+	for (y = 0; y < HEIGHT; y++) {
+		for (x = 0; x < WIDTH; x++)
+			assert(mask[y * STRIDE + x] ==
+			       (is_keyed(x, y) ? 0x00 : 0xff));
+
+		/* Padding of the mask is not touched */
+		for (; x < STRIDE; x++)
+			assert(mask[y * STRIDE + x] == 0x55);
+	}
+}
@@ -0,0 +1,461 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Benchmark of weston-layout library. This is loaded as a module of weston
+ * instead of ivi-shell, and drives weston-layout APIs directly against
+ * surfaces and layers created inside of compositor, so that no client is
+ * required. Results are printed to stderr with one line per measurement.
+ *
+ * 1/ lookup: cost of weston_layout_getSurfaceFromId and
+ *    weston_layout_getLayerFromId with 10 to 10,000 registered ids.
+ *    The cost per lookup is expected to stay flat.
+ *
+ * 2/ enumerate: cost of one enumeration of 1,000 surfaces, and of the same
+ *    surfaces added to one layer, with the allocating getters, the getters
+ *    filling a caller-provided array, and the callback style.
+ *
+ * 3/ scene: scenes of N screens x M layers x K surfaces, where N is the
+ *    number of outputs of the backend. Each iteration measures an empty
+ *    commit, a property update of all surfaces with commit, a reversed
+ *    render order of all layers and screens with commit, and the property
+ *    update again with a notification registered to every surface.
+ *
+ * Each line is "<name> key=value ...", so results can be parsed by scripts
+ * and compared between builds.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <time.h>
+
+#include "../src/compositor.h"
+#include "../ivi-shell/weston-layout.h"
+
+#define BENCH_ID_BASE           0x10000000
+#define BENCH_LOOKUP_ITERATIONS 1000000
+#define BENCH_ENUM_SURFACES     1000
+#define BENCH_ENUM_ITERATIONS   10000
+#define BENCH_SCENE_ITERATIONS  100
+#define BENCH_SCENE_SURFACE_SIZE 64
+
+static const uint32_t bench_lookup_counts[] = {
+	10, 100, 1000, 10000
+};
+
+/* layers per screen, surfaces per layer */
+static const struct {
+	uint32_t layers;
+	uint32_t surfaces;
+} bench_scenes[] = {
+	{ 1, 10 }, { 4, 25 }, { 8, 50 }, { 16, 100 }
+};
+
+static double
+bench_elapsed_ns(const struct timespec *begin, const struct timespec *end)
+{
+	return (end->tv_sec - begin->tv_sec) * 1e9 +
+	       (end->tv_nsec - begin->tv_nsec);
+}
+
+static void
+bench_lookup(struct weston_compositor *compositor, uint32_t count)
+{
+	struct weston_surface **surfaces;
+	struct weston_layout_surface **ivisurfs;
+	struct weston_layout_layer **ivilayers;
+	struct timespec begin, end;
+	double surface_ns, layer_ns;
+	uint32_t i, id;
+
+	surfaces = calloc(count, sizeof *surfaces);
+	ivisurfs = calloc(count, sizeof *ivisurfs);
+	ivilayers = calloc(count, sizeof *ivilayers);
+	assert(surfaces && ivisurfs && ivilayers);
+
+	for (i = 0; i < count; i++) {
+		surfaces[i] = weston_surface_create(compositor);
+		assert(surfaces[i]);
+		ivisurfs[i] = weston_layout_surfaceCreate(surfaces[i],
+							  BENCH_ID_BASE + i);
+		assert(ivisurfs[i]);
+		ivilayers[i] =
+			weston_layout_layerCreateWithDimension(BENCH_ID_BASE + i,
+							       100, 100);
+		assert(ivilayers[i]);
+	}
+
+	/* spread accesses over the whole id range */
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_LOOKUP_ITERATIONS; i++) {
+		id = BENCH_ID_BASE + (i * 2654435761u) % count;
+		if (weston_layout_getSurfaceFromId(id) == NULL)
+			assert(0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	surface_ns = bench_elapsed_ns(&begin, &end) / BENCH_LOOKUP_ITERATIONS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_LOOKUP_ITERATIONS; i++) {
+		id = BENCH_ID_BASE + (i * 2654435761u) % count;
+		if (weston_layout_getLayerFromId(id) == NULL)
+			assert(0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	layer_ns = bench_elapsed_ns(&begin, &end) / BENCH_LOOKUP_ITERATIONS;
+
+	fprintf(stderr, "lookup ids=%u surface_ns=%.1f layer_ns=%.1f\n",
+		count, surface_ns, layer_ns);
+
+	for (i = 0; i < count; i++) {
+		weston_surface_destroy(surfaces[i]);
+		weston_layout_surfaceRemove(ivisurfs[i]);
+		weston_layout_layerRemove(ivilayers[i]);
+	}
+
+	free(surfaces);
+	free(ivisurfs);
+	free(ivilayers);
+}
+
+static int32_t
+bench_count_surface(struct weston_layout_surface *ivisurf, void *userdata)
+{
+	uint32_t *count = userdata;
+
+	(*count)++;
+
+	return 0;
+}
+
+static void
+bench_enumerate(struct weston_compositor *compositor)
+{
+	struct weston_surface *surfaces[BENCH_ENUM_SURFACES];
+	struct weston_layout_surface *ivisurfs[BENCH_ENUM_SURFACES];
+	weston_layout_surface_ptr buffer[BENCH_ENUM_SURFACES];
+	weston_layout_surface_ptr *array;
+	struct weston_layout_layer *ivilayer;
+	struct timespec begin, end;
+	double alloc_ns, into_ns, foreach_ns;
+	double layer_alloc_ns, layer_into_ns, layer_foreach_ns;
+	uint32_t i, length, count;
+
+	ivilayer = weston_layout_layerCreateWithDimension(BENCH_ID_BASE,
+							  100, 100);
+	assert(ivilayer);
+
+	for (i = 0; i < BENCH_ENUM_SURFACES; i++) {
+		surfaces[i] = weston_surface_create(compositor);
+		assert(surfaces[i]);
+		ivisurfs[i] = weston_layout_surfaceCreate(surfaces[i],
+							  BENCH_ID_BASE + i);
+		assert(ivisurfs[i]);
+	}
+
+	weston_layout_layerSetRenderOrder(ivilayer, ivisurfs,
+					  BENCH_ENUM_SURFACES);
+	weston_layout_commitChanges();
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_ENUM_ITERATIONS; i++) {
+		if (weston_layout_getSurfaces(&length, &array) != 0)
+			assert(0);
+		free(array);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	alloc_ns = bench_elapsed_ns(&begin, &end) / BENCH_ENUM_ITERATIONS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_ENUM_ITERATIONS; i++) {
+		if (weston_layout_getSurfacesInto(BENCH_ENUM_SURFACES, buffer,
+						  &length) != 0)
+			assert(0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	into_ns = bench_elapsed_ns(&begin, &end) / BENCH_ENUM_ITERATIONS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_ENUM_ITERATIONS; i++) {
+		count = 0;
+		weston_layout_forEachSurface(bench_count_surface, &count);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	foreach_ns = bench_elapsed_ns(&begin, &end) / BENCH_ENUM_ITERATIONS;
+	assert(count == BENCH_ENUM_SURFACES);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_ENUM_ITERATIONS; i++) {
+		if (weston_layout_getSurfacesOnLayer(ivilayer, &length,
+						     &array) != 0)
+			assert(0);
+		free(array);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	layer_alloc_ns = bench_elapsed_ns(&begin, &end) / BENCH_ENUM_ITERATIONS;
+	assert(length == BENCH_ENUM_SURFACES);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_ENUM_ITERATIONS; i++) {
+		if (weston_layout_getSurfacesOnLayerInto(ivilayer,
+							 BENCH_ENUM_SURFACES,
+							 buffer, &length) != 0)
+			assert(0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	layer_into_ns = bench_elapsed_ns(&begin, &end) / BENCH_ENUM_ITERATIONS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_ENUM_ITERATIONS; i++) {
+		count = 0;
+		weston_layout_forEachSurfaceOnLayer(ivilayer,
+						    bench_count_surface,
+						    &count);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	layer_foreach_ns =
+		bench_elapsed_ns(&begin, &end) / BENCH_ENUM_ITERATIONS;
+
+	fprintf(stderr, "enumerate surfaces=%u "
+		"alloc_ns=%.1f into_ns=%.1f foreach_ns=%.1f "
+		"layer_alloc_ns=%.1f layer_into_ns=%.1f layer_foreach_ns=%.1f\n",
+		BENCH_ENUM_SURFACES, alloc_ns, into_ns, foreach_ns,
+		layer_alloc_ns, layer_into_ns, layer_foreach_ns);
+
+	weston_layout_layerRemove(ivilayer);
+	for (i = 0; i < BENCH_ENUM_SURFACES; i++) {
+		weston_surface_destroy(surfaces[i]);
+		weston_layout_surfaceRemove(ivisurfs[i]);
+	}
+}
+
+static void
+bench_notify_surface(struct weston_layout_surface *ivisurf,
+		     struct weston_layout_SurfaceProperties *prop,
+		     enum weston_layout_notification_mask mask,
+		     void *userdata)
+{
+	uint32_t *count = userdata;
+
+	(*count)++;
+}
+
+static void
+bench_set_order(weston_layout_screen_ptr *screens, uint32_t screen_count,
+		struct weston_layout_layer **ivilayers,
+		struct weston_layout_surface **ivisurfs,
+		uint32_t layers, uint32_t surfaces, int reverse)
+{
+	struct weston_layout_layer **order_layers;
+	struct weston_layout_surface **order_surfs;
+	uint32_t n, l, i, j;
+
+	order_layers = calloc(layers, sizeof *order_layers);
+	order_surfs = calloc(surfaces, sizeof *order_surfs);
+	assert(order_layers && order_surfs);
+
+	for (n = 0; n < screen_count; n++) {
+		for (l = 0; l < layers; l++) {
+			j = n * layers + l;
+			for (i = 0; i < surfaces; i++) {
+				order_surfs[i] = reverse ?
+					ivisurfs[j * surfaces + surfaces - 1 - i] :
+					ivisurfs[j * surfaces + i];
+			}
+			weston_layout_layerSetRenderOrder(ivilayers[j],
+							  order_surfs,
+							  surfaces);
+			order_layers[l] = reverse ?
+				ivilayers[n * layers + layers - 1 - l] :
+				ivilayers[j];
+		}
+		weston_layout_screenSetRenderOrder(screens[n], order_layers,
+						   layers);
+	}
+
+	free(order_layers);
+	free(order_surfs);
+}
+
+static void
+bench_update_surfaces(struct weston_layout_surface **ivisurfs,
+		      uint32_t count, uint32_t iteration)
+{
+	int32_t position[2];
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		position[0] = (i * 7 + iteration) % 1000;
+		position[1] = (i * 13 + iteration) % 600;
+		weston_layout_surfaceSetPosition(ivisurfs[i], position);
+		weston_layout_surfaceSetOpacity(ivisurfs[i],
+						(iteration & 1) ? 0.5 : 1.0);
+	}
+}
+
+static void
+bench_scene(struct weston_compositor *compositor, uint32_t layers,
+	    uint32_t surfaces)
+{
+	weston_layout_screen_ptr *screens;
+	struct weston_surface **wl_surfaces;
+	struct weston_layout_surface **ivisurfs;
+	struct weston_layout_layer **ivilayers;
+	struct timespec begin, end;
+	double commit_ns, property_ns, order_ns, notify_ns;
+	uint32_t screen_count, layer_count, surface_count;
+	uint32_t notified = 0;
+	uint32_t i, j;
+
+	if (weston_layout_getScreens(&screen_count, &screens) != 0 ||
+	    screen_count == 0)
+		return;
+
+	layer_count = screen_count * layers;
+	surface_count = layer_count * surfaces;
+
+	wl_surfaces = calloc(surface_count, sizeof *wl_surfaces);
+	ivisurfs = calloc(surface_count, sizeof *ivisurfs);
+	ivilayers = calloc(layer_count, sizeof *ivilayers);
+	assert(wl_surfaces && ivisurfs && ivilayers);
+
+	for (i = 0; i < surface_count; i++) {
+		wl_surfaces[i] = weston_surface_create(compositor);
+		assert(wl_surfaces[i]);
+		weston_surface_set_size(wl_surfaces[i],
+					BENCH_SCENE_SURFACE_SIZE,
+					BENCH_SCENE_SURFACE_SIZE);
+		ivisurfs[i] = weston_layout_surfaceCreate(wl_surfaces[i],
+							  BENCH_ID_BASE + i);
+		assert(ivisurfs[i]);
+		weston_layout_surfaceConfigure(ivisurfs[i],
+					       BENCH_SCENE_SURFACE_SIZE,
+					       BENCH_SCENE_SURFACE_SIZE);
+		weston_layout_surfaceSetDestinationRectangle(ivisurfs[i],
+			0, 0, BENCH_SCENE_SURFACE_SIZE,
+			BENCH_SCENE_SURFACE_SIZE);
+		weston_layout_surfaceSetVisibility(ivisurfs[i], 1);
+	}
+
+	for (j = 0; j < layer_count; j++) {
+		ivilayers[j] =
+			weston_layout_layerCreateWithDimension(BENCH_ID_BASE + j,
+							       1024, 640);
+		assert(ivilayers[j]);
+		weston_layout_layerSetVisibility(ivilayers[j], 1);
+	}
+
+	bench_set_order(screens, screen_count, ivilayers, ivisurfs,
+			layers, surfaces, 0);
+	bench_update_surfaces(ivisurfs, surface_count, 0);
+	weston_layout_commitChanges();
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_SCENE_ITERATIONS; i++)
+		weston_layout_commitChanges();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	commit_ns = bench_elapsed_ns(&begin, &end) / BENCH_SCENE_ITERATIONS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_SCENE_ITERATIONS; i++) {
+		bench_update_surfaces(ivisurfs, surface_count, i + 1);
+		weston_layout_commitChanges();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	property_ns = bench_elapsed_ns(&begin, &end) / BENCH_SCENE_ITERATIONS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_SCENE_ITERATIONS; i++) {
+		bench_set_order(screens, screen_count, ivilayers, ivisurfs,
+				layers, surfaces, !(i & 1));
+		weston_layout_commitChanges();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	order_ns = bench_elapsed_ns(&begin, &end) / BENCH_SCENE_ITERATIONS;
+
+	for (i = 0; i < surface_count; i++)
+		weston_layout_surfaceAddNotification(ivisurfs[i],
+						     bench_notify_surface,
+						     &notified);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_SCENE_ITERATIONS; i++) {
+		bench_update_surfaces(ivisurfs, surface_count, i + 1);
+		weston_layout_commitChanges();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	notify_ns = bench_elapsed_ns(&begin, &end) / BENCH_SCENE_ITERATIONS;
+
+	fprintf(stderr, "scene screens=%u layers=%u surfaces=%u "
+		"commit_ns=%.1f property_ns=%.1f order_ns=%.1f "
+		"notify_ns=%.1f notified=%u\n",
+		screen_count, layer_count, surface_count,
+		commit_ns, property_ns, order_ns, notify_ns,
+		notified / BENCH_SCENE_ITERATIONS);
+
+	for (j = 0; j < layer_count; j++)
+		weston_layout_layerRemove(ivilayers[j]);
+	for (i = 0; i < surface_count; i++) {
+		weston_layout_surfaceRemoveNotification(ivisurfs[i]);
+		weston_surface_destroy(wl_surfaces[i]);
+		weston_layout_surfaceRemove(ivisurfs[i]);
+	}
+	weston_layout_commitChanges();
+
+	free(screens);
+	free(wl_surfaces);
+	free(ivisurfs);
+	free(ivilayers);
+}
+
+static void
+bench_run(void *data)
+{
+	struct weston_compositor *compositor = data;
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_LENGTH(bench_lookup_counts); i++)
+		bench_lookup(compositor, bench_lookup_counts[i]);
+
+	bench_enumerate(compositor);
+
+	for (i = 0; i < ARRAY_LENGTH(bench_scenes); i++)
+		bench_scene(compositor, bench_scenes[i].layers,
+			    bench_scenes[i].surfaces);
+
+	wl_display_terminate(compositor->wl_display);
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct wl_event_loop *loop;
+
+	weston_layout_initWithCompositor(compositor);
+
+	loop = wl_display_get_event_loop(compositor->wl_display);
+
+	wl_event_loop_add_idle(loop, bench_run, compositor);
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Screenshots of weston-layout, taken with the pixman renderer of the
+ * headless backend, see weston-tests-env. An opaque white surface at 50%
+ * opacity is saved at 50% alpha, and at 25% in a layer at 50% opacity.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <cairo.h>
+
+#include "../src/compositor.h"
+#include "../ivi-shell/weston-layout.h"
+
+#define TEST_ID		0x10000000
+#define TEST_SIZE	16
+
+/* alpha of the pixel at the center of a png file */
+static int
+png_alpha(const char *filename)
+{
+	cairo_surface_t *png;
+	uint32_t *pixels;
+	int alpha;
+
+	png = cairo_image_surface_create_from_png(filename);
+	assert(cairo_surface_status(png) == CAIRO_STATUS_SUCCESS);
+	assert(cairo_image_surface_get_width(png) == TEST_SIZE);
+
+	cairo_surface_flush(png);
+	pixels = (uint32_t *)cairo_image_surface_get_data(png);
+	alpha = pixels[TEST_SIZE / 2 * cairo_image_surface_get_stride(png) / 4 +
+		       TEST_SIZE / 2] >> 24;
+
+	cairo_surface_destroy(png);
+	unlink(filename);
+
+	return alpha;
+}
+
+static void
+screenshot_opacity(void *data)
+{
+	struct weston_compositor *compositor = data;
+	struct weston_surface *surface;
+	struct weston_layout_surface *ivisurf;
+	struct weston_layout_layer *ivilayer;
+	pixman_image_t *image;
+	char filename[256];
+	const char *dir;
+	int alpha;
+
+	assert(compositor->renderer->surface_set_image);
+
+	dir = getenv("XDG_RUNTIME_DIR");
+	snprintf(filename, sizeof filename, "%s/ivi-layout-render-test-%d.png",
+		 dir ? dir : "/tmp", getpid());
+
+	surface = weston_surface_create(compositor);
+	assert(surface);
+	image = pixman_image_create_bits(PIXMAN_a8r8g8b8, TEST_SIZE, TEST_SIZE,
+					 NULL, 0);
+	assert(image);
+	memset(pixman_image_get_data(image), 0xff,
+	       pixman_image_get_stride(image) * TEST_SIZE);
+	compositor->renderer->surface_set_image(surface, image);
+	pixman_image_unref(image);
+
+	ivisurf = weston_layout_surfaceCreate(surface, TEST_ID);
+	assert(ivisurf);
+	weston_layout_surfaceConfigure(ivisurf, TEST_SIZE, TEST_SIZE);
+	ivilayer = weston_layout_layerCreateWithDimension(TEST_ID, TEST_SIZE,
+							  TEST_SIZE);
+	assert(ivilayer);
+
+	/* opacity is given in wl_fixed units, as hmi-controller does */
+	weston_layout_surfaceSetVisibility(ivisurf, 1);
+	weston_layout_surfaceSetOpacity(ivisurf, wl_fixed_from_double(0.5));
+	weston_layout_layerSetOpacity(ivilayer, wl_fixed_from_double(0.5));
+	weston_layout_layerAddSurface(ivilayer, ivisurf);
+	weston_layout_commitChanges();
+
+	assert(weston_layout_takeSurfaceScreenshot(filename, ivisurf) == 0);
+	alpha = png_alpha(filename);
+	assert(alpha >= 0x7f && alpha <= 0x80);
+
+	assert(weston_layout_takeLayerScreenshot(filename, ivilayer) == 0);
+	alpha = png_alpha(filename);
+	assert(alpha >= 0x3f && alpha <= 0x40);
+
+	weston_layout_layerRemove(ivilayer);
+	weston_layout_surfaceRemove(ivisurf);
+	weston_surface_destroy(surface);
+
+	wl_display_terminate(compositor->wl_display);
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct wl_event_loop *loop;
+
+	weston_layout_initWithCompositor(compositor);
+
+	loop = wl_display_get_event_loop(compositor->wl_display);
+
+	wl_event_loop_add_idle(loop, screenshot_opacity, compositor);
+
+	return 0;
+}
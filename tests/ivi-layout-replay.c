@@ -0,0 +1,615 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Replay of weston-layout API calls recorded by
+ * weston_layout_startRecording, or by layout-record=<file> in [ivi-shell]
+ * section of weston.ini. This is loaded as a module of weston instead of
+ * ivi-shell, e.g.
+ *
+ *   weston --backend=headless-backend.so \
+ *          --modules=ivi-layout-replay.so --layout-replay=<file>
+ *
+ * Surfaces of clients are replaced by surfaces created inside of
+ * compositor with the recorded size. Calls up to each commit are one step.
+ * A step is replayed after all outputs are repainted for the previous one,
+ * and one line per step is printed to stderr:
+ *
+ *   step=<n> calls=<n> apply_us=<t> commit_us=<t> repaint_us=<t>
+ *
+ * apply_us is the time of calls before the commit, commit_us is the time
+ * of weston_layout_commitChanges, and repaint_us is the sum of repaint of
+ * outputs caused by the commit. A summary line follows the last step.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/compositor.h"
+#include "../ivi-shell/weston-layout.h"
+#include "../ivi-shell/weston-layout-record.h"
+
+struct replay_output {
+	struct weston_output *output;
+	int (*repaint)(struct weston_output *output,
+		       pixman_region32_t *damage);
+	struct wl_list link;
+};
+
+struct replay_surface {
+	uint32_t id_surface;
+	struct weston_surface *surface;
+	struct wl_list link;
+};
+
+struct replay {
+	struct weston_compositor *compositor;
+	struct wl_list output_list;
+	struct wl_list surface_list;
+
+	uint8_t *data;
+	size_t size;
+	size_t offset;
+
+	uint32_t step;
+	uint32_t calls;
+	double apply_us;
+	double commit_us;
+	double repaint_us;
+	uint32_t pending_repaints;
+
+	double total_commit_us;
+	double max_commit_us;
+	double total_repaint_us;
+	double max_repaint_us;
+};
+
+static struct replay *the_replay;
+
+static double
+replay_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static float
+replay_float(uint32_t value)
+{
+	union {
+		float f;
+		uint32_t u;
+	} bits;
+
+	bits.u = value;
+
+	return bits.f;
+}
+
+static struct replay_surface *
+replay_get_surface(struct replay *replay, uint32_t id_surface)
+{
+	struct replay_surface *rsurf;
+
+	wl_list_for_each(rsurf, &replay->surface_list, link)
+		if (rsurf->id_surface == id_surface)
+			return rsurf;
+
+	return NULL;
+}
+
+static struct weston_surface *
+replay_create_surface(struct replay *replay, uint32_t id_surface,
+		      int32_t width, int32_t height)
+{
+	struct replay_surface *rsurf;
+
+	rsurf = replay_get_surface(replay, id_surface);
+	if (rsurf == NULL) {
+		rsurf = zalloc(sizeof *rsurf);
+		if (rsurf == NULL)
+			return NULL;
+		rsurf->id_surface = id_surface;
+		wl_list_insert(&replay->surface_list, &rsurf->link);
+	}
+
+	if (rsurf->surface)
+		weston_surface_destroy(rsurf->surface);
+
+	rsurf->surface = weston_surface_create(replay->compositor);
+	if (rsurf->surface)
+		weston_surface_set_size(rsurf->surface, width, height);
+
+	return rsurf->surface;
+}
+
+static void
+replay_destroy_surface(struct replay *replay, uint32_t id_surface)
+{
+	struct replay_surface *rsurf;
+
+	rsurf = replay_get_surface(replay, id_surface);
+	if (rsurf == NULL)
+		return;
+
+	if (rsurf->surface)
+		weston_surface_destroy(rsurf->surface);
+	wl_list_remove(&rsurf->link);
+	free(rsurf);
+}
+
+static void
+replay_render_order(const uint32_t *args, uint32_t count, int screen)
+{
+	weston_layout_surface_ptr *surfaces;
+	weston_layout_layer_ptr *layers;
+	uint32_t i, n = 0;
+
+	if (screen) {
+		layers = calloc(count, sizeof *layers);
+		for (i = 1; layers && i < count; i++) {
+			layers[n] = weston_layout_getLayerFromId(args[i]);
+			if (layers[n])
+				n++;
+		}
+		weston_layout_screenSetRenderOrder(
+			weston_layout_getScreenFromId(args[0]), layers, n);
+		free(layers);
+	} else {
+		surfaces = calloc(count, sizeof *surfaces);
+		for (i = 1; surfaces && i < count; i++) {
+			surfaces[n] = weston_layout_getSurfaceFromId(args[i]);
+			if (surfaces[n])
+				n++;
+		}
+		weston_layout_layerSetRenderOrder(
+			weston_layout_getLayerFromId(args[0]), surfaces, n);
+		free(surfaces);
+	}
+}
+
+/* minimum number of arguments of each opcode */
+static const uint32_t replay_arg_counts[] = {
+	[WESTON_LAYOUT_RECORD_SURFACE_CREATE] = 1,
+	[WESTON_LAYOUT_RECORD_SURFACE_NATIVE_CONTENT] = 4,
+	[WESTON_LAYOUT_RECORD_SURFACE_CONFIGURE] = 3,
+	[WESTON_LAYOUT_RECORD_SURFACE_REMOVE] = 1,
+	[WESTON_LAYOUT_RECORD_SURFACE_VISIBILITY] = 2,
+	[WESTON_LAYOUT_RECORD_SURFACE_OPACITY] = 2,
+	[WESTON_LAYOUT_RECORD_SURFACE_SOURCE_RECT] = 5,
+	[WESTON_LAYOUT_RECORD_SURFACE_DEST_RECT] = 5,
+	[WESTON_LAYOUT_RECORD_SURFACE_DIMENSION] = 3,
+	[WESTON_LAYOUT_RECORD_SURFACE_POSITION] = 3,
+	[WESTON_LAYOUT_RECORD_SURFACE_ORIENTATION] = 2,
+	[WESTON_LAYOUT_RECORD_SURFACE_CHROMA_KEY] = 5,
+	[WESTON_LAYOUT_RECORD_LAYER_CREATE] = 3,
+	[WESTON_LAYOUT_RECORD_LAYER_REMOVE] = 1,
+	[WESTON_LAYOUT_RECORD_LAYER_VISIBILITY] = 2,
+	[WESTON_LAYOUT_RECORD_LAYER_OPACITY] = 2,
+	[WESTON_LAYOUT_RECORD_LAYER_SOURCE_RECT] = 5,
+	[WESTON_LAYOUT_RECORD_LAYER_DEST_RECT] = 5,
+	[WESTON_LAYOUT_RECORD_LAYER_DIMENSION] = 3,
+	[WESTON_LAYOUT_RECORD_LAYER_POSITION] = 3,
+	[WESTON_LAYOUT_RECORD_LAYER_ORIENTATION] = 2,
+	[WESTON_LAYOUT_RECORD_LAYER_CHROMA_KEY] = 5,
+	[WESTON_LAYOUT_RECORD_LAYER_RENDER_ORDER] = 1,
+	[WESTON_LAYOUT_RECORD_LAYER_RENDER_CACHE] = 2,
+	[WESTON_LAYOUT_RECORD_LAYER_ADD_SURFACE] = 2,
+	[WESTON_LAYOUT_RECORD_LAYER_REMOVE_SURFACE] = 2,
+	[WESTON_LAYOUT_RECORD_SCREEN_ADD_LAYER] = 2,
+	[WESTON_LAYOUT_RECORD_SCREEN_RENDER_ORDER] = 1,
+	[WESTON_LAYOUT_RECORD_SCREEN_OPTIMIZATION] = 3,
+	[WESTON_LAYOUT_RECORD_OPTIMIZATION] = 2,
+	[WESTON_LAYOUT_RECORD_COMMIT] = 0,
+};
+
+/*
+ * Objects which do not exist are passed as NULL, so that weston-layout
+ * rejects the call as it did when recorded.
+ */
+static void
+replay_call(struct replay *replay, uint32_t opcode,
+	    const uint32_t *args, uint32_t count)
+{
+	struct weston_layout_surface *ivisurf = NULL;
+	struct weston_layout_layer *ivilayer = NULL;
+	struct weston_surface *surface;
+	struct weston_view *view;
+	uint32_t color[3];
+	uint32_t dimension[2];
+	int32_t position[2];
+
+	if (opcode >= ARRAY_LENGTH(replay_arg_counts) ||
+	    count < replay_arg_counts[opcode]) {
+		fprintf(stderr, "replay: invalid record of opcode %u\n",
+			opcode);
+		return;
+	}
+
+	if (count > 0 && opcode < WESTON_LAYOUT_RECORD_LAYER_CREATE)
+		ivisurf = weston_layout_getSurfaceFromId(args[0]);
+	else if (count > 0 && opcode < WESTON_LAYOUT_RECORD_SCREEN_ADD_LAYER)
+		ivilayer = weston_layout_getLayerFromId(args[0]);
+
+	switch (opcode) {
+	case WESTON_LAYOUT_RECORD_SURFACE_CREATE:
+		surface = replay_create_surface(replay, args[0], 0, 0);
+		if (surface)
+			weston_layout_surfaceCreate(surface, args[0]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_NATIVE_CONTENT:
+		surface = NULL;
+		if (args[1])
+			surface = replay_create_surface(replay, args[0],
+							args[2], args[3]);
+		weston_layout_surfaceSetNativeContent(surface, args[2],
+						      args[3], args[0]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_CONFIGURE:
+		if (ivisurf == NULL)
+			break;
+		view = weston_layout_get_weston_view(ivisurf);
+		if (view)
+			weston_surface_set_size(view->surface, args[1], args[2]);
+		weston_layout_surfaceConfigure(ivisurf, args[1], args[2]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_REMOVE:
+		weston_layout_surfaceRemove(ivisurf);
+		replay_destroy_surface(replay, args[0]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_VISIBILITY:
+		weston_layout_surfaceSetVisibility(ivisurf, args[1]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_OPACITY:
+		weston_layout_surfaceSetOpacity(ivisurf,
+						replay_float(args[1]));
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_SOURCE_RECT:
+		weston_layout_surfaceSetSourceRectangle(ivisurf, args[1],
+							args[2], args[3],
+							args[4]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_DEST_RECT:
+		weston_layout_surfaceSetDestinationRectangle(ivisurf, args[1],
+							     args[2], args[3],
+							     args[4]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_DIMENSION:
+		dimension[0] = args[1];
+		dimension[1] = args[2];
+		weston_layout_surfaceSetDimension(ivisurf, dimension);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_POSITION:
+		position[0] = args[1];
+		position[1] = args[2];
+		weston_layout_surfaceSetPosition(ivisurf, position);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_ORIENTATION:
+		weston_layout_surfaceSetOrientation(ivisurf, args[1]);
+		break;
+	case WESTON_LAYOUT_RECORD_SURFACE_CHROMA_KEY:
+		memcpy(color, &args[2], sizeof color);
+		weston_layout_surfaceSetChromaKey(ivisurf,
+						  args[1] ? color : NULL);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_CREATE:
+		weston_layout_layerCreateWithDimension(args[0], args[1],
+						       args[2]);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_REMOVE:
+		weston_layout_layerRemove(ivilayer);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_VISIBILITY:
+		weston_layout_layerSetVisibility(ivilayer, args[1]);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_OPACITY:
+		weston_layout_layerSetOpacity(ivilayer, replay_float(args[1]));
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_SOURCE_RECT:
+		weston_layout_layerSetSourceRectangle(ivilayer, args[1],
+						      args[2], args[3],
+						      args[4]);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_DEST_RECT:
+		weston_layout_layerSetDestinationRectangle(ivilayer, args[1],
+							   args[2], args[3],
+							   args[4]);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_DIMENSION:
+		dimension[0] = args[1];
+		dimension[1] = args[2];
+		weston_layout_layerSetDimension(ivilayer, dimension);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_POSITION:
+		position[0] = args[1];
+		position[1] = args[2];
+		weston_layout_layerSetPosition(ivilayer, position);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_ORIENTATION:
+		weston_layout_layerSetOrientation(ivilayer, args[1]);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_CHROMA_KEY:
+		memcpy(color, &args[2], sizeof color);
+		weston_layout_layerSetChromaKey(ivilayer,
+						args[1] ? color : NULL);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_RENDER_ORDER:
+		replay_render_order(args, count, 0);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_RENDER_CACHE:
+		weston_layout_layerSetRenderCache(ivilayer, args[1]);
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_ADD_SURFACE:
+		weston_layout_layerAddSurface(ivilayer,
+			weston_layout_getSurfaceFromId(args[1]));
+		break;
+	case WESTON_LAYOUT_RECORD_LAYER_REMOVE_SURFACE:
+		weston_layout_layerRemoveSurface(ivilayer,
+			weston_layout_getSurfaceFromId(args[1]));
+		break;
+	case WESTON_LAYOUT_RECORD_SCREEN_ADD_LAYER:
+		weston_layout_screenAddLayer(
+			weston_layout_getScreenFromId(args[0]),
+			weston_layout_getLayerFromId(args[1]));
+		break;
+	case WESTON_LAYOUT_RECORD_SCREEN_RENDER_ORDER:
+		replay_render_order(args, count, 1);
+		break;
+	case WESTON_LAYOUT_RECORD_SCREEN_OPTIMIZATION:
+		weston_layout_screenSetOptimizationMode(
+			weston_layout_getScreenFromId(args[0]),
+			args[1], args[2]);
+		break;
+	case WESTON_LAYOUT_RECORD_OPTIMIZATION:
+		weston_layout_SetOptimizationMode(args[0], args[1]);
+		break;
+	case WESTON_LAYOUT_RECORD_COMMIT:
+		weston_layout_commitChanges();
+		break;
+	default:
+		fprintf(stderr, "replay: unknown opcode %u\n", opcode);
+		break;
+	}
+}
+
+static void
+replay_finish(struct replay *replay)
+{
+	uint32_t steps = replay->step > 0 ? replay->step : 1;
+
+	fprintf(stderr, "total steps=%u commit_us_avg=%.1f commit_us_max=%.1f "
+		"repaint_us_avg=%.1f repaint_us_max=%.1f\n",
+		replay->step,
+		replay->total_commit_us / steps, replay->max_commit_us,
+		replay->total_repaint_us / steps, replay->max_repaint_us);
+
+	wl_display_terminate(replay->compositor->wl_display);
+}
+
+static void
+replay_report(struct replay *replay)
+{
+	fprintf(stderr, "step=%u calls=%u apply_us=%.1f commit_us=%.1f "
+		"repaint_us=%.1f\n",
+		replay->step, replay->calls, replay->apply_us,
+		replay->commit_us, replay->repaint_us);
+
+	replay->total_commit_us += replay->commit_us;
+	replay->total_repaint_us += replay->repaint_us;
+	if (replay->commit_us > replay->max_commit_us)
+		replay->max_commit_us = replay->commit_us;
+	if (replay->repaint_us > replay->max_repaint_us)
+		replay->max_repaint_us = replay->repaint_us;
+
+	replay->step++;
+}
+
+static void
+replay_step(void *data);
+
+static void
+replay_schedule_step(struct replay *replay)
+{
+	struct wl_event_loop *loop;
+
+	loop = wl_display_get_event_loop(replay->compositor->wl_display);
+	wl_event_loop_add_idle(loop, replay_step, replay);
+}
+
+/* Replays calls up to next commit */
+static void
+replay_step(void *data)
+{
+	struct replay *replay = data;
+	struct weston_layout_Record record;
+	const uint32_t *args;
+	double begin, end;
+	size_t length;
+
+	replay->calls = 0;
+	replay->apply_us = 0.0;
+	replay->commit_us = 0.0;
+	replay->repaint_us = 0.0;
+
+	while (replay->offset + sizeof record <= replay->size) {
+		memcpy(&record, replay->data + replay->offset, sizeof record);
+		length = sizeof record + record.argCount * sizeof *args;
+		if (replay->offset + length > replay->size) {
+			fprintf(stderr, "replay: truncated record\n");
+			break;
+		}
+		args = (const uint32_t *)(replay->data + replay->offset +
+					  sizeof record);
+		replay->offset += length;
+		replay->calls++;
+
+		begin = replay_now_us();
+		replay_call(replay, record.opcode, args, record.argCount);
+		end = replay_now_us();
+
+		if (record.opcode != WESTON_LAYOUT_RECORD_COMMIT) {
+			replay->apply_us += end - begin;
+			continue;
+		}
+
+		replay->commit_us = end - begin;
+		replay->pending_repaints = wl_list_length(&replay->output_list);
+		if (replay->pending_repaints == 0) {
+			replay_report(replay);
+			replay_schedule_step(replay);
+		}
+		return;
+	}
+
+	replay_finish(replay);
+}
+
+static int
+replay_output_repaint(struct weston_output *output,
+		      pixman_region32_t *damage)
+{
+	struct replay *replay = the_replay;
+	struct replay_output *routput;
+	double begin;
+	int ret = -1;
+
+	wl_list_for_each(routput, &replay->output_list, link) {
+		if (routput->output != output)
+			continue;
+
+		begin = replay_now_us();
+		ret = routput->repaint(output, damage);
+		replay->repaint_us += replay_now_us() - begin;
+		break;
+	}
+
+	if (replay->pending_repaints > 0 && --replay->pending_repaints == 0) {
+		replay_report(replay);
+		replay_schedule_step(replay);
+	}
+
+	return ret;
+}
+
+static int
+replay_load(struct replay *replay, const char *filename)
+{
+	struct weston_layout_RecordHeader header;
+	FILE *fp;
+	long size;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		weston_log("replay: fails to open %s\n", filename);
+		return -1;
+	}
+
+	if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 ||
+	    fseek(fp, 0, SEEK_SET) != 0) {
+		fclose(fp);
+		return -1;
+	}
+
+	replay->data = malloc(size);
+	if (replay->data == NULL ||
+	    fread(replay->data, 1, size, fp) != (size_t)size) {
+		weston_log("replay: fails to read %s\n", filename);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	replay->size = size;
+	if (replay->size < sizeof header) {
+		weston_log("replay: %s is not a recording\n", filename);
+		return -1;
+	}
+
+	memcpy(&header, replay->data, sizeof header);
+	if (header.magic != WESTON_LAYOUT_RECORD_MAGIC ||
+	    header.version != WESTON_LAYOUT_RECORD_VERSION) {
+		weston_log("replay: %s is not a recording of version %d\n",
+			   filename, WESTON_LAYOUT_RECORD_VERSION);
+		return -1;
+	}
+	replay->offset = sizeof header;
+
+	return 0;
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct replay *replay;
+	struct replay_output *routput;
+	struct weston_output *output;
+	char *filename = NULL;
+
+	const struct weston_option replay_options[] = {
+		{ WESTON_OPTION_STRING, "layout-replay", 0, &filename },
+	};
+
+	parse_options(replay_options, ARRAY_LENGTH(replay_options), argc, argv);
+
+	if (filename == NULL) {
+		weston_log("replay: --layout-replay=<file> is required\n");
+		return -1;
+	}
+
+	replay = zalloc(sizeof *replay);
+	if (replay == NULL)
+		return -1;
+
+	replay->compositor = compositor;
+	wl_list_init(&replay->output_list);
+	wl_list_init(&replay->surface_list);
+
+	if (replay_load(replay, filename) < 0) {
+		free(filename);
+		free(replay->data);
+		free(replay);
+		return -1;
+	}
+	free(filename);
+
+	weston_layout_initWithCompositor(compositor);
+
+	wl_list_for_each(output, &compositor->output_list, link) {
+		routput = zalloc(sizeof *routput);
+		if (routput == NULL)
+			return -1;
+		routput->output = output;
+		routput->repaint = output->repaint;
+		output->repaint = replay_output_repaint;
+		wl_list_insert(&replay->output_list, &routput->link);
+	}
+
+	the_replay = replay;
+	replay_schedule_step(replay);
+
+	return 0;
+}
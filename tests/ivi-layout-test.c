@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Tests of weston-layout library. This is loaded as a module of weston
+ * instead of ivi-shell like ivi-layout-bench, and drives weston-layout
+ * APIs against surfaces created inside of compositor.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "../src/compositor.h"
+#include "../ivi-shell/weston-layout.h"
+
+#define TEST_ID_BASE	0x10000000
+#define TEST_SIZE	64
+
+struct test_surface {
+	struct weston_surface *surface;
+	struct weston_layout_surface *ivisurf;
+};
+
+static void
+create_surface(struct weston_compositor *compositor, uint32_t id,
+	       struct test_surface *surf)
+{
+	surf->surface = weston_surface_create(compositor);
+	assert(surf->surface);
+	surf->ivisurf = weston_layout_surfaceCreate(surf->surface, id);
+	assert(surf->ivisurf);
+	weston_layout_surfaceConfigure(surf->ivisurf, TEST_SIZE, TEST_SIZE);
+}
+
+static void
+destroy_surface(struct test_surface *surf)
+{
+	weston_layout_surfaceRemove(surf->ivisurf);
+	weston_surface_destroy(surf->surface);
+}
+
+static struct weston_layout_layer *
+create_layer(uint32_t id)
+{
+	struct weston_layout_layer *ivilayer;
+	weston_layout_screen_ptr *screens;
+	uint32_t length;
+
+	ivilayer = weston_layout_layerCreateWithDimension(id, TEST_SIZE,
+							  TEST_SIZE);
+	assert(ivilayer);
+
+	assert(weston_layout_getScreens(&length, &screens) == 0);
+	if (length > 0) {
+		weston_layout_screenAddLayer(screens[0], ivilayer);
+		free(screens);
+	}
+
+	return ivilayer;
+}
+
+static uint32_t
+count_layers_under_surface(struct weston_layout_surface *ivisurf)
+{
+	weston_layout_layer_ptr *layers = NULL;
+	uint32_t length;
+
+	assert(weston_layout_getLayersUnderSurface(ivisurf, &length,
+						   &layers) == 0);
+	if (length > 0)
+		free(layers);
+
+	return length;
+}
+
+/* A surface outlives its layer, in render order or only pending. */
+static void
+layer_remove_then_commit_surface(struct weston_compositor *compositor)
+{
+	struct test_surface committed, pending;
+	struct weston_layout_layer *ivilayer;
+
+	create_surface(compositor, TEST_ID_BASE, &committed);
+	create_surface(compositor, TEST_ID_BASE + 1, &pending);
+	ivilayer = create_layer(TEST_ID_BASE);
+
+	weston_layout_layerAddSurface(ivilayer, committed.ivisurf);
+	weston_layout_commitChanges();
+	assert(count_layers_under_surface(committed.ivisurf) == 1);
+
+	weston_layout_layerAddSurface(ivilayer, pending.ivisurf);
+	weston_layout_layerRemove(ivilayer);
+	assert(count_layers_under_surface(committed.ivisurf) == 0);
+	assert(count_layers_under_surface(pending.ivisurf) == 0);
+
+	weston_layout_surfaceSetOpacity(committed.ivisurf,
+					wl_fixed_from_double(0.5));
+	weston_layout_surfaceSetVisibility(pending.ivisurf, 1);
+	weston_layout_commitChanges();
+
+	/* both can be added to another layer */
+	ivilayer = create_layer(TEST_ID_BASE + 1);
+	weston_layout_layerAddSurface(ivilayer, committed.ivisurf);
+	weston_layout_layerAddSurface(ivilayer, pending.ivisurf);
+	weston_layout_commitChanges();
+	assert(count_layers_under_surface(committed.ivisurf) == 1);
+	assert(count_layers_under_surface(pending.ivisurf) == 1);
+
+	weston_layout_layerRemove(ivilayer);
+	destroy_surface(&committed);
+	destroy_surface(&pending);
+	weston_layout_commitChanges();
+}
+
+/*
+ * wl_surface.commit of a former member of a removed layer, which
+ * invalidates render cache of layers of the surface.
+ */
+static void
+layer_remove_then_surface_commit(struct weston_compositor *compositor)
+{
+	struct test_surface surf;
+	struct weston_layout_layer *ivilayer;
+
+	create_surface(compositor, TEST_ID_BASE, &surf);
+	ivilayer = create_layer(TEST_ID_BASE);
+	weston_layout_layerSetRenderCache(ivilayer, 1);
+	weston_layout_layerAddSurface(ivilayer, surf.ivisurf);
+	weston_layout_commitChanges();
+
+	weston_layout_layerRemove(ivilayer);
+
+	/* as weston_surface_commit does at the end */
+	wl_signal_emit(&surf.surface->commit_signal, surf.surface);
+
+	/* and when the client destroys wl_surface */
+	weston_layout_surfaceSetNativeContent(NULL, 0, 0, TEST_ID_BASE);
+	weston_layout_commitChanges();
+
+	destroy_surface(&surf);
+}
+
+struct commit_counter {
+	uint32_t count;
+	/* unregistered by the callback */
+	struct commit_counter *other;
+};
+
+static void
+count_commit(const struct weston_layout_ChangeEntry *pEntry,
+	     uint32_t length, void *userdata)
+{
+	struct commit_counter *counter = userdata;
+
+	counter->count++;
+
+	if (counter->other != NULL) {
+		weston_layout_removeNotificationCommit(count_commit,
+						       counter->other);
+		free(counter->other);
+		counter->other = NULL;
+	}
+}
+
+/* A commit callback unregisters the next one during delivery. */
+static void
+commit_notification_remove_other(struct weston_compositor *compositor)
+{
+	struct test_surface surf;
+	struct commit_counter first = { 0 }, *second, third = { 0 };
+
+	second = calloc(1, sizeof *second);
+	assert(second);
+	first.other = second;
+
+	create_surface(compositor, TEST_ID_BASE, &surf);
+	weston_layout_setNotificationCommit(IVI_NOTIFICATION_ALL, count_commit,
+					    &first);
+	weston_layout_setNotificationCommit(IVI_NOTIFICATION_ALL, count_commit,
+					    second);
+	weston_layout_setNotificationCommit(IVI_NOTIFICATION_ALL, count_commit,
+					    &third);
+
+	weston_layout_surfaceSetOpacity(surf.ivisurf,
+					wl_fixed_from_double(0.5));
+	weston_layout_commitChanges();
+	assert(first.count == 1);
+	assert(third.count == 1);
+
+	weston_layout_surfaceSetOpacity(surf.ivisurf,
+					wl_fixed_from_double(1.0));
+	weston_layout_commitChanges();
+	assert(first.count == 2);
+	assert(third.count == 2);
+
+	weston_layout_removeNotificationCommit(count_commit, &first);
+	weston_layout_removeNotificationCommit(count_commit, &third);
+	destroy_surface(&surf);
+}
+
+static void
+run_tests(void *data)
+{
+	struct weston_compositor *compositor = data;
+
+	layer_remove_then_commit_surface(compositor);
+	layer_remove_then_surface_commit(compositor);
+	commit_notification_remove_other(compositor);
+
+	wl_display_terminate(compositor->wl_display);
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct wl_event_loop *loop;
+
+	weston_layout_initWithCompositor(compositor);
+
+	loop = wl_display_get_event_loop(compositor->wl_display);
+
+	wl_event_loop_add_idle(loop, run_tests, compositor);
+
+	return 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Benchmark of pointer picking, loaded as a module of weston. For N views
+ * spread over the first output, it measures pointer motion events going
+ * through the default grab, both jumping between points spread over the
+ * output and moving one pixel at a time like a high-rate mouse, the repick
+ * done for every seat after a repaint, and weston_compositor_pick_view()
+ * called directly. No client is required.
+ *
+ * Each line is "pick views=N motions_per_sec=... steps_per_sec=...
+ * repick_ns=... pick_ns=...", so results can be compared between builds.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <time.h>
+
+#include "../src/compositor.h"
+
+#define BENCH_VIEW_SIZE   64
+#define BENCH_MOTIONS     200000
+#define BENCH_REPICKS     1000000
+#define BENCH_PICKS       1000000
+
+static const uint32_t bench_view_counts[] = {
+	10, 100, 500, 1000
+};
+
+struct pick_bench {
+	struct weston_compositor *compositor;
+	struct weston_output *output;
+	struct weston_seat seat;
+	struct weston_layer layer;
+	struct weston_animation animation;
+	struct weston_surface **surfaces;
+	uint32_t count;
+	uint32_t step;
+};
+
+static double
+bench_elapsed_ns(const struct timespec *begin, const struct timespec *end)
+{
+	return (end->tv_sec - begin->tv_sec) * 1e9 +
+	       (end->tv_nsec - begin->tv_nsec);
+}
+
+/* deterministic points, so that builds can be compared */
+static void
+bench_point(struct weston_output *output, uint32_t i, int32_t *x, int32_t *y)
+{
+	uint32_t r = i * 2654435761u;
+
+	*x = output->x + (r >> 8) % output->width;
+	*y = output->y + (r >> 20) % output->height;
+}
+
+static void
+bench_create_views(struct pick_bench *bench)
+{
+	struct weston_surface *surface;
+	struct weston_view *view;
+	int32_t x, y;
+	uint32_t i;
+
+	bench->surfaces = calloc(bench->count, sizeof *bench->surfaces);
+	assert(bench->surfaces);
+
+	for (i = 0; i < bench->count; i++) {
+		surface = weston_surface_create(bench->compositor);
+		assert(surface);
+		weston_surface_set_size(surface, BENCH_VIEW_SIZE,
+					BENCH_VIEW_SIZE);
+		pixman_region32_fini(&surface->input);
+		pixman_region32_init_rect(&surface->input, 0, 0,
+					  BENCH_VIEW_SIZE, BENCH_VIEW_SIZE);
+
+		view = weston_view_create(surface);
+		assert(view);
+		bench_point(bench->output, i + 1, &x, &y);
+		weston_view_set_position(view, x - BENCH_VIEW_SIZE / 2,
+					 y - BENCH_VIEW_SIZE / 2);
+		wl_list_insert(bench->layer.view_list.prev, &view->layer_link);
+
+		bench->surfaces[i] = surface;
+	}
+
+	weston_compositor_scene_changed(bench->compositor);
+}
+
+static void
+bench_destroy_views(struct pick_bench *bench)
+{
+	uint32_t i;
+
+	for (i = 0; i < bench->count; i++)
+		weston_surface_destroy(bench->surfaces[i]);
+
+	free(bench->surfaces);
+	bench->surfaces = NULL;
+}
+
+static void
+bench_measure(struct pick_bench *bench)
+{
+	struct weston_pointer *pointer = bench->seat.pointer;
+	struct weston_view *view;
+	struct timespec begin, end;
+	double motion_ns, step_ns, repick_ns, pick_ns;
+	wl_fixed_t vx, vy;
+	int32_t x, y;
+	uint32_t i, picked = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_MOTIONS; i++) {
+		bench_point(bench->output, i, &x, &y);
+		notify_motion(&bench->seat, i,
+			      wl_fixed_from_int(x) - pointer->x,
+			      wl_fixed_from_int(y) - pointer->y);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	motion_ns = bench_elapsed_ns(&begin, &end);
+
+	/* row by row over the output, one pixel per event */
+	bench_point(bench->output, 0, &x, &y);
+	notify_motion(&bench->seat, 0,
+		      wl_fixed_from_int(x) - pointer->x,
+		      wl_fixed_from_int(y) - pointer->y);
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_MOTIONS; i++) {
+		if (wl_fixed_to_int(pointer->x) + 1 <
+		    bench->output->x + bench->output->width)
+			notify_motion(&bench->seat, i,
+				      wl_fixed_from_int(1), 0);
+		else
+			notify_motion(&bench->seat, i,
+				      wl_fixed_from_int(bench->output->x) -
+				      pointer->x, wl_fixed_from_int(1));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	step_ns = bench_elapsed_ns(&begin, &end);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_REPICKS; i++)
+		weston_seat_repick(&bench->seat);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	repick_ns = bench_elapsed_ns(&begin, &end) / BENCH_REPICKS;
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (i = 0; i < BENCH_PICKS; i++) {
+		bench_point(bench->output, i, &x, &y);
+		view = weston_compositor_pick_view(bench->compositor,
+						   wl_fixed_from_int(x),
+						   wl_fixed_from_int(y),
+						   &vx, &vy);
+		if (view)
+			picked++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	pick_ns = bench_elapsed_ns(&begin, &end) / BENCH_PICKS;
+
+	fprintf(stderr, "pick views=%u motions_per_sec=%.0f "
+		"steps_per_sec=%.0f repick_ns=%.1f pick_ns=%.1f "
+		"hit_ratio=%.2f\n",
+		bench->count, BENCH_MOTIONS * 1e9 / motion_ns,
+		BENCH_MOTIONS * 1e9 / step_ns, repick_ns, pick_ns,
+		(double) picked / BENCH_PICKS);
+}
+
+static void
+bench_next(void *data);
+
+/* Runs after the repaint, once view_list holds the views of the step. */
+static void
+bench_frame(struct weston_animation *animation,
+	    struct weston_output *output, uint32_t msecs)
+{
+	struct pick_bench *bench =
+		container_of(animation, struct pick_bench, animation);
+	struct wl_event_loop *loop;
+
+	wl_list_remove(&animation->link);
+	wl_list_init(&animation->link);
+
+	bench_measure(bench);
+	bench_destroy_views(bench);
+
+	loop = wl_display_get_event_loop(bench->compositor->wl_display);
+	wl_event_loop_add_idle(loop, bench_next, bench);
+}
+
+static void
+bench_next(void *data)
+{
+	struct pick_bench *bench = data;
+
+	if (bench->step == ARRAY_LENGTH(bench_view_counts)) {
+		wl_list_remove(&bench->layer.link);
+		weston_compositor_scene_changed(bench->compositor);
+		weston_seat_release(&bench->seat);
+		wl_display_terminate(bench->compositor->wl_display);
+		free(bench);
+		return;
+	}
+
+	bench->count = bench_view_counts[bench->step++];
+	bench_create_views(bench);
+
+	bench->animation.frame = bench_frame;
+	wl_list_insert(&bench->output->animation_list,
+		       &bench->animation.link);
+	weston_output_schedule_repaint(bench->output);
+}
+
+static void
+bench_run(void *data)
+{
+	struct weston_compositor *compositor = data;
+	struct pick_bench *bench;
+
+	if (wl_list_empty(&compositor->output_list)) {
+		fprintf(stderr, "pick-bench: no output\n");
+		wl_display_terminate(compositor->wl_display);
+		return;
+	}
+
+	bench = calloc(1, sizeof *bench);
+	assert(bench);
+
+	bench->compositor = compositor;
+	bench->output = container_of(compositor->output_list.next,
+				     struct weston_output, link);
+	wl_list_init(&bench->animation.link);
+
+	weston_seat_init(&bench->seat, compositor, "pick-bench");
+	weston_seat_init_pointer(&bench->seat);
+	assert(bench->seat.pointer);
+
+	weston_layer_init(&bench->layer, &compositor->cursor_layer.link);
+
+	bench_next(bench);
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct wl_event_loop *loop;
+
+	loop = wl_display_get_event_loop(compositor->wl_display);
+
+	wl_event_loop_add_idle(loop, bench_run, compositor);
+
+	return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2014 DENSO CORPORATION
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and
+ * its documentation for any purpose is hereby granted without fee, provided
+ * that the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the copyright holders not be used in
+ * advertising or publicity pertaining to distribution of the software
+ * without specific, written prior permission.  The copyright holders make
+ * no representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/**
+ * Benchmark of input-to-photon latency, loaded as a module of weston with
+ * the headless backend, whose vblank clock is simulated. A thread writes
+ * events at pseudo-random times to a pipe read from the input loop of the
+ * compositor, like an input device, and each one is a pointer motion which
+ * moves a view through a pointer grab. An event is shown at the vblank
+ * following the repaint that picked it up, which is the latency measured
+ * here, from the time it was written.
+ *
+ * The same sequence of events is run with the repaint window disabled and
+ * with [core] repaint-window, or BENCH_WINDOW_MSEC if it is not set. Each
+ * line is "repaint window_ms=W inputs=N latency_avg_ms=... latency_max_ms=...
+ * frames=...", so results can be compared between builds.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "../src/compositor.h"
+
+#define BENCH_INPUTS       1000
+#define BENCH_WINDOW_MSEC  7
+#define BENCH_VIEW_SIZE    64
+
+struct repaint_bench {
+	struct weston_compositor *compositor;
+	struct weston_output *output;
+	struct weston_layer layer;
+	struct weston_surface *surface;
+	struct weston_view *view;
+	struct weston_animation animation;
+	struct weston_seat seat;
+	struct weston_pointer_grab grab;
+
+	/* written by input_thread, read from the input loop */
+	int input_fd[2];
+	struct wl_event_source *input_source;
+	pthread_t input_thread;
+
+	int32_t saved_window;
+	int32_t windows[2];
+	uint32_t step;
+
+	uint32_t inputs;
+	uint32_t frames;
+	struct wl_array pending;	/* uint64_t, time of input in us */
+	double latency_sum;
+	double latency_max;
+};
+
+static uint64_t
+bench_get_time_usec(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* 1 to 12 ms between events like a moving pointer, which keeps the
+ * repaint loop running. The same sequence is used for every step. */
+static uint32_t
+bench_input_interval(uint32_t i)
+{
+	return 1 + (i * 2654435761u >> 16) % 12;
+}
+
+/* The input device, writing the time of each event. */
+static void *
+bench_input_thread(void *data)
+{
+	struct repaint_bench *bench = data;
+	struct timespec interval;
+	uint64_t input;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_INPUTS; i++) {
+		interval.tv_sec = 0;
+		interval.tv_nsec = bench_input_interval(i) * 1000000L;
+		while (nanosleep(&interval, &interval) < 0 && errno == EINTR)
+			;
+
+		input = bench_get_time_usec();
+		if (write(bench->input_fd[1], &input, sizeof input) !=
+		    sizeof input)
+			break;
+	}
+
+	return NULL;
+}
+
+static void
+bench_start_step(struct repaint_bench *bench);
+
+/* Runs at the end of every repaint. The inputs received so far are on
+ * screen at the next vblank after now.
+ */
+static void
+bench_frame(struct weston_animation *animation,
+	    struct weston_output *output, uint32_t msecs)
+{
+	struct repaint_bench *bench =
+		container_of(animation, struct repaint_bench, animation);
+	uint64_t now, period, *input;
+	int64_t since_vblank, photon;
+	double latency;
+
+	if (bench->pending.size == 0)
+		return;
+
+	bench->frames++;
+
+	/* frame_time is the vblank that passed, in ms */
+	now = bench_get_time_usec();
+	period = 1000000000ULL / output->current_mode->refresh;
+	since_vblank = (int32_t) ((uint32_t) (now / 1000) - output->frame_time) *
+		1000 + now % 1000;
+	photon = now + period - since_vblank % period;
+
+	wl_array_for_each(input, &bench->pending) {
+		latency = (photon - *input) / 1000.0;
+		bench->latency_sum += latency;
+		if (latency > bench->latency_max)
+			bench->latency_max = latency;
+	}
+	bench->pending.size = 0;
+
+	if (bench->inputs < BENCH_INPUTS)
+		return;
+
+	pthread_join(bench->input_thread, NULL);
+
+	fprintf(stderr, "repaint window_ms=%d inputs=%u latency_avg_ms=%.2f "
+		"latency_max_ms=%.2f frames=%u\n",
+		bench->compositor->repaint_msec, bench->inputs,
+		bench->latency_sum / bench->inputs, bench->latency_max,
+		bench->frames);
+
+	bench_start_step(bench);
+}
+
+static void
+bench_grab_focus(struct weston_pointer_grab *grab)
+{
+}
+
+/* The view follows the pointer. */
+static void
+bench_grab_motion(struct weston_pointer_grab *grab, uint32_t time,
+		  wl_fixed_t x, wl_fixed_t y)
+{
+	struct repaint_bench *bench =
+		container_of(grab, struct repaint_bench, grab);
+	struct weston_pointer *pointer = grab->pointer;
+
+	weston_pointer_move(pointer, x, y);
+	weston_view_set_position(bench->view, wl_fixed_to_int(pointer->x),
+				 wl_fixed_to_int(pointer->y));
+	weston_view_schedule_repaint(bench->view);
+}
+
+static void
+bench_grab_button(struct weston_pointer_grab *grab,
+		  uint32_t time, uint32_t button, uint32_t state)
+{
+}
+
+static void
+bench_grab_cancel(struct weston_pointer_grab *grab)
+{
+}
+
+static const struct weston_pointer_grab_interface bench_grab_interface = {
+	bench_grab_focus,
+	bench_grab_motion,
+	bench_grab_button,
+	bench_grab_cancel,
+};
+
+static int
+bench_input(int fd, uint32_t mask, void *data)
+{
+	struct repaint_bench *bench = data;
+	struct weston_pointer *pointer = bench->seat.pointer;
+	uint64_t event, *input;
+	wl_fixed_t dx;
+
+	while (read(fd, &event, sizeof event) == sizeof event) {
+		input = wl_array_add(&bench->pending, sizeof *input);
+		assert(input);
+		*input = event;
+
+		/* back and forth, so that the pointer stays on the output */
+		dx = wl_fixed_to_int(pointer->x) + 1 <
+			bench->output->x + bench->output->width ?
+			wl_fixed_from_int(1) : -pointer->x;
+		notify_motion(&bench->seat, event / 1000, dx, 0);
+
+		bench->inputs++;
+	}
+
+	return 1;
+}
+
+static void
+bench_finish(struct repaint_bench *bench)
+{
+	bench->compositor->repaint_msec = bench->saved_window;
+
+	wl_list_remove(&bench->animation.link);
+	wl_event_source_remove(bench->input_source);
+	close(bench->input_fd[0]);
+	close(bench->input_fd[1]);
+	weston_pointer_end_grab(bench->seat.pointer);
+	weston_seat_release(&bench->seat);
+	weston_surface_destroy(bench->surface);
+	wl_list_remove(&bench->layer.link);
+	weston_compositor_scene_changed(bench->compositor);
+	wl_array_release(&bench->pending);
+
+	wl_display_terminate(bench->compositor->wl_display);
+	free(bench);
+}
+
+static void
+bench_start_step(struct repaint_bench *bench)
+{
+	if (bench->step == ARRAY_LENGTH(bench->windows)) {
+		bench_finish(bench);
+		return;
+	}
+
+	bench->compositor->repaint_msec = bench->windows[bench->step++];
+	bench->inputs = 0;
+	bench->frames = 0;
+	bench->latency_sum = 0;
+	bench->latency_max = 0;
+	notify_motion(&bench->seat, 0,
+		      wl_fixed_from_int(bench->output->x) -
+		      bench->seat.pointer->x,
+		      wl_fixed_from_int(bench->output->y) -
+		      bench->seat.pointer->y);
+
+	if (pthread_create(&bench->input_thread, NULL,
+			   bench_input_thread, bench) != 0) {
+		fprintf(stderr, "repaint-bench: no input thread\n");
+		bench->step = ARRAY_LENGTH(bench->windows);
+		bench_finish(bench);
+		return;
+	}
+}
+
+static void
+bench_run(void *data)
+{
+	struct weston_compositor *compositor = data;
+	struct repaint_bench *bench;
+
+	if (wl_list_empty(&compositor->output_list)) {
+		fprintf(stderr, "repaint-bench: no output\n");
+		wl_display_terminate(compositor->wl_display);
+		return;
+	}
+
+	bench = calloc(1, sizeof *bench);
+	assert(bench);
+
+	/* read like an input device, only from the input loop */
+	if (pipe(bench->input_fd) < 0) {
+		fprintf(stderr, "repaint-bench: no pipe\n");
+		wl_display_terminate(compositor->wl_display);
+		free(bench);
+		return;
+	}
+	fcntl(bench->input_fd[0], F_SETFL, O_NONBLOCK);
+	bench->input_source =
+		wl_event_loop_add_fd(compositor->input_loop,
+				     bench->input_fd[0], WL_EVENT_READABLE,
+				     bench_input, bench);
+	assert(bench->input_source);
+
+	bench->compositor = compositor;
+	bench->output = container_of(compositor->output_list.next,
+				     struct weston_output, link);
+	wl_array_init(&bench->pending);
+
+	bench->saved_window = compositor->repaint_msec;
+	bench->windows[0] = 0;
+	bench->windows[1] = compositor->repaint_msec > 0 ?
+		compositor->repaint_msec : BENCH_WINDOW_MSEC;
+
+	bench->surface = weston_surface_create(compositor);
+	assert(bench->surface);
+	weston_surface_set_size(bench->surface, BENCH_VIEW_SIZE,
+				BENCH_VIEW_SIZE);
+	bench->view = weston_view_create(bench->surface);
+	assert(bench->view);
+
+	weston_layer_init(&bench->layer, &compositor->cursor_layer.link);
+	wl_list_insert(&bench->layer.view_list, &bench->view->layer_link);
+	weston_compositor_scene_changed(compositor);
+
+	bench->animation.frame = bench_frame;
+	wl_list_insert(&bench->output->animation_list,
+		       &bench->animation.link);
+
+	weston_seat_init(&bench->seat, compositor, "repaint-bench");
+	weston_seat_init_pointer(&bench->seat);
+	assert(bench->seat.pointer);
+	bench->grab.interface = &bench_grab_interface;
+	weston_pointer_start_grab(bench->seat.pointer, &bench->grab);
+
+	bench_start_step(bench);
+}
+
+WL_EXPORT int
+module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+	struct wl_event_loop *loop;
+
+	loop = wl_display_get_event_loop(compositor->wl_display);
+
+	wl_event_loop_add_idle(loop, bench_run, compositor);
+
+	return 0;
+}